@@ -0,0 +1,105 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+
+#include "ahrs.h"
+
+#include "attitude_estimator.h"
+#include "latency.h"
+#include "types.h"
+
+LOG_MODULE_REGISTER(attitude_estimator);
+
+ZBUS_OBS_DECLARE(logger_sub);
+
+ZBUS_CHAN_DECLARE(imu_filtered_chan);
+
+ZBUS_CHAN_DEFINE(attitude_chan, struct attitude_data, NULL, NULL,
+                 ZBUS_OBSERVERS(logger_sub), {0});
+
+ZBUS_SUBSCRIBER_DEFINE_WITH_ENABLE(attitude_estimator_sub, 16, false);
+
+// Samples further apart than this are treated as a gap in the IMU stream
+#define MAX_SAMPLE_INTERVAL_US (5 * 1000000 / CONFIG_APP_IMU_RATE_HZ)
+
+static AHRS_Inst_Type ahrs;
+
+void attitude_estimator(void *dummy1, void *dummy2, void *dummy3) {
+    ARG_UNUSED(dummy1);
+    ARG_UNUSED(dummy2);
+    ARG_UNUSED(dummy3);
+
+    const AHRS_Config_Type ahrs_cfg = {
+        .kp = CONFIG_APP_AHRS_KP / 1000.0f,
+        .ki = CONFIG_APP_AHRS_KI / 1000.0f,
+    };
+
+    if (AHRS_Init(&ahrs, &ahrs_cfg) != AHRS_SUCCESS) {
+        LOG_ERR("Could not initialize the attitude estimator!");
+        return;
+    }
+
+    uint64_t prev_timestamp_us = 0;
+
+    zbus_obs_set_enable(&attitude_estimator_sub, true);
+
+    while (true) {
+        const struct zbus_channel *chan;
+        int ret = zbus_sub_wait(&attitude_estimator_sub, &chan, K_FOREVER);
+        if (ret < 0) {
+            LOG_ERR("Could not wait on the attitude estimator subscriber, "
+                    "aborting.");
+            return;
+        }
+
+        if (chan != &imu_filtered_chan) {
+            continue;
+        }
+
+        struct imu_6dof_data imu;
+        ret = zbus_chan_read(chan, &imu, K_USEC(1));
+        if (ret < 0) {
+            LOG_ERR("Failed to read from attitude estimator subscriber!");
+            continue;
+        }
+
+        uint64_t dt_us = imu.timestamp_us - prev_timestamp_us;
+        if (prev_timestamp_us == 0 || dt_us > MAX_SAMPLE_INTERVAL_US) {
+            dt_us = 1000000 / CONFIG_APP_IMU_RATE_HZ;
+        }
+        prev_timestamp_us = imu.timestamp_us;
+
+        AHRS_Update(&ahrs, imu.gyro_radps, imu.accel_mps2, dt_us * 1e-6f);
+
+        latency_record(LATENCY_STAGE_ATTITUDE, imu.origin_cycles);
+
+        const struct attitude_data msg = {
+            .timestamp_us = imu.timestamp_us,
+            .q = {ahrs.q[0], ahrs.q[1], ahrs.q[2], ahrs.q[3]},
+            .rate_radps = {imu.gyro_radps[0], imu.gyro_radps[1],
+                           imu.gyro_radps[2]},
+        };
+
+        ret = zbus_chan_pub(&attitude_chan, &msg, K_NO_WAIT);
+        if (ret < 0 && ret != -EAGAIN && ret != -EBUSY) {
+            LOG_ERR("Failed to send attitude message on zbus!");
+        }
+    }
+}
@@ -0,0 +1,241 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stm32_ll_adc.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/adc.h>
+#include <zephyr/drivers/dma.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+
+#include "battery.h"
+
+#include "battery_monitor.h"
+#include "types.h"
+
+LOG_MODULE_REGISTER(battery_monitor);
+
+ZBUS_OBS_DECLARE(logger_sub);
+
+ZBUS_CHAN_DEFINE(battery_chan, struct battery_data, NULL, NULL,
+                 ZBUS_OBSERVERS(logger_sub), {0});
+
+#define BATTERY_NODE DT_PATH(zephyr_user)
+#define BATTERY_ADC_NODE DT_IO_CHANNELS_CTLR_BY_IDX(BATTERY_NODE, 0)
+
+#define BATTERY_DMA_CHANNEL DT_DMAS_CELL_BY_IDX(BATTERY_NODE, 0, channel)
+#define BATTERY_DMA_SLOT DT_DMAS_CELL_BY_IDX(BATTERY_NODE, 0, slot)
+
+// The ADC converts continuously with the longest sampling time and sums 256
+// conversions in hardware, so the DMA only moves a few hundred samples per
+// second and the CPU never touches the ADC after setup
+#define BATTERY_ADC_SAMPLING_TIME LL_ADC_SAMPLINGTIME_640CYCLES_5
+#define BATTERY_ADC_OVERSAMPLING_RATIO LL_ADC_OVS_RATIO_256
+#define BATTERY_ADC_OVERSAMPLING_SHIFT LL_ADC_OVS_SHIFT_RIGHT_4
+#define BATTERY_ADC_FULL_SCALE 65536.0f // 12 bits, 256 times, shifted by 4
+
+// Samples averaged on every publish, covering roughly 180 ms
+#define BATTERY_SAMPLE_COUNT 64
+
+// Lets the DMA fill the whole buffer before the first average
+#define BATTERY_STARTUP_DELAY_MS 500
+
+// The board does not sense current, so the sag is estimated from the voltage
+// alone and the internal resistance is not used
+#define BATTERY_SAG_RECOVERY_TAU_S 30.0f
+
+static const struct adc_dt_spec battery_adc =
+    ADC_DT_SPEC_GET_BY_IDX(BATTERY_NODE, 0);
+
+static const struct device *const battery_dma =
+    DEVICE_DT_GET(DT_DMAS_CTLR_BY_IDX(BATTERY_NODE, 0));
+
+static volatile uint16_t adc_samples[BATTERY_SAMPLE_COUNT] __aligned(4);
+
+static BATTERY_Inst_Type battery;
+
+static struct k_timer publish_timer;
+
+static void dma_callback(const struct device *dev, void *user_data,
+                         uint32_t channel, int status) {
+    if (status < 0) {
+        LOG_ERR("Battery voltage DMA transfer failed!");
+    }
+}
+
+static int start_dma(ADC_TypeDef *adc) {
+    struct dma_block_config block = {
+        .source_address =
+            LL_ADC_DMA_GetRegAddr(adc, LL_ADC_DMA_REG_REGULAR_DATA),
+        .dest_address = (uint32_t)(uintptr_t)adc_samples,
+        .block_size = sizeof(adc_samples),
+        .source_addr_adj = DMA_ADDR_ADJ_NO_CHANGE,
+        .dest_addr_adj = DMA_ADDR_ADJ_INCREMENT,
+        .source_reload_en = 1,
+        .dest_reload_en = 1,
+    };
+
+    struct dma_config cfg = {
+        .dma_slot = BATTERY_DMA_SLOT,
+        .channel_direction = PERIPHERAL_TO_MEMORY,
+        .cyclic = 1,
+        .source_data_size = sizeof(adc_samples[0]),
+        .dest_data_size = sizeof(adc_samples[0]),
+        .source_burst_length = 1,
+        .dest_burst_length = 1,
+        .block_count = 1,
+        .head_block = &block,
+        .dma_callback = dma_callback,
+    };
+
+    int ret = dma_config(battery_dma, BATTERY_DMA_CHANNEL, &cfg);
+    if (ret < 0) {
+        return ret;
+    }
+
+    return dma_start(battery_dma, BATTERY_DMA_CHANNEL);
+}
+
+static int start_continuous_adc(ADC_TypeDef *adc) {
+    const uint32_t channel =
+        __LL_ADC_DECIMAL_NB_TO_CHANNEL(battery_adc.channel_id);
+
+    // Regular group configuration is only writable with no conversion ongoing
+    if (LL_ADC_REG_IsConversionOngoing(adc)) {
+        LL_ADC_REG_StopConversion(adc);
+        while (LL_ADC_REG_IsStopConversionOngoing(adc)) {
+        }
+    }
+
+    LL_ADC_REG_SetTriggerSource(adc, LL_ADC_REG_TRIG_SOFTWARE);
+    LL_ADC_REG_SetSequencerLength(adc, LL_ADC_REG_SEQ_SCAN_DISABLE);
+    LL_ADC_REG_SetSequencerRanks(adc, LL_ADC_REG_RANK_1, channel);
+    LL_ADC_SetChannelSamplingTime(adc, channel, BATTERY_ADC_SAMPLING_TIME);
+
+    LL_ADC_SetOverSamplingScope(adc, LL_ADC_OVS_GRP_REGULAR_CONTINUED);
+    LL_ADC_ConfigOverSamplingRatioShift(adc, BATTERY_ADC_OVERSAMPLING_RATIO,
+                                        BATTERY_ADC_OVERSAMPLING_SHIFT);
+
+    LL_ADC_REG_SetContinuousMode(adc, LL_ADC_REG_CONV_CONTINUOUS);
+    LL_ADC_REG_SetOverrun(adc, LL_ADC_REG_OVR_DATA_OVERWRITTEN);
+    LL_ADC_REG_SetDMATransfer(adc, LL_ADC_REG_DMA_TRANSFER_UNLIMITED);
+
+    int ret = start_dma(adc);
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (!LL_ADC_IsEnabled(adc)) {
+        LL_ADC_ClearFlag_ADRDY(adc);
+        LL_ADC_Enable(adc);
+        while (!LL_ADC_IsActiveFlag_ADRDY(adc)) {
+        }
+    }
+
+    LL_ADC_REG_StartConversion(adc);
+
+    return 0;
+}
+
+static int init_sampling(void) {
+    if (!adc_is_ready_dt(&battery_adc)) {
+        return -ENODEV;
+    }
+
+    if (!device_is_ready(battery_dma)) {
+        return -ENODEV;
+    }
+
+    if (battery_adc.vref_mv == 0) {
+        return -EINVAL;
+    }
+
+    // The driver validates the channel, after which the regular group is
+    // taken over for continuous conversion
+    int ret = adc_channel_setup_dt(&battery_adc);
+    if (ret < 0) {
+        return ret;
+    }
+
+    return start_continuous_adc((ADC_TypeDef *)DT_REG_ADDR(BATTERY_ADC_NODE));
+}
+
+void battery_monitor(void *dummy1, void *dummy2, void *dummy3) {
+    ARG_UNUSED(dummy1);
+    ARG_UNUSED(dummy2);
+    ARG_UNUSED(dummy3);
+
+    const BATTERY_Config_Type battery_cfg = {
+        .cell_count = CONFIG_APP_BATTERY_CELL_COUNT,
+        .cell_full_v = CONFIG_APP_BATTERY_CELL_FULL_MV / 1000.0f,
+        .cell_empty_v = CONFIG_APP_BATTERY_CELL_EMPTY_MV / 1000.0f,
+        .internal_resistance_ohm = 0.0f,
+        .sag_recovery_tau_s = BATTERY_SAG_RECOVERY_TAU_S,
+    };
+
+    if (BATTERY_Init(&battery, &battery_cfg) != BATTERY_SUCCESS) {
+        LOG_ERR("Could not initialize the battery model!");
+        return;
+    }
+
+    int ret = init_sampling();
+    if (ret < 0) {
+        LOG_ERR("Could not start battery voltage sampling: %d", ret);
+        return;
+    }
+
+    const float counts_to_volts = battery_adc.vref_mv / 1000.0f /
+                                  BATTERY_ADC_FULL_SCALE *
+                                  CONFIG_APP_BATTERY_VOLTAGE_SCALE / 1000.0f;
+    const float dt_s = 1.0f / CONFIG_APP_BATTERY_RATE_HZ;
+
+    k_timer_init(&publish_timer, NULL, NULL);
+    k_timer_start(&publish_timer, K_MSEC(BATTERY_STARTUP_DELAY_MS),
+                  K_MSEC(1000 / CONFIG_APP_BATTERY_RATE_HZ));
+
+    while (true) {
+        k_timer_status_sync(&publish_timer);
+
+        uint32_t sum = 0;
+        for (int i = 0; i < BATTERY_SAMPLE_COUNT; i++) {
+            sum += adc_samples[i];
+        }
+
+        const float voltage_v =
+            (float)sum / BATTERY_SAMPLE_COUNT * counts_to_volts;
+
+        BATTERY_Update(&battery, voltage_v, NAN, dt_s);
+
+        const struct battery_data msg = {
+            .timestamp_us = k_ticks_to_us_floor64(k_uptime_ticks()),
+            .voltage_v = battery.voltage_v,
+            .current_a = battery.current_a,
+            .resting_voltage_v = battery.resting_voltage_v,
+            .remaining = battery.remaining,
+            .consumed_mah = battery.consumed_mah,
+            .cell_count = battery.cell_count,
+        };
+
+        ret = zbus_chan_pub(&battery_chan, &msg, K_NO_WAIT);
+        if (ret < 0 && ret != -EAGAIN && ret != -EBUSY) {
+            LOG_ERR("Failed to send battery message on zbus!");
+        }
+    }
+}
@@ -0,0 +1,278 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/zbus/zbus.h>
+
+#include "crsf.h"
+
+#include "crsf_receiver.h"
+#include "radio_receiver.h"
+#include "types.h"
+
+LOG_MODULE_REGISTER(crsf_receiver);
+
+ZBUS_CHAN_DECLARE(attitude_chan);
+ZBUS_CHAN_DECLARE(battery_chan);
+
+BUILD_ASSERT(CRSF_RC_CHANNEL_COUNT == RC_CHANNEL_COUNT);
+
+// Each buffer holds a few frames, received data is parsed on every idle line
+// and whenever a buffer fills up
+#define CRSF_RX_BUFFER_LEN (4 * CRSF_MAX_FRAME_LEN)
+
+// Idle time after which received data is handed over, about four bytes
+#define CRSF_RX_TIMEOUT_US 100
+
+static const struct device *const crsf_uart =
+    DEVICE_DT_GET(DT_CHOSEN(eurus_crsf));
+
+static uint8_t rx_buffers[2][CRSF_RX_BUFFER_LEN];
+static uint8_t next_rx_buffer;
+
+static CRSF_Parser_Type parser;
+
+// Updated by the frames in between the channel frames
+static struct rc_link link;
+static CRSF_Link_Stats_Type link_stats;
+
+static uint8_t tx_frame[CRSF_MAX_FRAME_LEN];
+static atomic_t tx_busy;
+
+struct crsf_stats {
+    uint32_t parse_calls;
+    uint32_t parse_cycles_max;
+    uint64_t parse_cycles_sum;
+    uint32_t rx_errors;
+    uint32_t telemetry_sent;
+    uint32_t telemetry_skipped;
+};
+
+static struct crsf_stats stats;
+
+static void handle_frame(uint8_t type, const uint8_t *payload,
+                         uint8_t payload_len, void *user_data) {
+    switch (type) {
+    case CRSF_FRAME_RC_CHANNELS_PACKED:
+        if (payload_len >= CRSF_RC_CHANNELS_PAYLOAD_LEN) {
+            uint16_t channels[CRSF_RC_CHANNEL_COUNT];
+            CRSF_DecodeChannels(payload, channels);
+            radio_receiver_publish(channels, &link);
+        }
+        break;
+    case CRSF_FRAME_LINK_STATISTICS:
+        if (payload_len >= CRSF_LINK_STATS_PAYLOAD_LEN) {
+            CRSF_DecodeLinkStats(payload, &link_stats);
+
+            const uint8_t rssi = link_stats.active_antenna
+                                     ? link_stats.uplink_rssi_2_dbm
+                                     : link_stats.uplink_rssi_1_dbm;
+
+            link.link_quality = link_stats.uplink_link_quality;
+            link.rssi_dbm = -(int16_t)rssi;
+            link.snr_db = link_stats.uplink_snr_db;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static int start_rx(void) {
+    next_rx_buffer = 1;
+
+    return uart_rx_enable(crsf_uart, rx_buffers[0], CRSF_RX_BUFFER_LEN,
+                          CRSF_RX_TIMEOUT_US);
+}
+
+static void parse_rx(const uint8_t *data, size_t len) {
+    const uint32_t start_cycles = k_cycle_get_32();
+
+    CRSF_Parse(&parser, data, len);
+
+    const uint32_t cycles = k_cycle_get_32() - start_cycles;
+    stats.parse_calls++;
+    stats.parse_cycles_sum += cycles;
+    stats.parse_cycles_max = MAX(stats.parse_cycles_max, cycles);
+}
+
+static void uart_callback(const struct device *dev, struct uart_event *evt,
+                          void *user_data) {
+    switch (evt->type) {
+    case UART_RX_RDY:
+        parse_rx(&evt->data.rx.buf[evt->data.rx.offset], evt->data.rx.len);
+        break;
+    case UART_RX_BUF_REQUEST:
+        uart_rx_buf_rsp(dev, rx_buffers[next_rx_buffer], CRSF_RX_BUFFER_LEN);
+        next_rx_buffer ^= 1;
+        break;
+    case UART_RX_STOPPED:
+        stats.rx_errors++;
+        break;
+    case UART_RX_DISABLED:
+        // Reception is disabled after errors, so it is restarted right away
+        if (start_rx() < 0) {
+            LOG_ERR("Could not restart CRSF reception!");
+        }
+        break;
+    case UART_TX_DONE:
+    case UART_TX_ABORTED:
+        atomic_clear(&tx_busy);
+        break;
+    default:
+        break;
+    }
+}
+
+static uint8_t encode_attitude(uint8_t *frame) {
+    struct attitude_data msg;
+    if (zbus_chan_read(&attitude_chan, &msg, K_MSEC(1)) < 0) {
+        return 0;
+    }
+
+    const float w = msg.q[0];
+    const float x = msg.q[1];
+    const float y = msg.q[2];
+    const float z = msg.q[3];
+
+    const float roll_rad =
+        atan2f(2.0f * (w * x + y * z), 1.0f - 2.0f * (x * x + y * y));
+    const float pitch_rad = asinf(CLAMP(2.0f * (w * y - z * x), -1.0f, 1.0f));
+    const float yaw_rad =
+        atan2f(2.0f * (w * z + x * y), 1.0f - 2.0f * (y * y + z * z));
+
+    return CRSF_EncodeAttitude(roll_rad, pitch_rad, yaw_rad, frame);
+}
+
+static uint8_t encode_battery(uint8_t *frame) {
+    struct battery_data msg;
+    if (zbus_chan_read(&battery_chan, &msg, K_MSEC(1)) < 0) {
+        return 0;
+    }
+
+    const CRSF_Battery_Type battery = {
+        .voltage_v = msg.voltage_v,
+        .current_a = msg.current_a,
+        .capacity_mah = (uint32_t)msg.consumed_mah,
+        .remaining_pct = (uint8_t)(msg.remaining * 100.0f),
+    };
+
+    return CRSF_EncodeBattery(&battery, frame);
+}
+
+// Battery and attitude take turns, the receiver sends them down at the rate
+// its telemetry ratio allows
+static void telemetry_handler(struct k_work *work) {
+    static bool send_attitude;
+
+    if (!atomic_cas(&tx_busy, 0, 1)) {
+        stats.telemetry_skipped++;
+        return;
+    }
+
+    const uint8_t len =
+        send_attitude ? encode_attitude(tx_frame) : encode_battery(tx_frame);
+    send_attitude = !send_attitude;
+
+    if (len == 0 || uart_tx(crsf_uart, tx_frame, len, SYS_FOREVER_US) < 0) {
+        atomic_clear(&tx_busy);
+        stats.telemetry_skipped++;
+        return;
+    }
+
+    stats.telemetry_sent++;
+}
+
+static K_WORK_DEFINE(telemetry_work, telemetry_handler);
+
+static void telemetry_notify(struct k_timer *timer) {
+    k_work_submit(&telemetry_work);
+}
+
+K_TIMER_DEFINE(crsf_telemetry_timer, telemetry_notify, NULL);
+
+int crsf_receiver_init(void) {
+    if (!device_is_ready(crsf_uart)) {
+        LOG_ERR("CRSF UART device is not ready!");
+        return -ENODEV;
+    }
+
+    CRSF_ParserInit(&parser, handle_frame, NULL);
+
+    int ret = uart_callback_set(crsf_uart, uart_callback, NULL);
+    if (ret < 0) {
+        LOG_ERR("CRSF UART does not support the async API!");
+        return ret;
+    }
+
+    ret = start_rx();
+    if (ret < 0) {
+        LOG_ERR("Could not start CRSF reception!");
+        return ret;
+    }
+
+    k_timer_start(&crsf_telemetry_timer,
+                  K_MSEC(CONFIG_APP_CRSF_TELEMETRY_PERIOD_MS),
+                  K_MSEC(CONFIG_APP_CRSF_TELEMETRY_PERIOD_MS));
+
+    return 0;
+}
+
+static int cmd_crsf_stats(const struct shell *sh, size_t argc, char **argv) {
+    shell_print(sh, "Frames: %u, CRC errors: %u, bytes skipped: %u",
+                parser.frames, parser.crc_errors, parser.bytes_skipped);
+
+    if (stats.parse_calls > 0) {
+        const uint32_t mean_cycles =
+            stats.parse_cycles_sum / stats.parse_calls;
+
+        shell_print(sh, "Parse time [ns]: mean %llu, max %llu, %u chunks",
+                    k_cyc_to_ns_floor64(mean_cycles),
+                    k_cyc_to_ns_floor64(stats.parse_cycles_max),
+                    stats.parse_calls);
+    }
+
+    shell_print(sh, "RX errors: %u, telemetry sent: %u, skipped: %u",
+                stats.rx_errors, stats.telemetry_sent,
+                stats.telemetry_skipped);
+    shell_print(sh,
+                "Uplink: RSSI -%u/-%u dBm, LQ %u %%, SNR %d dB, antenna %u, "
+                "mode %u, power %u",
+                link_stats.uplink_rssi_1_dbm, link_stats.uplink_rssi_2_dbm,
+                link_stats.uplink_link_quality, link_stats.uplink_snr_db,
+                link_stats.active_antenna, link_stats.rf_mode,
+                link_stats.uplink_tx_power);
+    shell_print(sh, "Downlink: RSSI -%u dBm, LQ %u %%, SNR %d dB",
+                link_stats.downlink_rssi_dbm, link_stats.downlink_link_quality,
+                link_stats.downlink_snr_db);
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    crsf_cmds,
+    SHELL_CMD(stats, NULL, "Show parser, link and telemetry statistics",
+              cmd_crsf_stats),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(crsf, &crsf_cmds, "CRSF receiver", NULL);
@@ -0,0 +1,137 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+
+#include "dyn_notch.h"
+
+#include "imu_filter.h"
+#include "latency.h"
+#include "types.h"
+
+LOG_MODULE_REGISTER(imu_filter);
+
+ZBUS_OBS_DECLARE(attitude_estimator_sub);
+ZBUS_OBS_DECLARE(logger_sub);
+ZBUS_OBS_DECLARE(rate_controller_sub);
+ZBUS_OBS_DECLARE(vertical_estimator_sub);
+
+ZBUS_CHAN_DECLARE(imu_chan);
+
+// Observers are notified in order, so the rate controller comes first
+ZBUS_CHAN_DEFINE(imu_filtered_chan, struct imu_6dof_data, NULL, NULL,
+                 ZBUS_OBSERVERS(rate_controller_sub, attitude_estimator_sub,
+                                vertical_estimator_sub),
+                 {0});
+
+ZBUS_CHAN_DEFINE(dyn_notch_chan, struct dyn_notch_data, NULL, NULL,
+                 ZBUS_OBSERVERS(logger_sub), {0});
+
+ZBUS_SUBSCRIBER_DEFINE_WITH_ENABLE(imu_filter_sub, 16, false);
+
+static DYN_NOTCH_Inst_Type dyn_notch;
+
+static bool init_dyn_notch(void) {
+#if CONFIG_APP_DYN_NOTCH
+    const DYN_NOTCH_Config_Type cfg = {
+        .sample_rate_hz = CONFIG_APP_IMU_RATE_HZ,
+        .min_freq_hz = CONFIG_APP_DYN_NOTCH_MIN_FREQ_HZ,
+        .max_freq_hz = CONFIG_APP_DYN_NOTCH_MAX_FREQ_HZ,
+        .q = CONFIG_APP_DYN_NOTCH_Q / 100.0f,
+        .notch_count = CONFIG_APP_DYN_NOTCH_COUNT,
+    };
+
+    if (DYN_NOTCH_Init(&dyn_notch, &cfg) != DYN_NOTCH_SUCCESS) {
+        LOG_ERR("Could not initialize dynamic notch, gyro will be unfiltered!");
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+static void publish_dyn_notch(uint64_t timestamp_us) {
+    struct dyn_notch_data msg = {
+        .timestamp_us = timestamp_us,
+        .max_step_cycles = DYN_NOTCH_GetMaxStepCycles(&dyn_notch),
+    };
+
+    for (int axis = 0; axis < DYN_NOTCH_AXIS_COUNT; axis++) {
+        for (int i = 0; i < dyn_notch.cfg.notch_count; i++) {
+            msg.center_freq_hz[axis][i] = dyn_notch.peak_freq_hz[axis][i];
+        }
+    }
+
+    int ret = zbus_chan_pub(&dyn_notch_chan, &msg, K_NO_WAIT);
+    if (ret < 0 && ret != -EAGAIN && ret != -EBUSY) {
+        LOG_ERR("Failed to send dynamic notch message on zbus!");
+    }
+}
+
+void imu_filter(void *dummy1, void *dummy2, void *dummy3) {
+    ARG_UNUSED(dummy1);
+    ARG_UNUSED(dummy2);
+    ARG_UNUSED(dummy3);
+
+    const bool dyn_notch_enabled = init_dyn_notch();
+
+    zbus_obs_set_enable(&imu_filter_sub, true);
+
+    while (true) {
+        const struct zbus_channel *chan;
+        int ret = zbus_sub_wait(&imu_filter_sub, &chan, K_FOREVER);
+        if (ret < 0) {
+            LOG_ERR("Could not wait on the IMU filter subscriber, aborting.");
+            return;
+        }
+
+        if (chan != &imu_chan) {
+            continue;
+        }
+
+        struct imu_6dof_data msg;
+        ret = zbus_chan_read(chan, &msg, K_USEC(1));
+        if (ret < 0) {
+            LOG_ERR("Failed to read from IMU filter subscriber!");
+            continue;
+        }
+
+        if (dyn_notch_enabled) {
+            // Analysis runs on the raw gyro, so the notches do not hide the
+            // very peaks they are tracking
+            DYN_NOTCH_Push(&dyn_notch, msg.gyro_radps);
+
+            if (DYN_NOTCH_Update(&dyn_notch)) {
+                publish_dyn_notch(msg.timestamp_us);
+            }
+
+            DYN_NOTCH_Apply(&dyn_notch, msg.gyro_radps);
+        }
+
+        latency_record(LATENCY_STAGE_FILTER, msg.origin_cycles);
+
+        msg.publish_cycles = k_cycle_get_32();
+        ret = zbus_chan_pub(&imu_filtered_chan, &msg, K_NO_WAIT);
+        if (ret < 0 && ret != -EAGAIN && ret != -EBUSY) {
+            LOG_ERR("Failed to send filtered imu message on zbus!");
+        }
+    }
+}
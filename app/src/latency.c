@@ -0,0 +1,235 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/zbus/zbus.h>
+
+#include "latency.h"
+#include "types.h"
+
+LOG_MODULE_REGISTER(latency);
+
+ZBUS_OBS_DECLARE(logger_sub);
+
+ZBUS_CHAN_DEFINE(latency_chan, struct latency_data, NULL, NULL,
+                 ZBUS_OBSERVERS(logger_sub), {0});
+
+#define LATENCY_HIST_BINS 256
+
+#if CONFIG_APP_PRIMARY_IMU_ICM42688P
+#define LATENCY_IMU_NODE DT_NODELABEL(imu_icm42688p)
+#else
+#define LATENCY_IMU_NODE DT_NODELABEL(imu_mpu6050)
+#endif
+
+// Without a data ready line, e.g. a polled sensor, samples are timed from
+// the start of the fetch instead
+#define LATENCY_HAS_DRDY DT_NODE_HAS_PROP(LATENCY_IMU_NODE, int_gpios)
+
+static const char *const stage_names[LATENCY_STAGE_COUNT] = {
+    [LATENCY_STAGE_READ] = "read",
+    [LATENCY_STAGE_FILTER] = "filter",
+    [LATENCY_STAGE_ATTITUDE] = "attitude",
+    [LATENCY_STAGE_CONTROL] = "control",
+    [LATENCY_STAGE_OUTPUT] = "output",
+};
+
+// Every stage is recorded by a single thread, so the histograms are updated
+// without locking. Readers may see a sample counted in one field but not yet
+// in another, which does not matter for the statistics.
+struct latency_hist {
+    uint32_t bins[LATENCY_HIST_BINS]; // CONFIG_APP_LATENCY_BIN_US wide each
+    uint32_t max_us;
+};
+
+static struct latency_hist hists[LATENCY_STAGE_COUNT];
+
+// Set by the shell, cleared by the recording thread of the stage
+static ATOMIC_DEFINE(reset_requested, LATENCY_STAGE_COUNT);
+
+#if LATENCY_HAS_DRDY
+static const struct gpio_dt_spec drdy_gpio =
+    GPIO_DT_SPEC_GET(LATENCY_IMU_NODE, int_gpios);
+static struct gpio_callback drdy_callback;
+static volatile uint32_t drdy_cycles;
+static volatile bool drdy_seen;
+
+// A data ready edge older than one raw sample period belongs to an earlier
+// sample, e.g. when the sensor is polled even though the line is wired
+static uint32_t raw_period_cycles;
+
+static void drdy_handler(const struct device *dev, struct gpio_callback *cb,
+                         uint32_t pins) {
+    drdy_cycles = k_cycle_get_32();
+    drdy_seen = true;
+}
+#endif
+
+static void report_handler(struct k_work *work);
+static K_WORK_DEFINE(report_work, report_handler);
+
+static void report_notify(struct k_timer *timer) {
+    k_work_submit(&report_work);
+}
+
+K_TIMER_DEFINE(latency_report_timer, report_notify, NULL);
+
+uint32_t latency_sample_origin(void) {
+    const uint32_t now_cycles = k_cycle_get_32();
+
+#if LATENCY_HAS_DRDY
+    const uint32_t origin_cycles = drdy_cycles;
+    if (drdy_seen && now_cycles - origin_cycles < raw_period_cycles) {
+        return origin_cycles;
+    }
+#endif
+
+    return now_cycles;
+}
+
+void latency_record(int stage, uint32_t origin_cycles) {
+    const uint32_t latency_us =
+        k_cyc_to_us_floor32(k_cycle_get_32() - origin_cycles);
+    struct latency_hist *hist = &hists[stage];
+
+    if (atomic_test_and_clear_bit(reset_requested, stage)) {
+        memset(hist, 0, sizeof(*hist));
+    }
+
+    hist->bins[MIN(latency_us / CONFIG_APP_LATENCY_BIN_US,
+                   LATENCY_HIST_BINS - 1)]++;
+    hist->max_us = MAX(hist->max_us, latency_us);
+}
+
+// Upper edge of the bin holding the percentile, the last bin is open ended
+static uint32_t percentile_us(const struct latency_hist *hist, uint32_t count,
+                              uint32_t permille) {
+    const uint32_t rank = (uint64_t)count * permille / 1000;
+    uint32_t seen = 0;
+
+    for (int i = 0; i < LATENCY_HIST_BINS - 1; i++) {
+        seen += hist->bins[i];
+        if (seen > rank) {
+            return (i + 1) * CONFIG_APP_LATENCY_BIN_US;
+        }
+    }
+
+    return hist->max_us;
+}
+
+static void latency_snapshot(struct latency_data *msg) {
+    msg->timestamp_us = k_ticks_to_us_floor64(k_uptime_ticks());
+
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        const struct latency_hist *hist = &hists[stage];
+
+        uint32_t count = 0;
+        for (int i = 0; i < LATENCY_HIST_BINS; i++) {
+            count += hist->bins[i];
+        }
+
+        msg->count[stage] = count;
+        msg->p50_us[stage] = count ? percentile_us(hist, count, 500) : 0;
+        msg->p99_us[stage] = count ? percentile_us(hist, count, 990) : 0;
+        msg->max_us[stage] = hist->max_us;
+    }
+}
+
+static void report_handler(struct k_work *work) {
+    struct latency_data msg;
+    latency_snapshot(&msg);
+
+    int ret = zbus_chan_pub(&latency_chan, &msg, K_NO_WAIT);
+    if (ret < 0 && ret != -EAGAIN && ret != -EBUSY) {
+        LOG_ERR("Failed to send latency message on zbus!");
+    }
+}
+
+int latency_init(void) {
+#if LATENCY_HAS_DRDY
+    if (!gpio_is_ready_dt(&drdy_gpio)) {
+        LOG_ERR("IMU data ready GPIO is not ready!");
+        return -ENODEV;
+    }
+
+    raw_period_cycles =
+        sys_clock_hw_cycles_per_sec() /
+        (CONFIG_APP_IMU_RATE_HZ * CONFIG_APP_IMU_DECIMATION_RATIO);
+
+    // Added next to the callback of the sensor driver, which configures the
+    // pin interrupt itself
+    gpio_init_callback(&drdy_callback, drdy_handler, BIT(drdy_gpio.pin));
+    int ret = gpio_add_callback(drdy_gpio.port, &drdy_callback);
+    if (ret < 0) {
+        LOG_ERR("Could not add the IMU data ready callback!");
+        return ret;
+    }
+#endif
+
+    k_timer_start(&latency_report_timer,
+                  K_MSEC(CONFIG_APP_LATENCY_REPORT_INTERVAL_MS),
+                  K_MSEC(CONFIG_APP_LATENCY_REPORT_INTERVAL_MS));
+
+    return 0;
+}
+
+static int cmd_latency_show(const struct shell *sh, size_t argc, char **argv) {
+    struct latency_data msg;
+    latency_snapshot(&msg);
+
+    shell_print(sh, "Time from IMU data ready to the end of every stage");
+    shell_print(sh, "%10s %10s %10s %10s %10s", "Stage", "Samples",
+                "p50 [us]", "p99 [us]", "Max [us]");
+
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        shell_print(sh, "%10s %10u %10u %10u %10u", stage_names[stage],
+                    msg.count[stage], msg.p50_us[stage], msg.p99_us[stage],
+                    msg.max_us[stage]);
+    }
+
+    if (!LATENCY_HAS_DRDY) {
+        shell_print(sh, "No data ready line, timed from the sample fetch");
+    }
+
+    return 0;
+}
+
+static int cmd_latency_reset(const struct shell *sh, size_t argc, char **argv) {
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        atomic_set_bit(reset_requested, stage);
+    }
+
+    shell_print(sh, "Histograms are cleared on the next sample of each stage");
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    latency_cmds,
+    SHELL_CMD(show, NULL, "Show p50, p99 and max latency of every stage",
+              cmd_latency_show),
+    SHELL_CMD(reset, NULL, "Clear the latency histograms", cmd_latency_reset),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(latency, &latency_cmds, "Gyro to motor latency", NULL);
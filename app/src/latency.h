@@ -0,0 +1,29 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+
+// Stages are numbered as in enum latency_stage, which is in types.h
+#ifdef CONFIG_APP_LATENCY_TRACE
+int latency_init(void);
+uint32_t latency_sample_origin(void);
+void latency_record(int stage, uint32_t origin_cycles);
+#else
+static inline int latency_init(void) { return 0; }
+static inline uint32_t latency_sample_origin(void) { return 0; }
+static inline void latency_record(int stage, uint32_t origin_cycles) {}
+#endif
@@ -0,0 +1,475 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/util.h>
+
+// MAVLink headers
+// clang-format off
+#include "mavlink_custom.h" // Needs to be included before any MAVLink header inclusion
+#include "efc/mavlink.h"
+// clang-format on
+
+#include "log_stream.h"
+#include "telemetry_link.h"
+
+LOG_MODULE_REGISTER(log_stream);
+
+#define LOGGING_DATA_LEN MAVLINK_MSG_LOGGING_DATA_FIELD_DATA_LEN
+#define LOGGING_DATA_FRAME_LEN                                                 \
+    (MAVLINK_NUM_NON_PAYLOAD_BYTES + MAVLINK_MSG_ID_LOGGING_DATA_LEN)
+
+// First message offset of a chunk which holds no message start
+#define NO_MESSAGE_START UINT8_MAX
+
+// The log starts with the file header, followed by messages which all start
+// with their size and type
+#define ULOG_FILE_HEADER_LEN 16
+#define ULOG_MESSAGE_HEADER_LEN 3
+
+// Data messages start with the message ID and the timestamp
+#define ULOG_DATA_MSG_ID_OFS ULOG_MESSAGE_HEADER_LEN
+#define ULOG_DATA_TIMESTAMP_OFS (ULOG_DATA_MSG_ID_OFS + sizeof(uint16_t))
+#define ULOG_DATA_MIN_LEN (ULOG_DATA_TIMESTAMP_OFS + sizeof(uint64_t))
+
+// Subscriptions hold the multi ID, the message ID and the topic name
+#define ULOG_ADD_MSG_ID_OFS (ULOG_MESSAGE_HEADER_LEN + sizeof(uint8_t))
+#define ULOG_ADD_NAME_OFS (ULOG_ADD_MSG_ID_OFS + sizeof(uint16_t))
+
+// Data chunks only fill this part of the bulk transmit ring, so they do not
+// push out the high rate telemetry streams
+#define LOG_STREAM_WINDOW_DIV 2
+
+// Streamed topics are limited to the message IDs below
+#define LOG_STREAM_MAX_TOPICS 16
+
+// Interval of topics missing from the profile
+#define LOG_STREAM_DEFAULT_INTERVAL_US 100000
+
+struct log_stream_topic {
+    const char *name;
+    uint32_t interval_us;
+};
+
+// Logging rate profile of the stream, at CONFIG_APP_LOG_STREAM_PROFILE_RATE.
+// Slower links get proportionally longer intervals.
+static const struct log_stream_topic profile[] = {
+    {"gyro", 5000},      {"accel", 5000},     {"rate_control", 20000},
+    {"motor", 5000},     {"attitude", 10000}, {"dyn_notch", 20000},
+    {"baro", 20000},     {"altitude", 20000}, {"battery", 100000},
+    {"latency", 100000},
+};
+
+struct log_stream_stats {
+    uint32_t chunks_sent;
+    uint32_t chunks_dropped;
+    uint32_t messages_skipped;
+    uint32_t retransmits;
+    uint32_t reliable_overflows;
+};
+
+struct log_stream {
+    bool active;
+    uint8_t chan;
+    uint8_t target_system;
+    uint8_t target_component;
+    uint16_t sequence;
+
+    // Reliable part of the log, the header, definitions and subscriptions,
+    // kept so it can be sent to every GCS which starts streaming. It is sent
+    // in acknowledged chunks, one at a time, and data is only streamed once
+    // all of it was acknowledged.
+    uint8_t reliable[CONFIG_APP_LOG_STREAM_RELIABLE_SIZE];
+    uint16_t reliable_len;
+    uint16_t reliable_acked;
+    uint16_t ack_len; // Of the chunk waiting for the ack, zero if none
+    uint16_t ack_sequence;
+    uint8_t retries;
+
+    // Data chunk being filled
+    uint8_t chunk[LOGGING_DATA_LEN];
+    uint8_t chunk_len;
+    uint8_t chunk_first_message;
+
+    // Rate profile by message ID, from the subscriptions
+    uint32_t profile_us[LOG_STREAM_MAX_TOPICS];
+    uint32_t interval_us[LOG_STREAM_MAX_TOPICS];
+    uint64_t last_us[LOG_STREAM_MAX_TOPICS];
+
+    struct log_stream_stats stats;
+};
+
+static struct log_stream stream;
+
+// Guards the stream, written by the logger and driven by the receiver
+static K_MUTEX_DEFINE(stream_mutex);
+
+static void reliable_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(reliable_work, reliable_handler);
+
+// Offset of the first message starting within a range of the reliable part
+static uint8_t first_message_in(uint16_t start, uint16_t len) {
+    uint16_t ofs = ULOG_FILE_HEADER_LEN;
+
+    while (ofs + ULOG_MESSAGE_HEADER_LEN <= stream.reliable_len &&
+           ofs < start) {
+        uint16_t size;
+        memcpy(&size, &stream.reliable[ofs], sizeof(size));
+        ofs += ULOG_MESSAGE_HEADER_LEN + size;
+    }
+
+    return ofs >= start && ofs < start + len ? ofs - start : NO_MESSAGE_START;
+}
+
+static void send_reliable_chunk(void) {
+    telemetry_link_lock(stream.chan);
+    mavlink_msg_logging_data_acked_send(
+        stream.chan, stream.target_system, stream.target_component,
+        stream.ack_sequence, stream.ack_len,
+        first_message_in(stream.reliable_acked, stream.ack_len),
+        &stream.reliable[stream.reliable_acked]);
+    telemetry_link_unlock(stream.chan);
+}
+
+static void reliable_handler(struct k_work *work) {
+    k_mutex_lock(&stream_mutex, K_FOREVER);
+
+    if (!stream.active) {
+        k_mutex_unlock(&stream_mutex);
+        return;
+    }
+
+    if (stream.ack_len > 0) {
+        // The chunk or its ack was lost
+        if (++stream.retries > CONFIG_APP_LOG_STREAM_MAX_RETRIES) {
+            LOG_WRN("Log stream not acknowledged, stopping it");
+            stream.active = false;
+            k_mutex_unlock(&stream_mutex);
+            return;
+        }
+
+        stream.stats.retransmits++;
+    } else if (stream.reliable_acked < stream.reliable_len) {
+        stream.ack_len = MIN(stream.reliable_len - stream.reliable_acked,
+                             LOGGING_DATA_LEN);
+        stream.ack_sequence = stream.sequence++;
+        stream.retries = 0;
+    } else {
+        k_mutex_unlock(&stream_mutex);
+        return;
+    }
+
+    send_reliable_chunk();
+
+    k_work_reschedule(&reliable_work,
+                      K_MSEC(CONFIG_APP_LOG_STREAM_ACK_TIMEOUT_MS));
+
+    k_mutex_unlock(&stream_mutex);
+}
+
+static void send_data_chunk(void) {
+    if (stream.chunk_len == 0) {
+        return;
+    }
+
+    bool sent = false;
+
+    // The sequence still advances, so the GCS sees the gap
+    if (telemetry_link_class_used(stream.chan, TELEMETRY_CLASS_BULK) +
+            LOGGING_DATA_FRAME_LEN <=
+        telemetry_link_class_size(stream.chan, TELEMETRY_CLASS_BULK) /
+            LOG_STREAM_WINDOW_DIV) {
+        telemetry_link_lock(stream.chan);
+
+        // Another sender can fill the ring in between, which drops the chunk
+        const uint32_t dropped = telemetry_link_dropped(stream.chan);
+
+        mavlink_msg_logging_data_send(
+            stream.chan, stream.target_system, stream.target_component,
+            stream.sequence, stream.chunk_len, stream.chunk_first_message,
+            stream.chunk);
+
+        sent = telemetry_link_dropped(stream.chan) == dropped;
+
+        telemetry_link_unlock(stream.chan);
+    }
+
+    if (sent) {
+        stream.stats.chunks_sent++;
+    } else {
+        stream.stats.chunks_dropped++;
+    }
+
+    stream.sequence++;
+    stream.chunk_len = 0;
+    stream.chunk_first_message = NO_MESSAGE_START;
+}
+
+static void append_data(const uint8_t *data, size_t len) {
+    if (stream.chunk_first_message == NO_MESSAGE_START) {
+        stream.chunk_first_message = stream.chunk_len;
+    }
+
+    while (len > 0) {
+        const size_t count = MIN(len, LOGGING_DATA_LEN - stream.chunk_len);
+
+        memcpy(&stream.chunk[stream.chunk_len], data, count);
+        stream.chunk_len += count;
+        data += count;
+        len -= count;
+
+        if (stream.chunk_len == LOGGING_DATA_LEN) {
+            send_data_chunk();
+        }
+    }
+}
+
+// Applies the rate profile to a data message
+static bool is_due(const uint8_t *data, size_t len) {
+    if (data[2] != 'D' || len < ULOG_DATA_MIN_LEN) {
+        return true;
+    }
+
+    uint16_t msg_id;
+    uint64_t timestamp_us;
+    memcpy(&msg_id, &data[ULOG_DATA_MSG_ID_OFS], sizeof(msg_id));
+    memcpy(&timestamp_us, &data[ULOG_DATA_TIMESTAMP_OFS],
+           sizeof(timestamp_us));
+
+    if (msg_id >= LOG_STREAM_MAX_TOPICS) {
+        return false;
+    }
+
+    if (stream.last_us[msg_id] != 0 &&
+        timestamp_us - stream.last_us[msg_id] < stream.interval_us[msg_id]) {
+        return false;
+    }
+
+    stream.last_us[msg_id] = timestamp_us;
+
+    return true;
+}
+
+// Looks up the profile of a subscribed topic
+static void add_topic(const uint8_t *data, size_t len) {
+    if (data[2] != 'A' || len <= ULOG_ADD_NAME_OFS) {
+        return;
+    }
+
+    uint16_t msg_id;
+    memcpy(&msg_id, &data[ULOG_ADD_MSG_ID_OFS], sizeof(msg_id));
+
+    if (msg_id >= LOG_STREAM_MAX_TOPICS) {
+        return;
+    }
+
+    const char *name = (const char *)&data[ULOG_ADD_NAME_OFS];
+    const size_t name_len = len - ULOG_ADD_NAME_OFS;
+
+    stream.profile_us[msg_id] = LOG_STREAM_DEFAULT_INTERVAL_US;
+
+    for (int i = 0; i < ARRAY_SIZE(profile); i++) {
+        if (strlen(profile[i].name) == name_len &&
+            memcmp(profile[i].name, name, name_len) == 0) {
+            stream.profile_us[msg_id] = profile[i].interval_us;
+            break;
+        }
+    }
+}
+
+static void append_reliable(const uint8_t *data, size_t len) {
+    if (len > sizeof(stream.reliable) - stream.reliable_len) {
+        // A GCS could not parse the log, so none is streamed
+        if (stream.stats.reliable_overflows++ == 0) {
+            LOG_ERR("Log definitions do not fit, increase "
+                    "CONFIG_APP_LOG_STREAM_RELIABLE_SIZE");
+        }
+        return;
+    }
+
+    memcpy(&stream.reliable[stream.reliable_len], data, len);
+    stream.reliable_len += len;
+
+    if (stream.reliable_len > ULOG_FILE_HEADER_LEN) {
+        add_topic(data, len);
+    }
+}
+
+static int stream_write(void *ctx, const void *data, size_t len,
+                        bool reliable) {
+    k_mutex_lock(&stream_mutex, K_FOREVER);
+
+    if (reliable) {
+        // Data written before goes out first
+        if (stream.active) {
+            send_data_chunk();
+        }
+
+        append_reliable(data, len);
+
+        if (stream.active) {
+            k_work_schedule(&reliable_work, K_NO_WAIT);
+        }
+    } else if (!stream.active || stream.reliable_acked < stream.reliable_len ||
+               stream.stats.reliable_overflows > 0) {
+        // The GCS can not parse the data yet
+    } else if (is_due(data, len)) {
+        append_data(data, len);
+    } else {
+        stream.stats.messages_skipped++;
+    }
+
+    k_mutex_unlock(&stream_mutex);
+
+    return 0;
+}
+
+static int stream_sync(void *ctx) {
+    k_mutex_lock(&stream_mutex, K_FOREVER);
+
+    if (stream.active && stream.reliable_acked == stream.reliable_len) {
+        send_data_chunk();
+    }
+
+    k_mutex_unlock(&stream_mutex);
+
+    return 0;
+}
+
+// The next log starts with a new header
+static int stream_close(void *ctx) {
+    k_mutex_lock(&stream_mutex, K_FOREVER);
+
+    if (stream.active && stream.reliable_acked == stream.reliable_len) {
+        send_data_chunk();
+    }
+
+    stream.reliable_len = 0;
+    stream.reliable_acked = 0;
+    stream.ack_len = 0;
+    stream.stats.reliable_overflows = 0;
+    memset(stream.profile_us, 0, sizeof(stream.profile_us));
+
+    k_mutex_unlock(&stream_mutex);
+
+    return 0;
+}
+
+static const ULOG_Output_Type output = {
+    .write = stream_write,
+    .sync = stream_sync,
+    .close = stream_close,
+};
+
+const ULOG_Output_Type *log_stream_output(void) { return &output; }
+
+int log_stream_start(uint8_t chan, uint8_t target_system,
+                     uint8_t target_component) {
+    if (chan >= TELEMETRY_LINK_COUNT) {
+        return -EINVAL;
+    }
+
+    const uint32_t rate = telemetry_link_rate(chan);
+    if (rate == 0) {
+        return -ENODEV;
+    }
+
+    k_mutex_lock(&stream_mutex, K_FOREVER);
+
+    if (stream.stats.reliable_overflows > 0) {
+        k_mutex_unlock(&stream_mutex);
+        return -ENOMEM;
+    }
+
+    for (int i = 0; i < LOG_STREAM_MAX_TOPICS; i++) {
+        stream.interval_us[i] = (uint64_t)stream.profile_us[i] *
+                                CONFIG_APP_LOG_STREAM_PROFILE_RATE / rate;
+        stream.last_us[i] = 0;
+    }
+
+    stream.chan = chan;
+    stream.target_system = target_system;
+    stream.target_component = target_component;
+    stream.sequence = 0;
+    stream.reliable_acked = 0;
+    stream.ack_len = 0;
+    stream.chunk_len = 0;
+    stream.chunk_first_message = NO_MESSAGE_START;
+    stream.active = true;
+
+    k_mutex_unlock(&stream_mutex);
+
+    LOG_INF("Streaming the log on link %u", chan);
+
+    k_work_reschedule(&reliable_work, K_NO_WAIT);
+
+    return 0;
+}
+
+void log_stream_stop(void) {
+    k_mutex_lock(&stream_mutex, K_FOREVER);
+
+    stream.active = false;
+
+    k_mutex_unlock(&stream_mutex);
+
+    k_work_cancel_delayable(&reliable_work);
+}
+
+void log_stream_handle_ack(uint8_t chan, const mavlink_message_t *msg) {
+    mavlink_logging_ack_t ack;
+    mavlink_msg_logging_ack_decode(msg, &ack);
+
+    k_mutex_lock(&stream_mutex, K_FOREVER);
+
+    if (!stream.active || chan != stream.chan || stream.ack_len == 0 ||
+        ack.sequence != stream.ack_sequence) {
+        k_mutex_unlock(&stream_mutex);
+        return;
+    }
+
+    stream.reliable_acked += stream.ack_len;
+    stream.ack_len = 0;
+
+    k_mutex_unlock(&stream_mutex);
+
+    k_work_reschedule(&reliable_work, K_NO_WAIT);
+}
+
+static int cmd_log_stream_stats(const struct shell *sh, size_t argc,
+                                char **argv) {
+    shell_print(sh, "Stream %s, definitions: %u/%u bytes acknowledged",
+                stream.active ? "active" : "idle", stream.reliable_acked,
+                stream.reliable_len);
+    shell_print(sh, "Chunks sent: %u, dropped: %u, retransmitted: %u",
+                stream.stats.chunks_sent, stream.stats.chunks_dropped,
+                stream.stats.retransmits);
+    shell_print(sh, "Messages skipped by the rate profile: %u",
+                stream.stats.messages_skipped);
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    log_stream_cmds,
+    SHELL_CMD(stats, NULL, "Show log stream statistics", cmd_log_stream_stats),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(log_stream, &log_stream_cmds, "Live log streaming", NULL);
@@ -0,0 +1,36 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+
+#include "ulog.h"
+
+struct __mavlink_message;
+
+// ULOG output streaming the log to a GCS, written along with the log file
+const ULOG_Output_Type *log_stream_output(void);
+
+// Starts streaming the log on the link in LOGGING_DATA messages, from its
+// header on, as requested by MAV_CMD_LOGGING_START
+int log_stream_start(uint8_t chan, uint8_t target_system,
+                     uint8_t target_component);
+
+// Stops streaming the log, as requested by MAV_CMD_LOGGING_STOP
+void log_stream_stop(void);
+
+// LOGGING_ACK handler for the receiver dispatch table
+void log_stream_handle_ack(uint8_t chan, const struct __mavlink_message *msg);
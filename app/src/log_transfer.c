@@ -0,0 +1,454 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/util.h>
+
+// MAVLink headers
+// clang-format off
+#include "mavlink_custom.h" // Needs to be included before any MAVLink header inclusion
+#include "efc/mavlink.h"
+// clang-format on
+
+#include "log_transfer.h"
+#include "telemetry_link.h"
+
+LOG_MODULE_REGISTER(log_transfer);
+
+extern struct fs_mount_t main_fs_mount;
+
+#define LOG_DATA_LEN MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN
+#define LOG_DATA_FRAME_LEN                                                     \
+    (MAVLINK_NUM_NON_PAYLOAD_BYTES + MAVLINK_MSG_ID_LOG_DATA_LEN)
+#define LOG_ENTRY_FRAME_LEN                                                    \
+    (MAVLINK_NUM_NON_PAYLOAD_BYTES + MAVLINK_MSG_ID_LOG_ENTRY_LEN)
+
+// The transfer keeps at most this part of the bulk transmit ring filled, the
+// rest is left to the high rate telemetry streams
+#define LOG_TRANSFER_WINDOW_DIV 4
+
+// Retry period while the window is full
+#define LOG_TRANSFER_RETRY_MS 1
+
+// Whole requested range, as sent by the GCS
+#define LOG_TRANSFER_COUNT_ALL UINT32_MAX
+
+// Logs without a boot count are listed last
+#define LOG_NUMBER_TMP UINT16_MAX
+
+struct log_entry {
+    char name[sizeof("log_65535.ulg")];
+    uint16_t number;
+    uint32_t size;
+};
+
+struct log_transfer_stats {
+    uint32_t bytes_sent;
+    uint32_t resends;
+    uint32_t throughput_bps; // Of the last completed transfer
+};
+
+struct log_transfer {
+    struct log_entry entries[CONFIG_APP_LOG_TRANSFER_MAX_LOGS];
+    uint16_t entry_count;
+
+    // Listing, entries are sent by ID, which starts at one
+    bool list_requested;
+    bool listing;
+    uint8_t list_chan;
+    uint16_t list_next;
+    uint16_t list_end;
+
+    // Download of a range of one log
+    bool active;
+    uint8_t chan;
+    uint16_t id;
+    struct fs_file_t file;
+    bool file_open;
+    uint32_t ofs;
+    uint32_t end;
+    int64_t start_ms;
+    uint32_t start_bytes;
+
+    // Read ahead of the file, holding the data from buffer_ofs on
+    uint8_t buffer[CONFIG_APP_LOG_TRANSFER_BUFFER_SIZE];
+    uint32_t buffer_ofs;
+    uint32_t buffer_len;
+
+    struct log_transfer_stats stats;
+};
+
+static struct log_transfer transfer;
+
+// Guards the transfer state, which the receiver changes on requests
+static K_MUTEX_DEFINE(transfer_mutex);
+
+// The lowest priority, so flash reads never delay the flight threads
+K_THREAD_STACK_DEFINE(log_transfer_stack, 2048);
+static struct k_work_q log_transfer_wq;
+
+static void transfer_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(transfer_work, transfer_handler);
+
+static int compare_entries(const void *a, const void *b) {
+    const struct log_entry *entry_a = a;
+    const struct log_entry *entry_b = b;
+
+    return (int)entry_a->number - (int)entry_b->number;
+}
+
+// Lists log_<boot count>.ulg and log_tmp.ulg, ordered by the boot count
+static void scan_logs(void) {
+    struct fs_dir_t dir;
+    fs_dir_t_init(&dir);
+
+    transfer.entry_count = 0;
+
+    int ret = fs_opendir(&dir, main_fs_mount.mnt_point);
+    if (ret < 0) {
+        LOG_ERR("Could not open the log directory: %d", ret);
+        return;
+    }
+
+    struct fs_dirent entry;
+
+    while (transfer.entry_count < ARRAY_SIZE(transfer.entries)) {
+        ret = fs_readdir(&dir, &entry);
+        if (ret < 0 || entry.name[0] == '\0') {
+            break;
+        }
+
+        const size_t len = strlen(entry.name);
+        if (entry.type != FS_DIR_ENTRY_FILE || len < sizeof("log_.ulg") ||
+            len >= sizeof(transfer.entries[0].name) ||
+            strncmp(entry.name, "log_", 4) != 0 ||
+            strcmp(&entry.name[len - 4], ".ulg") != 0) {
+            continue;
+        }
+
+        struct log_entry *log = &transfer.entries[transfer.entry_count++];
+        strcpy(log->name, entry.name);
+        log->size = entry.size;
+        log->number = strcmp(entry.name, "log_tmp.ulg") == 0
+                          ? LOG_NUMBER_TMP
+                          : (uint16_t)strtoul(&entry.name[4], NULL, 10);
+    }
+
+    fs_closedir(&dir);
+
+    qsort(transfer.entries, transfer.entry_count, sizeof(transfer.entries[0]),
+          compare_entries);
+}
+
+// Whether a frame fits into the window of the bulk transmit ring
+static bool window_open(uint8_t chan, size_t frame_len) {
+    return telemetry_link_class_used(chan, TELEMETRY_CLASS_BULK) + frame_len <=
+           telemetry_link_class_size(chan, TELEMETRY_CLASS_BULK) /
+               LOG_TRANSFER_WINDOW_DIV;
+}
+
+static void send_entries(void) {
+    if (transfer.entry_count == 0) {
+        telemetry_link_lock(transfer.list_chan);
+        mavlink_msg_log_entry_send(transfer.list_chan, 0, 0, 0, 0, 0);
+        telemetry_link_unlock(transfer.list_chan);
+        transfer.listing = false;
+        return;
+    }
+
+    while (transfer.list_next <= transfer.list_end &&
+           window_open(transfer.list_chan, LOG_ENTRY_FRAME_LEN)) {
+        const struct log_entry *log = &transfer.entries[transfer.list_next - 1];
+
+        // Littlefs keeps no file times, so the time is not known
+        telemetry_link_lock(transfer.list_chan);
+        mavlink_msg_log_entry_send(transfer.list_chan, transfer.list_next,
+                                   transfer.entry_count, transfer.entry_count,
+                                   0, log->size);
+        telemetry_link_unlock(transfer.list_chan);
+        transfer.list_next++;
+    }
+
+    if (transfer.list_next > transfer.list_end) {
+        transfer.listing = false;
+    }
+}
+
+static void close_log(void) {
+    if (transfer.file_open) {
+        fs_close(&transfer.file);
+        transfer.file_open = false;
+    }
+
+    // A reopened file is read from its start, which is where the buffer of
+    // the next read ahead continues
+    transfer.buffer_ofs = 0;
+    transfer.buffer_len = 0;
+}
+
+static void finish_download(void) {
+    const uint32_t elapsed_ms = k_uptime_get() - transfer.start_ms;
+    const uint32_t bytes = transfer.stats.bytes_sent - transfer.start_bytes;
+
+    if (elapsed_ms > 0) {
+        transfer.stats.throughput_bps =
+            (uint64_t)bytes * MSEC_PER_SEC / elapsed_ms;
+    }
+
+    LOG_INF("Sent %u bytes of log %u in %u ms, %u bytes/s", bytes,
+            transfer.id, elapsed_ms, transfer.stats.throughput_bps);
+
+    transfer.active = false;
+}
+
+// Makes sure the buffer holds data at the offset, returns the bytes held from
+// it on, zero at the end of the file
+static int read_ahead(void) {
+    if (transfer.ofs >= transfer.buffer_ofs &&
+        transfer.ofs < transfer.buffer_ofs + transfer.buffer_len) {
+        return transfer.buffer_ofs + transfer.buffer_len - transfer.ofs;
+    }
+
+    // Sequential reads continue where the last one ended
+    if (transfer.ofs != transfer.buffer_ofs + transfer.buffer_len) {
+        int ret = fs_seek(&transfer.file, transfer.ofs, FS_SEEK_SET);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+
+    const ssize_t len =
+        fs_read(&transfer.file, transfer.buffer, sizeof(transfer.buffer));
+    if (len < 0) {
+        return len;
+    }
+
+    transfer.buffer_ofs = transfer.ofs;
+    transfer.buffer_len = len;
+
+    return len;
+}
+
+static void send_data(void) {
+    uint8_t data[LOG_DATA_LEN];
+
+    while (transfer.ofs < transfer.end &&
+           window_open(transfer.chan, LOG_DATA_FRAME_LEN)) {
+        const int available = read_ahead();
+        if (available < 0) {
+            LOG_ERR("Could not read log %u: %d", transfer.id, available);
+            finish_download();
+            return;
+        }
+
+        // Past the end of the file an empty chunk ends the transfer
+        const uint8_t count = MIN(MIN((uint32_t)available, LOG_DATA_LEN),
+                                  transfer.end - transfer.ofs);
+
+        memset(data, 0, sizeof(data));
+        memcpy(data, &transfer.buffer[transfer.ofs - transfer.buffer_ofs],
+               count);
+
+        telemetry_link_lock(transfer.chan);
+
+        const uint32_t dropped = telemetry_link_dropped(transfer.chan);
+
+        mavlink_msg_log_data_send(transfer.chan, transfer.id, transfer.ofs,
+                                  count, data);
+
+        const bool sent = telemetry_link_dropped(transfer.chan) == dropped;
+
+        telemetry_link_unlock(transfer.chan);
+
+        // Another sender took the space in between, the chunk is sent again
+        if (!sent) {
+            transfer.stats.resends++;
+            return;
+        }
+
+        transfer.stats.bytes_sent += count;
+
+        if (count == 0) {
+            finish_download();
+            return;
+        }
+
+        transfer.ofs += count;
+    }
+
+    if (transfer.ofs >= transfer.end) {
+        finish_download();
+    }
+}
+
+static void transfer_handler(struct k_work *work) {
+    k_mutex_lock(&transfer_mutex, K_FOREVER);
+
+    if (transfer.list_requested) {
+        transfer.list_requested = false;
+        scan_logs();
+        transfer.list_end = MIN(transfer.list_end, transfer.entry_count);
+        transfer.listing = true;
+    }
+
+    if (transfer.listing) {
+        send_entries();
+    }
+
+    if (transfer.active) {
+        send_data();
+    }
+
+    // Until the window opens again
+    if (transfer.listing || transfer.active) {
+        k_work_reschedule_for_queue(&log_transfer_wq, &transfer_work,
+                                    K_MSEC(LOG_TRANSFER_RETRY_MS));
+    }
+
+    k_mutex_unlock(&transfer_mutex);
+}
+
+int log_transfer_init(void) {
+    k_work_queue_start(&log_transfer_wq, log_transfer_stack,
+                       K_THREAD_STACK_SIZEOF(log_transfer_stack),
+                       K_LOWEST_APPLICATION_THREAD_PRIO, NULL);
+    k_thread_name_set(&log_transfer_wq.thread, "log_transfer");
+
+    fs_file_t_init(&transfer.file);
+
+    return 0;
+}
+
+static bool is_for_us(uint8_t target_system) {
+    return target_system == 0 || target_system == mavlink_system.sysid;
+}
+
+void log_transfer_handle_request_list(uint8_t chan,
+                                      const mavlink_message_t *msg) {
+    mavlink_log_request_list_t req;
+    mavlink_msg_log_request_list_decode(msg, &req);
+
+    if (!is_for_us(req.target_system)) {
+        return;
+    }
+
+    k_mutex_lock(&transfer_mutex, K_FOREVER);
+
+    // The end is clamped to the last log once the logs are scanned
+    transfer.list_requested = true;
+    transfer.list_chan = chan;
+    transfer.list_next = MAX(req.start, 1);
+    transfer.list_end = req.end;
+
+    k_mutex_unlock(&transfer_mutex);
+
+    k_work_reschedule_for_queue(&log_transfer_wq, &transfer_work, K_NO_WAIT);
+}
+
+void log_transfer_handle_request_data(uint8_t chan,
+                                      const mavlink_message_t *msg) {
+    mavlink_log_request_data_t req;
+    mavlink_msg_log_request_data_decode(msg, &req);
+
+    if (!is_for_us(req.target_system)) {
+        return;
+    }
+
+    k_mutex_lock(&transfer_mutex, K_FOREVER);
+
+    if (req.id == 0 || req.id > transfer.entry_count) {
+        LOG_WRN("Requested log %u is not listed", req.id);
+        k_mutex_unlock(&transfer_mutex);
+        return;
+    }
+
+    const struct log_entry *log = &transfer.entries[req.id - 1];
+
+    // Missed ranges are requested again, from the file already open
+    if (!transfer.file_open || transfer.id != req.id) {
+        close_log();
+
+        char path[MAX_FILE_NAME + 1];
+        snprintf(path, sizeof(path), "%s/%s", main_fs_mount.mnt_point,
+                 log->name);
+
+        int ret = fs_open(&transfer.file, path, FS_O_READ);
+        if (ret < 0) {
+            LOG_ERR("Could not open %s: %d", path, ret);
+            k_mutex_unlock(&transfer_mutex);
+            return;
+        }
+
+        transfer.file_open = true;
+    }
+
+    // The log being written grows, the listed size is only a hint
+    transfer.chan = chan;
+    transfer.id = req.id;
+    transfer.ofs = req.ofs;
+    transfer.end = req.count == LOG_TRANSFER_COUNT_ALL ||
+                           req.count > UINT32_MAX - req.ofs
+                       ? UINT32_MAX
+                       : req.ofs + req.count;
+
+    if (!transfer.active) {
+        transfer.active = true;
+        transfer.start_ms = k_uptime_get();
+        transfer.start_bytes = transfer.stats.bytes_sent;
+    }
+
+    k_mutex_unlock(&transfer_mutex);
+
+    k_work_reschedule_for_queue(&log_transfer_wq, &transfer_work, K_NO_WAIT);
+}
+
+void log_transfer_handle_request_end(uint8_t chan,
+                                     const mavlink_message_t *msg) {
+    k_mutex_lock(&transfer_mutex, K_FOREVER);
+
+    transfer.active = false;
+    transfer.listing = false;
+    close_log();
+
+    k_mutex_unlock(&transfer_mutex);
+}
+
+static int cmd_log_transfer_stats(const struct shell *sh, size_t argc,
+                                  char **argv) {
+    shell_print(sh, "Logs: %u, transfer %s", transfer.entry_count,
+                transfer.active ? "active" : "idle");
+    shell_print(sh, "Sent: %u bytes, resent chunks: %u",
+                transfer.stats.bytes_sent, transfer.stats.resends);
+    shell_print(sh, "Throughput of the last transfer: %u bytes/s",
+                transfer.stats.throughput_bps);
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    log_transfer_cmds,
+    SHELL_CMD(stats, NULL, "Show log download statistics",
+              cmd_log_transfer_stats),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(log_transfer, &log_transfer_cmds, "Log download", NULL);
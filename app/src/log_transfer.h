@@ -0,0 +1,31 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+
+struct __mavlink_message;
+
+// Starts the background work queue which lists and sends the logs
+int log_transfer_init(void);
+
+// Log transfer protocol handlers for the receiver dispatch table
+void log_transfer_handle_request_list(uint8_t chan,
+                                      const struct __mavlink_message *msg);
+void log_transfer_handle_request_data(uint8_t chan,
+                                      const struct __mavlink_message *msg);
+void log_transfer_handle_request_end(uint8_t chan,
+                                     const struct __mavlink_message *msg);
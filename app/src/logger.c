@@ -15,7 +15,6 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <math.h>
 #include <zephyr/device.h>
 #include <zephyr/fs/fs.h>
 #include <zephyr/fs/littlefs.h>
@@ -26,25 +25,39 @@
 #include "ulog.h"
 #include "ulog_accel.h"
 #include "ulog_altitude.h"
+#include "ulog_attitude.h"
 #include "ulog_baro.h"
+#include "ulog_battery.h"
+#include "ulog_dyn_notch.h"
 #include "ulog_gyro.h"
+#include "ulog_latency.h"
+#include "ulog_motor.h"
+#include "ulog_rate_control.h"
 
+#include "log_stream.h"
+#include "params.h"
 #include "types.h"
 
 LOG_MODULE_REGISTER(logger);
 
 ZBUS_CHAN_DECLARE(imu_chan);
 ZBUS_CHAN_DECLARE(baro_chan);
+ZBUS_CHAN_DECLARE(dyn_notch_chan);
+ZBUS_CHAN_DECLARE(attitude_chan);
+ZBUS_CHAN_DECLARE(vertical_state_chan);
+ZBUS_CHAN_DECLARE(battery_chan);
+ZBUS_CHAN_DECLARE(motor_chan);
+ZBUS_CHAN_DECLARE(rate_control_chan);
+#ifdef CONFIG_APP_LATENCY_TRACE
+ZBUS_CHAN_DECLARE(latency_chan);
+#endif
 
 ZBUS_CHAN_DEFINE(sync_chan, bool, NULL, NULL, ZBUS_OBSERVERS(logger_sub), 0);
 
 ZBUS_SUBSCRIBER_DEFINE_WITH_ENABLE(logger_sub, 16, false);
 
-// Value derrived from BMP280 datasheet (page 15 of 49) for the given sensor
-// configuration.
-#define BMP280_ALTITUDE_VARIANCE_M .017f
-
 #define ALTITUDE_SOURCE_TYPE_BARO 1
+#define ALTITUDE_SOURCE_TYPE_BARO_IMU 2
 
 extern int32_t boot_count;
 
@@ -57,7 +70,19 @@ static ULOG_Inst_Type ulog_log;
 static uint16_t gyro_msg_id = 0;
 static uint16_t accel_msg_id = 0;
 static uint16_t baro_msg_id = 0;
-static uint16_t baro_alt_msg_id = 0;
+static uint16_t altitude_msg_id = 0;
+static uint16_t dyn_notch_msg_id = 0;
+static uint16_t attitude_msg_id = 0;
+static uint16_t battery_msg_id = 0;
+static uint16_t motor_msg_id = 0;
+static uint16_t rate_control_msg_id = 0;
+static uint16_t latency_msg_id = 0;
+
+static void start_sync_timer(void) {
+    const k_timeout_t interval = K_MSEC(param_get_int32(PARAM_LOG_SYNC_MS));
+
+    k_timer_start(&sync_timer, interval, interval);
+}
 
 static void sync_notify(struct k_timer *timer_id) {
     int ret = zbus_chan_notify(&sync_chan, K_NO_WAIT);
@@ -80,9 +105,18 @@ void logger(void *dummy1, void *dummy2, void *dummy3) {
 
     ULOG_Config_Type log_cfg = {
         .filename = filename,
+        .output = log_stream_output(),
     };
 
-    if (ULOG_Init(&ulog_log, &log_cfg) != ULOG_SUCCESS) {
+    ULOG_Error_Type status = ULOG_Init(&ulog_log, &log_cfg);
+    if (status == ULOG_FILESYSTEM_ERROR) {
+        // The log can still be streamed to a GCS
+        LOG_ERR("Could not open log file! Proceeding with streaming only.");
+        log_cfg.filename = NULL;
+        status = ULOG_Init(&ulog_log, &log_cfg);
+    }
+
+    if (status != ULOG_SUCCESS) {
         LOG_ERR("Could not open log! Proceeding without logging.");
         zbus_obs_set_enable(&logger_sub, false);
         return;
@@ -104,6 +138,32 @@ void logger(void *dummy1, void *dummy2, void *dummy3) {
         LOG_ERR("Could not register ULOG altitude format!");
     }
 
+    if (ULOG_Dyn_Notch_RegisterFormat(&ulog_log) != ULOG_SUCCESS) {
+        LOG_ERR("Could not register ULOG dynamic notch format!");
+    }
+
+    if (ULOG_Attitude_RegisterFormat(&ulog_log) != ULOG_SUCCESS) {
+        LOG_ERR("Could not register ULOG attitude format!");
+    }
+
+    if (ULOG_Battery_RegisterFormat(&ulog_log) != ULOG_SUCCESS) {
+        LOG_ERR("Could not register ULOG battery format!");
+    }
+
+    if (ULOG_Motor_RegisterFormat(&ulog_log) != ULOG_SUCCESS) {
+        LOG_ERR("Could not register ULOG motor format!");
+    }
+
+    if (ULOG_Rate_Control_RegisterFormat(&ulog_log) != ULOG_SUCCESS) {
+        LOG_ERR("Could not register ULOG rate control format!");
+    }
+
+#ifdef CONFIG_APP_LATENCY_TRACE
+    if (ULOG_Latency_RegisterFormat(&ulog_log) != ULOG_SUCCESS) {
+        LOG_ERR("Could not register ULOG latency format!");
+    }
+#endif
+
     const char alt_src_type_baro_key[] = "int32_t ALTITUDE_SOURCE_TYPE_BARO";
     const int32_t alt_src_type_baro = ALTITUDE_SOURCE_TYPE_BARO;
     if (ULOG_AddParameter(&ulog_log, alt_src_type_baro_key,
@@ -111,6 +171,15 @@ void logger(void *dummy1, void *dummy2, void *dummy3) {
         LOG_ERR("Could not write Altitude Source Type Baro parameter!");
     }
 
+    const char alt_src_type_baro_imu_key[] =
+        "int32_t ALTITUDE_SOURCE_TYPE_BARO_IMU";
+    const int32_t alt_src_type_baro_imu = ALTITUDE_SOURCE_TYPE_BARO_IMU;
+    if (ULOG_AddParameter(&ulog_log, alt_src_type_baro_imu_key,
+                          strlen(alt_src_type_baro_imu_key),
+                          &alt_src_type_baro_imu)) {
+        LOG_ERR("Could not write Altitude Source Type Baro IMU parameter!");
+    }
+
     const char sys_name_key[] = "char[3] sys_name";
     const char sys_name[] = "EFC";
     if (ULOG_AddInfo(&ulog_log, sys_name_key, strlen(sys_name_key), sys_name,
@@ -131,7 +200,7 @@ void logger(void *dummy1, void *dummy2, void *dummy3) {
     }
 
     const char main_baro_name_key[] = "char[6] main_baro_name";
-    const char main_baro_name[] = "BMP280";
+    const char main_baro_name[] = "BME280";
     if (ULOG_AddInfo(&ulog_log, main_baro_name_key, strlen(main_baro_name_key),
                      main_baro_name, strlen(main_baro_name))) {
         LOG_ERR("Could not write main baro info to the log!");
@@ -153,14 +222,46 @@ void logger(void *dummy1, void *dummy2, void *dummy3) {
         LOG_ERR("Could not subscribe ULog baro message!");
     }
 
-    if (ULOG_Altitude_Subscribe(&ulog_log, 0, &baro_alt_msg_id) !=
+    if (ULOG_Altitude_Subscribe(&ulog_log, 0, &altitude_msg_id) !=
         ULOG_SUCCESS) {
         LOG_ERR("Could not subscribe ULog altitude message!");
     }
 
+    if (ULOG_Dyn_Notch_Subscribe(&ulog_log, 0, &dyn_notch_msg_id) !=
+        ULOG_SUCCESS) {
+        LOG_ERR("Could not subscribe ULog dynamic notch message!");
+    }
+
+    if (ULOG_Attitude_Subscribe(&ulog_log, 0, &attitude_msg_id) !=
+        ULOG_SUCCESS) {
+        LOG_ERR("Could not subscribe ULog attitude message!");
+    }
+
+    if (ULOG_Battery_Subscribe(&ulog_log, 0, &battery_msg_id) !=
+        ULOG_SUCCESS) {
+        LOG_ERR("Could not subscribe ULog battery message!");
+    }
+
+    if (ULOG_Motor_Subscribe(&ulog_log, 0, &motor_msg_id) != ULOG_SUCCESS) {
+        LOG_ERR("Could not subscribe ULog motor message!");
+    }
+
+    if (ULOG_Rate_Control_Subscribe(&ulog_log, 0, &rate_control_msg_id) !=
+        ULOG_SUCCESS) {
+        LOG_ERR("Could not subscribe ULog rate control message!");
+    }
+
+#ifdef CONFIG_APP_LATENCY_TRACE
+    if (ULOG_Latency_Subscribe(&ulog_log, 0, &latency_msg_id) !=
+        ULOG_SUCCESS) {
+        LOG_ERR("Could not subscribe ULog latency message!");
+    }
+#endif
+
     k_timer_init(&sync_timer, sync_notify, NULL);
-    k_timer_start(&sync_timer, K_MSEC(CONFIG_APP_DATA_LOGGING_SYNC_INTERVAL),
-                  K_MSEC(CONFIG_APP_DATA_LOGGING_SYNC_INTERVAL));
+    start_sync_timer();
+
+    uint32_t param_generation_seen = param_generation();
 
     zbus_obs_set_enable(&logger_sub, true);
 
@@ -209,20 +310,128 @@ void logger(void *dummy1, void *dummy2, void *dummy3) {
             };
 
             ULOG_Baro_Write(&ulog_log, &baro_msg, baro_msg_id);
-
-            const float altitude =
-                44330.0f *
-                (1.0f - powf((msg.pressure_kpa / 101.325f), 1.0f / 5.255f));
+        } else if (chan == &vertical_state_chan) {
+            struct vertical_state_data msg;
+            ret = zbus_chan_read(chan, &msg, K_USEC(1));
+            if (ret < 0) {
+                LOG_ERR("Failed to read from logger subscriber!");
+            }
 
             ULOG_Altitude_Type altitude_msg = {
                 .timestamp = msg.timestamp_us,
-                .source = ALTITUDE_SOURCE_TYPE_BARO,
-                .altitude = altitude,
-                .variance = BMP280_ALTITUDE_VARIANCE_M};
+                .source = ALTITUDE_SOURCE_TYPE_BARO_IMU,
+                .altitude = msg.altitude_m,
+                .velocity = msg.velocity_mps,
+                .variance = msg.altitude_variance_m2,
+            };
+
+            ULOG_Altitude_Write(&ulog_log, &altitude_msg, altitude_msg_id);
+        } else if (chan == &dyn_notch_chan) {
+            struct dyn_notch_data msg;
+            ret = zbus_chan_read(chan, &msg, K_USEC(1));
+            if (ret < 0) {
+                LOG_ERR("Failed to read from logger subscriber!");
+            }
+
+            ULOG_Dyn_Notch_Type dyn_notch_msg = {
+                .timestamp = msg.timestamp_us,
+                .x = msg.center_freq_hz[0],
+                .y = msg.center_freq_hz[1],
+                .z = msg.center_freq_hz[2],
+                .max_step_cycles = msg.max_step_cycles,
+            };
+
+            ULOG_Dyn_Notch_Write(&ulog_log, &dyn_notch_msg, dyn_notch_msg_id);
+        } else if (chan == &attitude_chan) {
+            struct attitude_data msg;
+            ret = zbus_chan_read(chan, &msg, K_USEC(1));
+            if (ret < 0) {
+                LOG_ERR("Failed to read from logger subscriber!");
+            }
+
+            ULOG_Attitude_Type attitude_msg = {
+                .timestamp = msg.timestamp_us,
+                .q = msg.q,
+            };
+
+            ULOG_Attitude_Write(&ulog_log, &attitude_msg, attitude_msg_id);
+        } else if (chan == &battery_chan) {
+            struct battery_data msg;
+            ret = zbus_chan_read(chan, &msg, K_USEC(1));
+            if (ret < 0) {
+                LOG_ERR("Failed to read from logger subscriber!");
+            }
+
+            ULOG_Battery_Type battery_msg = {
+                .timestamp = msg.timestamp_us,
+                .voltage = msg.voltage_v,
+                .current = msg.current_a,
+                .resting_voltage = msg.resting_voltage_v,
+                .remaining = msg.remaining,
+            };
+
+            ULOG_Battery_Write(&ulog_log, &battery_msg, battery_msg_id);
+        } else if (chan == &motor_chan) {
+            struct motor_data msg;
+            ret = zbus_chan_read(chan, &msg, K_USEC(1));
+            if (ret < 0) {
+                LOG_ERR("Failed to read from logger subscriber!");
+            }
+
+            ULOG_Motor_Type motor_msg = {
+                .timestamp = msg.timestamp_us,
+                .output = msg.output,
+                .rpm = msg.rpm,
+            };
+
+            ULOG_Motor_Write(&ulog_log, &motor_msg, motor_msg_id);
+        } else if (chan == &rate_control_chan) {
+            struct rate_control_data msg;
+            ret = zbus_chan_read(chan, &msg, K_USEC(1));
+            if (ret < 0) {
+                LOG_ERR("Failed to read from logger subscriber!");
+            }
+
+            ULOG_Rate_Control_Type rate_control_msg = {
+                .timestamp = msg.timestamp_us,
+                .setpoint = msg.setpoint_radps,
+                .torque = msg.torque,
+                .iterations = msg.iterations,
+                .deadline_misses = msg.deadline_misses,
+                .samples_missed = msg.samples_missed,
+                .exec_time_max = msg.exec_time_max_us,
+                .exec_time_hist = msg.exec_time_hist,
+                .period_hist = msg.period_hist,
+            };
+
+            ULOG_Rate_Control_Write(&ulog_log, &rate_control_msg,
+                                    rate_control_msg_id);
+#ifdef CONFIG_APP_LATENCY_TRACE
+        } else if (chan == &latency_chan) {
+            struct latency_data msg;
+            ret = zbus_chan_read(chan, &msg, K_USEC(1));
+            if (ret < 0) {
+                LOG_ERR("Failed to read from logger subscriber!");
+            }
 
-            ULOG_Altitude_Write(&ulog_log, &altitude_msg, baro_alt_msg_id);
+            ULOG_Latency_Type latency_msg = {
+                .timestamp = msg.timestamp_us,
+                .count = msg.count,
+                .p50 = msg.p50_us,
+                .p99 = msg.p99_us,
+                .max = msg.max_us,
+            };
+
+            ULOG_Latency_Write(&ulog_log, &latency_msg, latency_msg_id);
+#endif
         } else if (chan == &sync_chan) {
             ULOG_Sync(&ulog_log);
+
+            // A changed sync interval takes effect from the next sync
+            if (param_generation() != param_generation_seen) {
+                param_generation_seen = param_generation();
+                start_sync_timer();
+            }
         }
     }
 }
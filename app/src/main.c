@@ -33,24 +33,40 @@
 #include <zephyr/usb/usbd.h>
 #include <zephyr/zbus/zbus.h>
 
+#include "cic.h"
+
+#include "attitude_estimator.h"
+#include "battery_monitor.h"
+#include "imu_filter.h"
+#include "latency.h"
+#include "log_transfer.h"
 #include "logger.h"
 #include "radio_receiver.h"
+#include "rate_controller.h"
 #include "telemetry_packer.h"
+#include "telemetry_receiver.h"
 #include "telemetry_sender.h"
+#include "telemetry_usb.h"
+#include "vertical_estimator.h"
 
 #include "nvs_ids.h"
+#include "params.h"
 #include "types.h"
 
 LOG_MODULE_REGISTER(main);
 
+ZBUS_OBS_DECLARE(imu_filter_sub);
 ZBUS_OBS_DECLARE(logger_sub);
-ZBUS_OBS_DECLARE(telemetry_packer_sub);
+ZBUS_OBS_DECLARE(telemetry_imu_batch_lis);
+ZBUS_OBS_DECLARE(vertical_estimator_sub);
 
 ZBUS_CHAN_DEFINE(imu_chan, struct imu_6dof_data, NULL, NULL,
-                 ZBUS_OBSERVERS(logger_sub, telemetry_packer_sub), {0});
+                 ZBUS_OBSERVERS(imu_filter_sub, logger_sub,
+                                telemetry_imu_batch_lis),
+                 {0});
 
 ZBUS_CHAN_DEFINE(baro_chan, struct baro_data, NULL, NULL,
-                 ZBUS_OBSERVERS(logger_sub, telemetry_packer_sub), {0});
+                 ZBUS_OBSERVERS(vertical_estimator_sub, logger_sub), {0});
 
 // This LED simply blinks at an interval, indicating visually that the firmware
 // is running If anything causes the whole firmware to abort, it will be
@@ -76,8 +92,25 @@ static struct nvs_fs nvs;
 #define NVS_PARTITION_OFFSET FIXED_PARTITION_OFFSET(NVS_PARTITION)
 #define NVS_SECTOR_COUNT 4
 
-struct k_pipe telemetry_ground_pipe;
-static uint8_t telemetry_ground_pipe_data[1024];
+// The IMU is sampled faster than the control rate and decimated, so the extra
+// samples reduce noise instead of being discarded
+static CIC_Inst_Type gyro_decimator;
+static CIC_Inst_Type accel_decimator;
+
+K_THREAD_STACK_DEFINE(imu_filter_thread_stack, 2048);
+static struct k_thread imu_filter_thread;
+
+K_THREAD_STACK_DEFINE(attitude_estimator_thread_stack, 1024);
+static struct k_thread attitude_estimator_thread;
+
+K_THREAD_STACK_DEFINE(vertical_estimator_thread_stack, 1024);
+static struct k_thread vertical_estimator_thread;
+
+K_THREAD_STACK_DEFINE(battery_monitor_thread_stack, 1024);
+static struct k_thread battery_monitor_thread;
+
+K_THREAD_STACK_DEFINE(rate_controller_thread_stack, 2048);
+static struct k_thread rate_controller_thread;
 
 K_THREAD_STACK_DEFINE(radio_thread_stack, 1024);
 static struct k_thread radio_thread;
@@ -85,8 +118,8 @@ static struct k_thread radio_thread;
 K_THREAD_STACK_DEFINE(telemetry_packer_thread_stack, 2048);
 static struct k_thread telemetry_packer_thread;
 
-K_THREAD_STACK_DEFINE(telemetry_sender_thread_stack, 1024);
-static struct k_thread telemetry_sender_thread;
+K_THREAD_STACK_DEFINE(telemetry_receiver_thread_stack, 2048);
+static struct k_thread telemetry_receiver_thread;
 
 K_THREAD_STACK_DEFINE(logger_thread_stack, 8192);
 static struct k_thread logger_thread;
@@ -111,14 +144,38 @@ static int enable_usb_device_next(void) {
 }
 #endif /* defined(CONFIG_USB_DEVICE_STACK_NEXT) */
 
-static int process_imu(const struct device *dev) {
+static int init_imu_decimation(void) {
+    const CIC_Config_Type cfg = {
+        .order = CONFIG_APP_IMU_DECIMATION_ORDER,
+        .ratio = CONFIG_APP_IMU_DECIMATION_RATIO,
+        .input_rate_hz =
+            CONFIG_APP_IMU_RATE_HZ * CONFIG_APP_IMU_DECIMATION_RATIO,
+        .output_scale = 1e-6f, // Samples are fed in micro units
+    };
+
+    if (CIC_Init(&gyro_decimator, &cfg) != CIC_SUCCESS) {
+        return -EINVAL;
+    }
+
+    if (CIC_Init(&accel_decimator, &cfg) != CIC_SUCCESS) {
+        return -EINVAL;
+    }
+
+    return 0;
+}
+
+// Polled samples come at the main loop rate, far below the decimator input
+// rate, so they bypass it instead of being decimated further
+static int process_imu(const struct device *dev, bool decimate) {
+    const uint32_t origin_cycles = latency_sample_origin();
+
     int ret = sensor_sample_fetch(dev);
     if (ret < 0) {
         LOG_ERR("Could not fetch data from IMU!");
         return ret;
     }
 
-    const int64_t timestamp_ms = k_uptime_get();
+    const uint64_t timestamp_us = k_ticks_to_us_floor64(k_uptime_ticks());
 
     struct sensor_value accel[3];
     ret = sensor_channel_get(dev, SENSOR_CHAN_ACCEL_XYZ, accel);
@@ -134,6 +191,31 @@ static int process_imu(const struct device *dev) {
         return ret;
     }
 
+    int32_t accel_micro[3];
+    int32_t gyro_micro[3];
+    for (int i = 0; i < 3; i++) {
+        accel_micro[i] = (int32_t)sensor_value_to_micro(&accel[i]);
+        gyro_micro[i] = (int32_t)sensor_value_to_micro(&gyro[i]);
+    }
+
+    CIC_Output_Type accel_out;
+    CIC_Output_Type gyro_out;
+    if (decimate) {
+        // Both decimators are fed in lockstep, so their outputs are ready
+        // together
+        CIC_Push(&accel_decimator, accel_micro, timestamp_us, &accel_out);
+        if (!CIC_Push(&gyro_decimator, gyro_micro, timestamp_us, &gyro_out)) {
+            return 0;
+        }
+    } else {
+        accel_out.timestamp_us = timestamp_us;
+        gyro_out.timestamp_us = timestamp_us;
+        for (int i = 0; i < 3; i++) {
+            accel_out.value[i] = sensor_value_to_float(&accel[i]);
+            gyro_out.value[i] = sensor_value_to_float(&gyro[i]);
+        }
+    }
+
     struct sensor_value temperature;
     ret = sensor_channel_get(dev, SENSOR_CHAN_DIE_TEMP, &temperature);
     if (ret < 0) {
@@ -141,13 +223,14 @@ static int process_imu(const struct device *dev) {
     }
 
     const struct imu_6dof_data msg = {
-        .timestamp_us = timestamp_ms * 1000,
-        .accel_mps2[0] = sensor_value_to_float(&accel[0]),
-        .accel_mps2[1] = sensor_value_to_float(&accel[1]),
-        .accel_mps2[2] = sensor_value_to_float(&accel[2]),
-        .gyro_radps[0] = sensor_value_to_float(&gyro[0]),
-        .gyro_radps[1] = sensor_value_to_float(&gyro[1]),
-        .gyro_radps[2] = sensor_value_to_float(&gyro[2]),
+        .timestamp_us = gyro_out.timestamp_us,
+        .origin_cycles = origin_cycles,
+        .accel_mps2[0] = accel_out.value[0],
+        .accel_mps2[1] = accel_out.value[1],
+        .accel_mps2[2] = accel_out.value[2],
+        .gyro_radps[0] = gyro_out.value[0],
+        .gyro_radps[1] = gyro_out.value[1],
+        .gyro_radps[2] = gyro_out.value[2],
         .temperature_degc = sensor_value_to_float(&temperature),
     };
 
@@ -156,13 +239,15 @@ static int process_imu(const struct device *dev) {
         LOG_ERR("Failed to send imu message on zbus!");
     }
 
+    latency_record(LATENCY_STAGE_READ, origin_cycles);
+
     return 0;
 }
 
 #ifdef CONFIG_ICM4268X_TRIGGER
 static void handle_icm42688p_drdy(const struct device *dev,
                                   const struct sensor_trigger *trig) {
-    process_imu(dev);
+    process_imu(dev, true);
 }
 #endif
 
@@ -260,6 +345,17 @@ int main(void) {
         return 0;
     }
 
+    ret = init_imu_decimation();
+    if (ret < 0) {
+        LOG_ERR("Could not initialize IMU decimation!");
+        return 0;
+    }
+
+    ret = latency_init();
+    if (ret < 0) {
+        LOG_ERR("Could not initialize latency tracing!");
+    }
+
     bool main_imu_using_trigger = false;
 
 #if CONFIG_APP_PRIMARY_IMU_MPU6050
@@ -334,41 +430,90 @@ int main(void) {
         LOG_ERR("Could not update boot count!");
     }
 
-    k_pipe_init(&telemetry_ground_pipe, telemetry_ground_pipe_data,
-                sizeof(telemetry_ground_pipe_data));
+    ret = param_init(&nvs);
+    if (ret < 0) {
+        LOG_ERR("Could not load parameters, using the defaults!");
+    }
+
+    ret = telemetry_sender_init();
+    if (ret < 0) {
+        LOG_ERR("Could not initialize the ground telemetry link!");
+    }
+
+    ret = log_transfer_init();
+    if (ret < 0) {
+        LOG_ERR("Could not initialize the log download!");
+    }
+
+#ifdef CONFIG_APP_TELEMETRY_USB
+    ret = telemetry_usb_init();
+    if (ret < 0) {
+        LOG_ERR("Could not initialize the USB telemetry link!");
+    }
+#endif
+
+    // Cooperative, so no other thread preempts an iteration between the gyro
+    // sample and the motor output
+    k_thread_create(&rate_controller_thread, rate_controller_thread_stack,
+                    K_THREAD_STACK_SIZEOF(rate_controller_thread_stack),
+                    rate_controller, NULL, NULL, NULL, -1, 0, K_NO_WAIT);
+
+    k_thread_create(&imu_filter_thread, imu_filter_thread_stack,
+                    K_THREAD_STACK_SIZEOF(imu_filter_thread_stack), imu_filter,
+                    NULL, NULL, NULL, 0, 0, K_NO_WAIT);
+
+    k_thread_create(&attitude_estimator_thread,
+                    attitude_estimator_thread_stack,
+                    K_THREAD_STACK_SIZEOF(attitude_estimator_thread_stack),
+                    attitude_estimator, NULL, NULL, NULL, 1, 0, K_NO_WAIT);
+
+    k_thread_create(&vertical_estimator_thread,
+                    vertical_estimator_thread_stack,
+                    K_THREAD_STACK_SIZEOF(vertical_estimator_thread_stack),
+                    vertical_estimator, NULL, NULL, NULL, 2, 0, K_NO_WAIT);
+
+    k_thread_create(&battery_monitor_thread, battery_monitor_thread_stack,
+                    K_THREAD_STACK_SIZEOF(battery_monitor_thread_stack),
+                    battery_monitor, NULL, NULL, NULL,
+                    K_LOWEST_APPLICATION_THREAD_PRIO - 3, 0, K_NO_WAIT);
 
     k_thread_create(&radio_thread, radio_thread_stack,
                     K_THREAD_STACK_SIZEOF(radio_thread_stack), radio_receiver,
                     NULL, NULL, NULL, 0, 0, K_NO_WAIT);
 
-    k_thread_create(&telemetry_sender_thread, telemetry_sender_thread_stack,
-                    K_THREAD_STACK_SIZEOF(telemetry_sender_thread_stack),
-                    telemetry_sender, NULL, NULL, NULL,
-                    K_LOWEST_APPLICATION_THREAD_PRIO - 2, 0, K_NO_WAIT);
-
     k_thread_create(&telemetry_packer_thread, telemetry_packer_thread_stack,
                     K_THREAD_STACK_SIZEOF(telemetry_packer_thread_stack),
                     telemetry_packer, NULL, NULL, NULL,
                     K_LOWEST_APPLICATION_THREAD_PRIO - 1, 0, K_NO_WAIT);
 
+    k_thread_create(&telemetry_receiver_thread,
+                    telemetry_receiver_thread_stack,
+                    K_THREAD_STACK_SIZEOF(telemetry_receiver_thread_stack),
+                    telemetry_receiver, NULL, NULL, NULL,
+                    K_LOWEST_APPLICATION_THREAD_PRIO - 1, 0, K_NO_WAIT);
+
     k_thread_create(&logger_thread, logger_thread_stack,
                     K_THREAD_STACK_SIZEOF(logger_thread_stack), logger, NULL,
                     NULL, NULL, K_LOWEST_APPLICATION_THREAD_PRIO, 0, K_NO_WAIT);
 
+    uint32_t loop_count = 0;
+
     while (1) {
-        ret = gpio_pin_toggle_dt(&fw_running_led);
-        if (ret < 0) {
-            LOG_ERR("Could not toggle the firmware running LED");
-            return 0;
+        if (loop_count++ % CONFIG_APP_BARO_RATE_HZ == 0) {
+            ret = gpio_pin_toggle_dt(&fw_running_led);
+            if (ret < 0) {
+                LOG_ERR("Could not toggle the firmware running LED");
+                return 0;
+            }
         }
 
         if (!main_imu_using_trigger) {
-            process_imu(main_imu);
+            process_imu(main_imu, false);
         }
 
         process_baro(main_baro);
 
-        k_msleep(1000);
+        k_msleep(1000 / CONFIG_APP_BARO_RATE_HZ);
     }
 
     return 0;
@@ -0,0 +1,216 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+
+#ifdef CONFIG_ESC_DSHOT
+#include <stm32_ll_dma.h>
+#endif
+
+#include "esc.h"
+#include "esc_group.h"
+
+#include "motor_output.h"
+#include "types.h"
+
+LOG_MODULE_REGISTER(motor_output);
+
+// All motors are on the channels 1 to 4 of one timer
+#define MOTOR_PWM_NODE DT_NODELABEL(pwm3)
+#define MOTOR_DMA_NODE DT_NODELABEL(gpdma1)
+
+// First GPDMA1 channel streaming DShot frames, channel 0 samples the battery
+#define MOTOR_DMA_CHANNEL 1
+
+#if CONFIG_APP_MOTOR_PROTOCOL_PWM
+#define MOTOR_PROTOCOL ESC_PWM
+#elif CONFIG_APP_MOTOR_PROTOCOL_ONESHOT_125
+#define MOTOR_PROTOCOL ESC_ONESHOT_125
+#elif CONFIG_APP_MOTOR_PROTOCOL_ONESHOT_42
+#define MOTOR_PROTOCOL ESC_ONESHOT_42
+#elif CONFIG_APP_MOTOR_PROTOCOL_MULTISHOT
+#define MOTOR_PROTOCOL ESC_MULTISHOT
+#elif CONFIG_APP_MOTOR_PROTOCOL_DSHOT300
+#define MOTOR_PROTOCOL ESC_DSHOT300
+#elif CONFIG_APP_MOTOR_PROTOCOL_DSHOT600
+#define MOTOR_PROTOCOL ESC_DSHOT600
+#endif
+
+static const struct device *const motor_pwm = DEVICE_DT_GET(MOTOR_PWM_NODE);
+
+#ifdef CONFIG_ESC_DSHOT_BIDIR
+// The eRPM replies are captured by a DMA channel per motor, which the group
+// does not support, so every motor is driven on its own
+static ESC_Inst_Type escs[MOTOR_COUNT];
+
+static const uint32_t dma_slots[MOTOR_COUNT] = {
+    LL_GPDMA1_REQUEST_TIM3_CH1,
+    LL_GPDMA1_REQUEST_TIM3_CH2,
+    LL_GPDMA1_REQUEST_TIM3_CH3,
+    LL_GPDMA1_REQUEST_TIM3_CH4,
+};
+
+// DShot ESCs arm after receiving stop commands for a while, which the rate
+// controller sends on every iteration until then
+static int64_t arm_end_ms;
+
+int motor_output_init(void) {
+    if (!device_is_ready(motor_pwm)) {
+        return -ENODEV;
+    }
+
+    for (int i = 0; i < MOTOR_COUNT; i++) {
+        const ESC_Dshot_Config_Type cfg = {
+            .timer_base = ESC_DSHOT_TIMER_BASE(MOTOR_PWM_NODE),
+            .dma_dev = DEVICE_DT_GET(MOTOR_DMA_NODE),
+            .dma_channel = MOTOR_DMA_CHANNEL + i,
+            .dma_slot = dma_slots[i],
+            .bidirectional = true,
+        };
+
+        if (ESC_InitDshot(&escs[i], motor_pwm, i + 1, MOTOR_PROTOCOL, &cfg) !=
+            ESC_SUCCESS) {
+            return -EIO;
+        }
+    }
+
+    arm_end_ms = k_uptime_get() + ESC_ARM_DURATION;
+
+    return 0;
+}
+
+bool motor_output_is_armed(void) { return k_uptime_get() >= arm_end_ms; }
+
+int motor_output_write(const float *output) {
+    int ret = 0;
+
+    for (int i = 0; i < MOTOR_COUNT; i++) {
+        // A frame still in flight only means this update is skipped
+        const ESC_Error_Type status =
+            ESC_SetSpeed(&escs[i], CLAMP(output[i], 0.0f, 1.0f));
+        if (status == ESC_DSHOT_BUSY) {
+            ret = -EBUSY;
+        } else if (status != ESC_SUCCESS) {
+            return -EIO;
+        }
+    }
+
+    return ret;
+}
+
+int motor_output_stop(void) {
+    int ret = 0;
+
+    for (int i = 0; i < MOTOR_COUNT; i++) {
+        const ESC_Error_Type status =
+            ESC_SendCommand(&escs[i], ESC_DSHOT_CMD_MOTOR_STOP);
+        if (status == ESC_DSHOT_BUSY) {
+            ret = -EBUSY;
+        } else if (status != ESC_SUCCESS) {
+            return -EIO;
+        }
+    }
+
+    return ret;
+}
+
+void motor_output_get_rpm(float *rpm) {
+    for (int i = 0; i < MOTOR_COUNT; i++) {
+        ESC_Dshot_Telemetry_Type telemetry;
+        if (ESC_GetTelemetry(&escs[i], &telemetry) == ESC_SUCCESS) {
+            rpm[i] = telemetry.rpm;
+        } else {
+            rpm[i] = NAN;
+        }
+    }
+}
+#else
+static ESC_Group_Type motor_group;
+
+int motor_output_init(void) {
+    if (!device_is_ready(motor_pwm)) {
+        return -ENODEV;
+    }
+
+    const ESC_Group_Config_Type cfg = {
+        .pwm_dev = motor_pwm,
+        .channels = {1, 2, 3, 4},
+        .channel_count = MOTOR_COUNT,
+        .protocol = MOTOR_PROTOCOL,
+        .one_pulse = IS_ENABLED(CONFIG_APP_MOTOR_ONE_PULSE),
+        .timer =
+            {
+                .timer_base = ESC_DSHOT_TIMER_BASE(MOTOR_PWM_NODE),
+#ifdef CONFIG_ESC_DSHOT
+                .dma_dev = DEVICE_DT_GET(MOTOR_DMA_NODE),
+                .dma_channel = MOTOR_DMA_CHANNEL,
+                .dma_slot = LL_GPDMA1_REQUEST_TIM3_UP,
+#endif
+            },
+    };
+
+    if (ESC_GroupInit(&motor_group, &cfg) != ESC_SUCCESS) {
+        return -EIO;
+    }
+
+    if (ESC_GroupArmStart(&motor_group, NULL, NULL) != ESC_SUCCESS) {
+        return -EIO;
+    }
+
+    return 0;
+}
+
+bool motor_output_is_armed(void) {
+    return ESC_GroupGetArmState(&motor_group) == ESC_ARM_ARMED;
+}
+
+static int write_group(const uint16_t *throttle) {
+    const ESC_Error_Type status = ESC_GroupWrite(&motor_group, throttle);
+    if (status == ESC_DSHOT_BUSY || status == ESC_PULSE_BUSY ||
+        status == ESC_ARMING_IN_PROGRESS) {
+        return -EBUSY;
+    }
+
+    return status == ESC_SUCCESS ? 0 : -EIO;
+}
+
+int motor_output_write(const float *output) {
+    uint16_t throttle[MOTOR_COUNT];
+    for (int i = 0; i < MOTOR_COUNT; i++) {
+        throttle[i] = CLAMP(output[i], 0.0f, 1.0f) * ESC_GROUP_THROTTLE_MAX;
+    }
+
+    return write_group(throttle);
+}
+
+int motor_output_stop(void) {
+    const uint16_t throttle[MOTOR_COUNT] = {0};
+
+    return write_group(throttle);
+}
+
+void motor_output_get_rpm(float *rpm) {
+    for (int i = 0; i < MOTOR_COUNT; i++) {
+        rpm[i] = NAN;
+    }
+}
+#endif
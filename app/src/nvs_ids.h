@@ -20,4 +20,7 @@
 
 #define NVS_BOOT_COUNT_ID 1
 
+// Parameters are stored at this ID plus their key from the parameter table
+#define NVS_PARAM_BASE_ID 0x100
+
 #endif // NVS_IDS_H
@@ -0,0 +1,60 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PARAM_TABLE_H
+#define PARAM_TABLE_H
+
+/*
+ * Every tunable parameter, from which the parameter IDs, names, types and the
+ * defaults of the RAM cache are generated at compile time:
+ *
+ * PARAM(id, key, name, type, default, min, max)
+ *
+ * The key locates the stored value in NVS, so it must never change or be
+ * reused. Names are limited to 16 characters by the MAVLink PARAM messages.
+ */
+#define PARAM_TABLE(PARAM)                                                     \
+    PARAM(RATE_RLL_P, 0x00, "RATE_RLL_P", FLOAT,                               \
+          CONFIG_APP_RATE_CONTROL_ROLL_KP / 10000.0f, 0.0f, 1.0f)              \
+    PARAM(RATE_RLL_I, 0x01, "RATE_RLL_I", FLOAT,                               \
+          CONFIG_APP_RATE_CONTROL_ROLL_KI / 10000.0f, 0.0f, 10.0f)             \
+    PARAM(RATE_RLL_D, 0x02, "RATE_RLL_D", FLOAT,                               \
+          CONFIG_APP_RATE_CONTROL_ROLL_KD / 10000.0f, 0.0f, 0.1f)              \
+    PARAM(RATE_PIT_P, 0x03, "RATE_PIT_P", FLOAT,                               \
+          CONFIG_APP_RATE_CONTROL_PITCH_KP / 10000.0f, 0.0f, 1.0f)             \
+    PARAM(RATE_PIT_I, 0x04, "RATE_PIT_I", FLOAT,                               \
+          CONFIG_APP_RATE_CONTROL_PITCH_KI / 10000.0f, 0.0f, 10.0f)            \
+    PARAM(RATE_PIT_D, 0x05, "RATE_PIT_D", FLOAT,                               \
+          CONFIG_APP_RATE_CONTROL_PITCH_KD / 10000.0f, 0.0f, 0.1f)             \
+    PARAM(RATE_YAW_P, 0x06, "RATE_YAW_P", FLOAT,                               \
+          CONFIG_APP_RATE_CONTROL_YAW_KP / 10000.0f, 0.0f, 1.0f)               \
+    PARAM(RATE_YAW_I, 0x07, "RATE_YAW_I", FLOAT,                               \
+          CONFIG_APP_RATE_CONTROL_YAW_KI / 10000.0f, 0.0f, 10.0f)              \
+    PARAM(RATE_YAW_D, 0x08, "RATE_YAW_D", FLOAT,                               \
+          CONFIG_APP_RATE_CONTROL_YAW_KD / 10000.0f, 0.0f, 0.1f)               \
+    PARAM(RATE_I_LIMIT, 0x09, "RATE_I_LIMIT", FLOAT,                           \
+          CONFIG_APP_RATE_CONTROL_I_LIMIT / 1000.0f, 0.0f, 1.0f)               \
+    PARAM(RATE_MAX_DPS, 0x0A, "RATE_MAX_DPS", FLOAT,                           \
+          CONFIG_APP_RATE_CONTROL_MAX_RATE_DPS, 10.0f, 2000.0f)                \
+    PARAM(RATE_YAW_MAX_DPS, 0x0B, "RATE_YAW_MAX_DPS", FLOAT,                   \
+          CONFIG_APP_RATE_CONTROL_MAX_YAW_RATE_DPS, 10.0f, 2000.0f)            \
+    PARAM(RATE_ARM_THR, 0x0C, "RATE_ARM_THR", FLOAT,                           \
+          CONFIG_APP_RATE_CONTROL_ARM_THROTTLE / 1000.0f, 0.0f, 0.5f)          \
+    PARAM(LOG_SYNC_MS, 0x0D, "LOG_SYNC_MS", INT32,                             \
+          CONFIG_APP_DATA_LOGGING_SYNC_INTERVAL, 100, 60000)
+
+#endif // PARAM_TABLE_H
@@ -0,0 +1,243 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/fs/nvs.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/atomic.h>
+
+#include "nvs_ids.h"
+#include "params.h"
+
+LOG_MODULE_REGISTER(params);
+
+#define PARAM_VALUE_FLOAT(x) {.f = (x)}
+#define PARAM_VALUE_INT32(x) {.i = (x)}
+
+struct param_info {
+    const char *name;
+    uint16_t key;
+    enum param_type type;
+    union param_value min;
+    union param_value max;
+};
+
+static const struct param_info params[PARAM_COUNT] = {
+#define PARAM_INFO(id, key, name, type, def, min, max)                         \
+    {name, key, PARAM_TYPE_##type, PARAM_VALUE_##type(min),                    \
+     PARAM_VALUE_##type(max)},
+    PARAM_TABLE(PARAM_INFO)
+#undef PARAM_INFO
+};
+
+#define PARAM_DEFAULT(id, key, name, type, def, min, max)                      \
+    PARAM_VALUE_##type(def),
+
+union param_value param_values[PARAM_COUNT] = {PARAM_TABLE(PARAM_DEFAULT)};
+
+static const union param_value param_defaults[PARAM_COUNT] = {
+    PARAM_TABLE(PARAM_DEFAULT)};
+
+#undef PARAM_DEFAULT
+
+#define PARAM_CHECK_NAME(id, key, name, type, def, min, max)                   \
+    BUILD_ASSERT(sizeof(name) - 1 <= PARAM_NAME_LEN,                           \
+                 "Parameter name " name " is too long");
+PARAM_TABLE(PARAM_CHECK_NAME)
+#undef PARAM_CHECK_NAME
+
+static struct nvs_fs *param_nvs;
+static atomic_t generation;
+
+// Changed parameters are saved once the changes stop for the save delay, so a
+// batch of changes costs a single flash write per parameter
+static ATOMIC_DEFINE(dirty, PARAM_COUNT);
+static void save_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(save_work, save_handler);
+
+struct param_stats {
+    uint32_t writes;
+    uint32_t write_errors;
+};
+
+static struct param_stats stats;
+
+static void save_handler(struct k_work *work) {
+    for (int id = 0; id < PARAM_COUNT; id++) {
+        if (!atomic_test_and_clear_bit(dirty, id)) {
+            continue;
+        }
+
+        // NVS skips the write if the stored value is the same
+        const ssize_t ret =
+            nvs_write(param_nvs, NVS_PARAM_BASE_ID + params[id].key,
+                      &param_values[id], sizeof(param_values[id]));
+        if (ret < 0) {
+            LOG_ERR("Could not save parameter %s: %d", params[id].name,
+                    (int)ret);
+            stats.write_errors++;
+            continue;
+        }
+
+        if (ret > 0) {
+            stats.writes++;
+        }
+    }
+}
+
+static bool in_range(enum param_id id, union param_value value) {
+    const struct param_info *info = &params[id];
+
+    if (info->type == PARAM_TYPE_INT32) {
+        return value.i >= info->min.i && value.i <= info->max.i;
+    }
+
+    return isfinite(value.f) && value.f >= info->min.f &&
+           value.f <= info->max.f;
+}
+
+int param_init(struct nvs_fs *nvs) {
+    param_nvs = nvs;
+
+    for (int id = 0; id < PARAM_COUNT; id++) {
+        union param_value value;
+
+        const ssize_t ret = nvs_read(nvs, NVS_PARAM_BASE_ID + params[id].key,
+                                     &value, sizeof(value));
+        if (ret != sizeof(value)) {
+            continue;
+        }
+
+        // A stored value the current limits reject falls back to the default
+        if (!in_range(id, value)) {
+            LOG_WRN("Stored parameter %s is out of range, using the default",
+                    params[id].name);
+            continue;
+        }
+
+        param_values[id] = value;
+    }
+
+    atomic_inc(&generation);
+
+    return 0;
+}
+
+uint32_t param_generation(void) {
+    return atomic_get(&generation);
+}
+
+int param_set(enum param_id id, union param_value value) {
+    if (id >= PARAM_COUNT || !in_range(id, value)) {
+        return -EINVAL;
+    }
+
+    param_values[id] = value;
+    atomic_inc(&generation);
+
+    if (param_nvs != NULL) {
+        atomic_set_bit(dirty, id);
+        k_work_reschedule(&save_work, K_MSEC(CONFIG_APP_PARAM_SAVE_DELAY_MS));
+    }
+
+    return 0;
+}
+
+int param_find(const char *name) {
+    for (int id = 0; id < PARAM_COUNT; id++) {
+        if (strncmp(params[id].name, name, PARAM_NAME_LEN) == 0) {
+            return id;
+        }
+    }
+
+    return -ENOENT;
+}
+
+const char *param_name(enum param_id id) {
+    return params[id].name;
+}
+
+enum param_type param_type(enum param_id id) {
+    return params[id].type;
+}
+
+static void print_param(const struct shell *sh, enum param_id id) {
+    if (params[id].type == PARAM_TYPE_INT32) {
+        shell_print(sh, "%-16s %d", params[id].name, param_values[id].i);
+    } else {
+        shell_print(sh, "%-16s %f", params[id].name,
+                    (double)param_values[id].f);
+    }
+}
+
+static int cmd_param_show(const struct shell *sh, size_t argc, char **argv) {
+    for (int id = 0; id < PARAM_COUNT; id++) {
+        print_param(sh, id);
+    }
+
+    shell_print(sh, "Saved: %u writes, %u errors", stats.writes,
+                stats.write_errors);
+
+    return 0;
+}
+
+static int cmd_param_set(const struct shell *sh, size_t argc, char **argv) {
+    const int id = param_find(argv[1]);
+    if (id < 0) {
+        shell_error(sh, "Unknown parameter %s", argv[1]);
+        return id;
+    }
+
+    union param_value value;
+    if (params[id].type == PARAM_TYPE_INT32) {
+        value.i = strtol(argv[2], NULL, 10);
+    } else {
+        value.f = strtof(argv[2], NULL);
+    }
+
+    const int ret = param_set(id, value);
+    if (ret < 0) {
+        shell_error(sh, "Value is out of range");
+        return ret;
+    }
+
+    print_param(sh, id);
+
+    return 0;
+}
+
+static int cmd_param_reset(const struct shell *sh, size_t argc, char **argv) {
+    for (int id = 0; id < PARAM_COUNT; id++) {
+        param_set(id, param_defaults[id]);
+    }
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    param_cmds, SHELL_CMD(show, NULL, "Show all parameters", cmd_param_show),
+    SHELL_CMD_ARG(set, NULL, "Set a parameter: <name> <value>", cmd_param_set,
+                  3, 0),
+    SHELL_CMD(reset, NULL, "Restore the defaults of all parameters",
+              cmd_param_reset),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(param, &param_cmds, "Parameters", NULL);
@@ -0,0 +1,78 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PARAMS_H
+#define PARAMS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "param_table.h"
+
+// Longest parameter name, not null terminated at this length
+#define PARAM_NAME_LEN 16
+
+struct nvs_fs;
+
+enum param_type {
+    PARAM_TYPE_FLOAT,
+    PARAM_TYPE_INT32,
+};
+
+enum param_id {
+#define PARAM_ENUM(id, key, name, type, def, min, max) PARAM_##id,
+    PARAM_TABLE(PARAM_ENUM)
+#undef PARAM_ENUM
+    PARAM_COUNT,
+};
+
+union param_value {
+    float f;
+    int32_t i;
+};
+
+// RAM cache of all values, only written by param_set
+extern union param_value param_values[PARAM_COUNT];
+
+// Reads are a single load, so they can be done from the hot paths
+static inline float param_get_float(enum param_id id) {
+    return param_values[id].f;
+}
+
+static inline int32_t param_get_int32(enum param_id id) {
+    return param_values[id].i;
+}
+
+// Loads the stored values, parameters not found in NVS keep their defaults
+int param_init(struct nvs_fs *nvs);
+
+// Incremented on every change, so users can pick changes up cheaply
+uint32_t param_generation(void);
+
+// Updates the cache right away and saves the value after the batch of changes
+// it belongs to. Returns -EINVAL if the value is out of range.
+int param_set(enum param_id id, union param_value value);
+
+// Returns the ID of the named parameter or -ENOENT, the name does not have to
+// be null terminated at PARAM_NAME_LEN
+int param_find(const char *name);
+
+const char *param_name(enum param_id id);
+
+enum param_type param_type(enum param_id id);
+
+#endif // PARAMS_H
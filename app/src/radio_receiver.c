@@ -15,71 +15,303 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
 #include <zephyr/input/input.h>
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/barrier.h>
+#include <zephyr/zbus/zbus.h>
 
+#include "crsf_receiver.h"
 #include "radio_receiver.h"
+#include "types.h"
 
-struct radio_receiver_data {
-    int32_t roll_rate;
-    int32_t pitch_rate;
-    int32_t throttle;
-    int32_t yaw_rate;
+LOG_MODULE_REGISTER(radio_receiver);
+
+ZBUS_CHAN_DEFINE(rc_chan, struct rc_data, NULL, NULL, ZBUS_OBSERVERS_EMPTY,
+                 {0});
+
+// Channel values sent by common transmitters at full stick deflection, CRSF
+// uses the same range
+#define RADIO_SBUS_MIN 172
+#define RADIO_SBUS_MAX 1811
+#define RADIO_SBUS_CENTER ((RADIO_SBUS_MIN + RADIO_SBUS_MAX) / 2)
+
+// Stick channels, as mapped in the board devicetree
+#define RADIO_CHANNEL_ROLL 0
+#define RADIO_CHANNEL_PITCH 1
+#define RADIO_CHANNEL_THROTTLE 2
+#define RADIO_CHANNEL_YAW 3
+
+// Period at which the link state is checked and the sticks are published
+#define RADIO_MONITOR_PERIOD_MS 20
+
+// Frame being published, owned by the context receiving the frames
+static struct rc_frame pending;
+
+// Frame intervals, owned by the same context
+struct radio_stats {
+    uint32_t intervals;
+    uint32_t interval_min_us;
+    uint32_t interval_max_us;
+    uint64_t interval_sum_us;
 };
 
-LOG_MODULE_REGISTER(radio_receiver);
+static struct radio_stats stats;
+static atomic_t stats_reset_requested;
+
+// The newest frame is double buffered. The receiving context fills the slot
+// which is not published and then publishes it by incrementing the sequence,
+// the newest frame is in slot (sequence & 1). Readers never block the writer
+// and retry when the sequence moved while they copied, as the writer may then
+// be refilling their slot.
+static struct rc_frame slots[2];
+static atomic_t sequence;
+
+static void record_interval(uint32_t interval_us) {
+    if (atomic_cas(&stats_reset_requested, 1, 0)) {
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    if (stats.intervals == 0 || interval_us < stats.interval_min_us) {
+        stats.interval_min_us = interval_us;
+    }
+
+    stats.interval_max_us = MAX(stats.interval_max_us, interval_us);
+    stats.interval_sum_us += interval_us;
+    stats.intervals++;
+}
+
+void radio_receiver_publish(const uint16_t *channels,
+                            const struct rc_link *link) {
+    const uint64_t timestamp_us = k_ticks_to_us_floor64(k_uptime_ticks());
+
+    // A gap of more than one interval means the receiver sent frames which
+    // were not received
+    if (pending.timestamp_us != 0) {
+        const uint64_t gap_us = timestamp_us - pending.timestamp_us;
+        const uint32_t missed =
+            (gap_us + CONFIG_APP_RC_FRAME_INTERVAL_US / 2) /
+            CONFIG_APP_RC_FRAME_INTERVAL_US;
+
+        pending.frame_lost = missed > 1;
+        if (pending.frame_lost) {
+            pending.frames_lost += missed - 1;
+        }
 
-static const struct device *const sbus_dev =
-    DEVICE_DT_GET(DT_CHOSEN(futaba_sbus));
-static struct radio_receiver_data receiver_data;
+        record_interval(gap_us);
+    }
+
+    pending.timestamp_us = timestamp_us;
+    memcpy(pending.channels, channels, sizeof(pending.channels));
+    if (link != NULL) {
+        pending.link = *link;
+    }
+
+    const atomic_val_t next = atomic_get(&sequence) + 1;
+    slots[next & 1] = pending;
+    atomic_set(&sequence, next);
+}
+
+#ifndef CONFIG_APP_RC_CRSF
+#define RADIO_SBUS_NODE DT_CHOSEN(futaba_sbus)
+
+// All absolute axis codes are below this
+#define RADIO_CODE_COUNT 0x40
+
+static const struct device *const sbus_dev = DEVICE_DT_GET(RADIO_SBUS_NODE);
+
+// SBUS channel of every input code, counting from one, zero when unmapped
+#define RADIO_CODE_CHANNEL(node)                                               \
+    [DT_PROP(node, zephyr_code)] = DT_PROP(node, channel),
 
-K_MSGQ_DEFINE(sbus_msgq, sizeof(struct radio_receiver_data), 10, 1);
+static const uint8_t code_channels[RADIO_CODE_COUNT] = {
+    DT_FOREACH_CHILD(RADIO_SBUS_NODE, RADIO_CODE_CHANNEL)};
+
+// Channels assembled from the input events, owned by the input thread
+static uint16_t sbus_channels[RC_CHANNEL_COUNT];
 
 static void sbus_event_callback(struct input_event *evt, void *user_data) {
-    switch (evt->code) {
-    case INPUT_ABS_RX:
-        receiver_data.roll_rate = evt->value;
-        break;
-    case INPUT_ABS_RY:
-        receiver_data.pitch_rate = evt->value;
-        break;
-    case INPUT_ABS_THROTTLE:
-        receiver_data.throttle = evt->value;
-        break;
-    case INPUT_ABS_RZ:
-        receiver_data.yaw_rate = evt->value;
-        break;
-    default:
-        break;
+    if (evt->type == INPUT_EV_ABS && evt->code < RADIO_CODE_COUNT) {
+        const uint8_t channel = code_channels[evt->code];
+
+        if (channel > 0 && channel <= RC_CHANNEL_COUNT) {
+            sbus_channels[channel - 1] = evt->value;
+        }
     }
 
     if (evt->sync) {
-        k_msgq_put(&sbus_msgq, &receiver_data, K_NO_WAIT);
+        radio_receiver_publish(sbus_channels, NULL);
     }
 }
 
 INPUT_CALLBACK_DEFINE(sbus_dev, sbus_event_callback, NULL);
+#endif
+
+int radio_receiver_read(struct rc_frame *frame) {
+    atomic_val_t seq;
+
+    do {
+        seq = atomic_get(&sequence);
+        if (seq == 0) {
+            return -ENODATA;
+        }
+
+        *frame = slots[seq & 1];
 
+        // The copy has to complete before the sequence is checked again
+        barrier_dmem_fence_full();
+    } while (atomic_get(&sequence) != seq);
+
+    const uint64_t age_us =
+        k_ticks_to_us_floor64(k_uptime_ticks()) - frame->timestamp_us;
+
+    frame->failsafe = age_us > CONFIG_APP_RC_FAILSAFE_MS * USEC_PER_MSEC;
+
+    if (age_us > CONFIG_APP_RC_STALE_MS * USEC_PER_MSEC) {
+        return -ETIMEDOUT;
+    }
+
+    return 0;
+}
+
+static float normalize_stick(int32_t value) {
+    const float half_range = (RADIO_SBUS_MAX - RADIO_SBUS_MIN) / 2.0f;
+    const float stick = (value - RADIO_SBUS_CENTER) / half_range;
+
+    return CLAMP(stick, -1.0f, 1.0f);
+}
+
+static float normalize_throttle(int32_t value) {
+    const float throttle = (float)(value - RADIO_SBUS_MIN) /
+                           (RADIO_SBUS_MAX - RADIO_SBUS_MIN);
+
+    return CLAMP(throttle, 0.0f, 1.0f);
+}
+
+void radio_receiver_sticks(const struct rc_frame *frame, struct rc_data *rc) {
+    rc->timestamp_us = frame->timestamp_us;
+    rc->roll = normalize_stick(frame->channels[RADIO_CHANNEL_ROLL]);
+    rc->pitch = normalize_stick(frame->channels[RADIO_CHANNEL_PITCH]);
+    rc->yaw = normalize_stick(frame->channels[RADIO_CHANNEL_YAW]);
+    rc->throttle = normalize_throttle(frame->channels[RADIO_CHANNEL_THROTTLE]);
+}
+
+// Frames are handed to the control loop by radio_receiver_read, this thread
+// only reports link changes and publishes the sticks for everyone else
 void radio_receiver(void *dummy1, void *dummy2, void *dummy3) {
     ARG_UNUSED(dummy1);
     ARG_UNUSED(dummy2);
     ARG_UNUSED(dummy3);
 
-    struct radio_receiver_data read_data;
-
+#ifdef CONFIG_APP_RC_CRSF
+    if (crsf_receiver_init() < 0) {
+#else
     if (!device_is_ready(sbus_dev)) {
+#endif
         LOG_ERR("Radio receiver not found, device operation will proceed "
                 "without receiver!");
         return;
     }
 
+    bool link_up = false;
+    bool failsafe = false;
+    uint64_t prev_timestamp_us = 0;
+
     while (true) {
-        k_msgq_get(&sbus_msgq, &read_data, K_FOREVER);
+        k_msleep(RADIO_MONITOR_PERIOD_MS);
+
+        struct rc_frame frame;
+        const int ret = radio_receiver_read(&frame);
+        if (ret == -ENODATA) {
+            continue;
+        }
+
+        if (link_up != (ret == 0)) {
+            link_up = ret == 0;
+            if (link_up) {
+                LOG_INF("Radio link up, %u frames lost so far",
+                        frame.frames_lost);
+            } else {
+                LOG_WRN("Radio link lost");
+            }
+        }
+
+        if (failsafe != frame.failsafe) {
+            failsafe = frame.failsafe;
+            if (failsafe) {
+                LOG_WRN("Radio failsafe");
+            }
+        }
+
+        if (frame.timestamp_us == prev_timestamp_us) {
+            continue;
+        }
+        prev_timestamp_us = frame.timestamp_us;
+
+        struct rc_data msg;
+        radio_receiver_sticks(&frame, &msg);
 
-        LOG_INF("Received SBUS data:\n"
-                "THR: %d, PITCH_RATE: %d, ROLL_RATE: %d, YAW_RATE: %d\n",
-                read_data.throttle, read_data.pitch_rate, read_data.roll_rate,
-                read_data.yaw_rate);
+        int err = zbus_chan_pub(&rc_chan, &msg, K_NO_WAIT);
+        if (err < 0 && err != -EAGAIN && err != -EBUSY) {
+            LOG_ERR("Failed to send radio message on zbus!");
+        }
     }
 }
+
+static int cmd_rc_stats(const struct shell *sh, size_t argc, char **argv) {
+    struct rc_frame frame;
+    int ret = radio_receiver_read(&frame);
+    if (ret == -ENODATA) {
+        shell_print(sh, "No frame received");
+        return 0;
+    }
+
+    const uint64_t age_us =
+        k_ticks_to_us_floor64(k_uptime_ticks()) - frame.timestamp_us;
+
+    shell_print(sh, "Newest frame: %llu us ago%s%s", age_us,
+                ret == -ETIMEDOUT ? ", stale" : "",
+                frame.failsafe ? ", failsafe" : "");
+    shell_print(sh, "Frames: %ld, lost: %u", atomic_get(&sequence),
+                frame.frames_lost);
+
+    if (stats.intervals > 0) {
+        const uint32_t mean_us = stats.interval_sum_us / stats.intervals;
+
+        shell_print(sh, "Interval [us]: min %u, mean %u, max %u, jitter %u",
+                    stats.interval_min_us, mean_us, stats.interval_max_us,
+                    stats.interval_max_us - stats.interval_min_us);
+    }
+
+    shell_print(sh, "Link quality: %u %%, RSSI: %d dBm, SNR: %d dB",
+                frame.link.link_quality, frame.link.rssi_dbm,
+                frame.link.snr_db);
+
+    for (int i = 0; i < RC_CHANNEL_COUNT; i += 4) {
+        shell_print(sh, "CH%-2d %4u  CH%-2d %4u  CH%-2d %4u  CH%-2d %4u", i + 1,
+                    frame.channels[i], i + 2, frame.channels[i + 1], i + 3,
+                    frame.channels[i + 2], i + 4, frame.channels[i + 3]);
+    }
+
+    return 0;
+}
+
+static int cmd_rc_reset(const struct shell *sh, size_t argc, char **argv) {
+    atomic_set(&stats_reset_requested, 1);
+    shell_print(sh, "Statistics are cleared on the next frame");
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    rc_cmds,
+    SHELL_CMD(stats, NULL, "Show channels, link and frame interval statistics",
+              cmd_rc_stats),
+    SHELL_CMD(reset, NULL, "Clear the frame interval statistics",
+              cmd_rc_reset),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(rc, &rc_cmds, "Radio receiver", NULL);
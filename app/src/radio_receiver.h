@@ -15,4 +15,24 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdint.h>
+
+struct rc_data;
+struct rc_frame;
+struct rc_link;
+
 void radio_receiver(void *dummy1, void *dummy2, void *dummy3);
+
+// Copies the newest frame without blocking. Returns -ENODATA before the first
+// frame and -ETIMEDOUT for a frame older than CONFIG_APP_RC_STALE_MS, which is
+// still copied, with the failsafe flag set once it is older than
+// CONFIG_APP_RC_FAILSAFE_MS.
+int radio_receiver_read(struct rc_frame *frame);
+
+// Publishes a frame of RC_CHANNEL_COUNT channels, called by the receiver
+// protocol from a single context. The link statistics can be NULL.
+void radio_receiver_publish(const uint16_t *channels,
+                            const struct rc_link *link);
+
+// Normalizes the stick channels of a frame
+void radio_receiver_sticks(const struct rc_frame *frame, struct rc_data *rc);
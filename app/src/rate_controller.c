@@ -0,0 +1,398 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/zbus/zbus.h>
+
+#include "mixer.h"
+#include "pid.h"
+
+#include "latency.h"
+#include "motor_output.h"
+#include "params.h"
+#include "radio_receiver.h"
+#include "rate_controller.h"
+#include "types.h"
+
+LOG_MODULE_REGISTER(rate_controller);
+
+ZBUS_OBS_DECLARE(logger_sub);
+
+ZBUS_CHAN_DECLARE(imu_filtered_chan);
+
+ZBUS_CHAN_DEFINE(motor_chan, struct motor_data, NULL, NULL,
+                 ZBUS_OBSERVERS(logger_sub), {0});
+
+ZBUS_CHAN_DEFINE(rate_control_chan, struct rate_control_data, NULL, NULL,
+                 ZBUS_OBSERVERS(logger_sub), {0});
+
+ZBUS_SUBSCRIBER_DEFINE_WITH_ENABLE(rate_controller_sub, 16, false);
+
+#define RATE_CONTROL_PERIOD_US (USEC_PER_SEC / CONFIG_APP_IMU_RATE_HZ)
+
+// Without gyro samples for this long the motors are stopped
+#define RATE_CONTROL_GYRO_TIMEOUT_US (10 * RATE_CONTROL_PERIOD_US)
+
+// Histogram bins are an eighth of the deadline or of the period wide, the last
+// bin collects everything beyond twice of it
+#define RATE_CONTROL_HIST_BINS_PER_LIMIT 8
+
+#define RATE_CONTROL_STATUS_DIVIDER                                            \
+    (CONFIG_APP_IMU_RATE_HZ / CONFIG_APP_RATE_CONTROL_STATUS_RATE_HZ)
+
+#define RATE_CONTROL_DEG_TO_RAD (3.14159265f / 180.0f)
+
+static PID_Inst_Type pids[MIXER_AXIS_COUNT];
+static MIXER_Inst_Type mixer;
+
+// Owned by the control thread, the shell reads the published copy
+static struct rate_control_data status;
+static atomic_t status_reset_requested;
+
+static struct rc_data rc;
+static bool saturated;
+
+static const enum param_id gain_params[MIXER_AXIS_COUNT][3] = {
+    {PARAM_RATE_RLL_P, PARAM_RATE_RLL_I, PARAM_RATE_RLL_D},
+    {PARAM_RATE_PIT_P, PARAM_RATE_PIT_I, PARAM_RATE_PIT_D},
+    {PARAM_RATE_YAW_P, PARAM_RATE_YAW_I, PARAM_RATE_YAW_D},
+};
+
+static uint32_t param_generation_seen;
+
+static bool init_controllers(void) {
+    param_generation_seen = param_generation();
+
+    for (int axis = 0; axis < MIXER_AXIS_COUNT; axis++) {
+        const PID_Config_Type cfg = {
+            .kp = param_get_float(gain_params[axis][0]),
+            .ki = param_get_float(gain_params[axis][1]),
+            .kd = param_get_float(gain_params[axis][2]),
+            .integral_limit = param_get_float(PARAM_RATE_I_LIMIT),
+            .d_cutoff_hz = CONFIG_APP_RATE_CONTROL_D_CUTOFF_HZ,
+            .sample_rate_hz = CONFIG_APP_IMU_RATE_HZ,
+        };
+
+        if (PID_Init(&pids[axis], &cfg) != PID_SUCCESS) {
+            return false;
+        }
+    }
+
+    const MIXER_Config_Type mixer_cfg = {
+        .motor_count = MOTOR_COUNT,
+        .matrix = MIXER_QUAD_X_MATRIX,
+        .idle_output = CONFIG_APP_RATE_CONTROL_IDLE_OUTPUT / 1000.0f,
+    };
+
+    return MIXER_Init(&mixer, &mixer_cfg) == MIXER_SUCCESS;
+}
+
+// Tuned gains are picked up without resetting the controllers
+static void update_gains(void) {
+    const uint32_t generation = param_generation();
+    if (generation == param_generation_seen) {
+        return;
+    }
+
+    param_generation_seen = generation;
+
+    for (int axis = 0; axis < MIXER_AXIS_COUNT; axis++) {
+        PID_SetGains(&pids[axis], param_get_float(gain_params[axis][0]),
+                     param_get_float(gain_params[axis][1]),
+                     param_get_float(gain_params[axis][2]),
+                     param_get_float(PARAM_RATE_I_LIMIT));
+    }
+}
+
+static void reset_controllers(void) {
+    for (int axis = 0; axis < MIXER_AXIS_COUNT; axis++) {
+        PID_Reset(&pids[axis]);
+        status.setpoint_radps[axis] = 0.0f;
+        status.torque[axis] = 0.0f;
+    }
+
+    saturated = false;
+}
+
+static bool motors_enabled(void) {
+    static bool armed;
+
+    if (!motor_output_is_armed()) {
+        return false;
+    }
+
+    if (!armed) {
+        LOG_INF("Motors armed");
+        armed = true;
+    }
+
+    // Stale frames stop the motors
+    struct rc_frame frame;
+    if (radio_receiver_read(&frame) < 0) {
+        return false;
+    }
+
+    radio_receiver_sticks(&frame, &rc);
+
+    return rc.throttle >= param_get_float(PARAM_RATE_ARM_THR);
+}
+
+static int run_control(const struct imu_6dof_data *imu, float *output) {
+    update_gains();
+
+    if (!motors_enabled()) {
+        reset_controllers();
+
+        for (int i = 0; i < MOTOR_COUNT; i++) {
+            output[i] = 0.0f;
+        }
+
+        return motor_output_stop();
+    }
+
+    const float max_rate_radps =
+        param_get_float(PARAM_RATE_MAX_DPS) * RATE_CONTROL_DEG_TO_RAD;
+    const float max_yaw_rate_radps =
+        param_get_float(PARAM_RATE_YAW_MAX_DPS) * RATE_CONTROL_DEG_TO_RAD;
+
+    status.setpoint_radps[MIXER_ROLL] = rc.roll * max_rate_radps;
+    // Stick forward pitches the nose down
+    status.setpoint_radps[MIXER_PITCH] = -rc.pitch * max_rate_radps;
+    status.setpoint_radps[MIXER_YAW] = rc.yaw * max_yaw_rate_radps;
+
+    // The integrals are held while the mixer cannot deliver the torque
+    for (int axis = 0; axis < MIXER_AXIS_COUNT; axis++) {
+        status.torque[axis] =
+            PID_Update(&pids[axis], status.setpoint_radps[axis],
+                       imu->gyro_radps[axis], !saturated);
+    }
+
+    saturated = MIXER_Mix(&mixer, status.torque, rc.throttle, output);
+
+    latency_record(LATENCY_STAGE_CONTROL, imu->origin_cycles);
+
+    return motor_output_write(output);
+}
+
+static uint32_t hist_bin(uint32_t value_us, uint32_t limit_us) {
+    return MIN(value_us * RATE_CONTROL_HIST_BINS_PER_LIMIT / limit_us,
+               RATE_CONTROL_HIST_BINS - 1);
+}
+
+static void record_timing(uint32_t start_cycles, uint32_t end_cycles,
+                          uint32_t prev_start_cycles) {
+    if (atomic_cas(&status_reset_requested, 1, 0)) {
+        const uint32_t iterations = status.iterations;
+        memset(&status, 0, sizeof(status));
+        status.iterations = iterations;
+    }
+
+    const uint32_t exec_time_us =
+        k_cyc_to_us_floor32(end_cycles - start_cycles);
+
+    status.exec_time_max_us = MAX(status.exec_time_max_us, exec_time_us);
+    status.exec_time_hist[hist_bin(exec_time_us,
+                                   CONFIG_APP_RATE_CONTROL_DEADLINE_US)]++;
+
+    if (exec_time_us > CONFIG_APP_RATE_CONTROL_DEADLINE_US) {
+        status.deadline_misses++;
+    }
+
+    if (prev_start_cycles != 0) {
+        const uint32_t period_us =
+            k_cyc_to_us_floor32(start_cycles - prev_start_cycles);
+        status.period_hist[hist_bin(period_us, RATE_CONTROL_PERIOD_US)]++;
+    }
+}
+
+static uint32_t count_missed_samples(uint64_t timestamp_us,
+                                     uint64_t prev_timestamp_us) {
+    if (prev_timestamp_us == 0) {
+        return 0;
+    }
+
+    const uint64_t gap = (timestamp_us - prev_timestamp_us +
+                          RATE_CONTROL_PERIOD_US / 2) /
+                         RATE_CONTROL_PERIOD_US;
+
+    return gap > 1 ? gap - 1 : 0;
+}
+
+static void publish_motors(uint64_t timestamp_us, const float *output) {
+    struct motor_data msg = {
+        .timestamp_us = timestamp_us,
+    };
+
+    memcpy(msg.output, output, sizeof(msg.output));
+    motor_output_get_rpm(msg.rpm);
+
+    int ret = zbus_chan_pub(&motor_chan, &msg, K_NO_WAIT);
+    if (ret < 0 && ret != -EAGAIN && ret != -EBUSY) {
+        LOG_ERR("Failed to send motor message on zbus!");
+    }
+}
+
+static void publish_status(uint64_t timestamp_us) {
+    status.timestamp_us = timestamp_us;
+
+    int ret = zbus_chan_pub(&rate_control_chan, &status, K_NO_WAIT);
+    if (ret < 0 && ret != -EAGAIN && ret != -EBUSY) {
+        LOG_ERR("Failed to send rate control message on zbus!");
+    }
+}
+
+void rate_controller(void *dummy1, void *dummy2, void *dummy3) {
+    ARG_UNUSED(dummy1);
+    ARG_UNUSED(dummy2);
+    ARG_UNUSED(dummy3);
+
+    if (!init_controllers()) {
+        LOG_ERR("Could not initialize the rate controllers!");
+        return;
+    }
+
+    int ret = motor_output_init();
+    if (ret < 0) {
+        LOG_ERR("Could not initialize the motor output: %d", ret);
+        return;
+    }
+
+    uint64_t prev_timestamp_us = 0;
+    uint32_t prev_start_cycles = 0;
+    bool gyro_lost = false;
+
+    zbus_obs_set_enable(&rate_controller_sub, true);
+
+    while (true) {
+        const struct zbus_channel *chan;
+        ret = zbus_sub_wait(&rate_controller_sub, &chan,
+                            K_USEC(RATE_CONTROL_GYRO_TIMEOUT_US));
+        if (ret == -EAGAIN) {
+            if (!gyro_lost) {
+                LOG_ERR("No gyro samples, stopping the motors!");
+                gyro_lost = true;
+            }
+
+            reset_controllers();
+            motor_output_stop();
+            continue;
+        }
+
+        if (ret < 0) {
+            LOG_ERR("Could not wait on the rate controller subscriber, "
+                    "aborting.");
+            motor_output_stop();
+            return;
+        }
+
+        if (chan != &imu_filtered_chan) {
+            continue;
+        }
+
+        struct imu_6dof_data msg;
+        ret = zbus_chan_read(chan, &msg, K_USEC(1));
+        if (ret < 0) {
+            LOG_ERR("Failed to read from rate controller subscriber!");
+            continue;
+        }
+
+        // Notifications queued while the loop was late all read the newest
+        // sample, which only has to be handled once
+        if (msg.timestamp_us == prev_timestamp_us) {
+            continue;
+        }
+
+        // The deadline runs from the moment the sample is handed over, so
+        // the wake up delay after the publish counts against it
+        const uint32_t start_cycles = msg.publish_cycles;
+
+        status.samples_missed +=
+            count_missed_samples(msg.timestamp_us, prev_timestamp_us);
+        prev_timestamp_us = msg.timestamp_us;
+        gyro_lost = false;
+
+        float output[MOTOR_COUNT];
+        ret = run_control(&msg, output);
+        if (ret < 0 && ret != -EBUSY) {
+            LOG_ERR("Could not write the motor outputs!");
+        }
+
+        latency_record(LATENCY_STAGE_OUTPUT, msg.origin_cycles);
+
+        record_timing(start_cycles, k_cycle_get_32(), prev_start_cycles);
+        prev_start_cycles = start_cycles;
+
+        publish_motors(msg.timestamp_us, output);
+
+        if (++status.iterations % RATE_CONTROL_STATUS_DIVIDER == 0) {
+            publish_status(msg.timestamp_us);
+        }
+    }
+}
+
+static int cmd_rate_control_stats(const struct shell *sh, size_t argc,
+                                  char **argv) {
+    struct rate_control_data msg;
+    int ret = zbus_chan_read(&rate_control_chan, &msg, K_MSEC(10));
+    if (ret < 0) {
+        shell_error(sh, "Could not read the rate control status: %d", ret);
+        return ret;
+    }
+
+    shell_print(sh, "Iterations: %u, deadline misses: %u, samples missed: %u",
+                msg.iterations, msg.deadline_misses, msg.samples_missed);
+    shell_print(sh, "Longest iteration: %u us, deadline: %u us",
+                msg.exec_time_max_us, CONFIG_APP_RATE_CONTROL_DEADLINE_US);
+    shell_print(sh, "%12s %10s %12s %10s", "Time [us]", "Count", "Period [us]",
+                "Count");
+
+    for (int i = 0; i < RATE_CONTROL_HIST_BINS; i++) {
+        shell_print(sh, "%11u+ %10u %11u+ %10u",
+                    i * CONFIG_APP_RATE_CONTROL_DEADLINE_US /
+                        RATE_CONTROL_HIST_BINS_PER_LIMIT,
+                    msg.exec_time_hist[i],
+                    i * RATE_CONTROL_PERIOD_US /
+                        RATE_CONTROL_HIST_BINS_PER_LIMIT,
+                    msg.period_hist[i]);
+    }
+
+    return 0;
+}
+
+static int cmd_rate_control_reset(const struct shell *sh, size_t argc,
+                                  char **argv) {
+    atomic_set(&status_reset_requested, 1);
+    shell_print(sh, "Statistics are cleared on the next iteration");
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    rate_control_cmds,
+    SHELL_CMD(stats, NULL, "Show deadline misses and loop time histograms",
+              cmd_rate_control_stats),
+    SHELL_CMD(reset, NULL, "Clear deadline misses and histograms",
+              cmd_rate_control_reset),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(rate_control, &rate_control_cmds, "Rate control loop",
+                   NULL);
@@ -0,0 +1,476 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/util.h>
+
+// MAVLink headers
+// clang-format off
+#include "mavlink_custom.h" // Needs to be included before any MAVLink header inclusion
+#include "efc/mavlink.h"
+// clang-format on
+
+#include "tx_ring.h"
+
+#include "telemetry_link.h"
+
+LOG_MODULE_REGISTER(telemetry_link);
+
+BUILD_ASSERT(TELEMETRY_LINK_COUNT <= MAVLINK_COMM_NUM_BUFFERS,
+             "Every telemetry link needs its own MAVLink channel");
+
+BUILD_ASSERT(CONFIG_APP_TELEMETRY_TX_CRITICAL_SIZE >= MAVLINK_MAX_PACKET_LEN,
+             "The critical class has to hold at least one frame");
+
+// Throughput is measured over this period
+#define THROUGHPUT_PERIOD_MS 1000
+
+struct telemetry_link_stats {
+    uint32_t frames;
+    uint32_t frames_dropped[TELEMETRY_CLASS_COUNT];
+    uint32_t bytes_sent;
+    uint32_t transfers;
+    uint32_t used_max;
+
+    uint32_t throughput_bytes_sent;
+    uint32_t throughput_bps;
+    uint32_t throughput_max_bps;
+};
+
+struct telemetry_link {
+    // One ring per class, carved from the buffer of the link, so a class can
+    // not take the space of another
+    TX_RING_Inst_Type rings[TELEMETRY_CLASS_COUNT];
+
+    // Guards the rings and the transfer state, which the backend changes from
+    // the interrupt
+    struct k_spinlock lock;
+    telemetry_link_start_fn start;
+    uint32_t bytes_per_s;
+    bool busy;
+
+    // Class of the last transfer, which is continued before any other class
+    // if it ended within its region, as that may be within a frame
+    uint8_t tx_class;
+    size_t tx_len;
+    bool tx_partial;
+
+    // Held by the sending thread from the start to the end of a frame, so
+    // frames of different threads are not interleaved. Senders also hold it
+    // around the whole send call with telemetry_link_lock, as the sequence
+    // number is taken before the start hook runs, and the mutex nests. The
+    // frame is reserved on its first bytes, which hold the message ID it is
+    // classified by.
+    struct k_mutex frame_mutex;
+    bool frame_reserved;
+    uint8_t frame_class;
+    uint8_t *frame;
+    uint16_t frame_len;
+    uint16_t frame_offset;
+
+    struct telemetry_link_stats stats;
+};
+
+static struct telemetry_link links[TELEMETRY_LINK_COUNT];
+
+static uint8_t ground_tx_buffer[CONFIG_APP_TELEMETRY_TX_BUFFER_SIZE];
+#ifdef CONFIG_APP_TELEMETRY_USB
+static uint8_t usb_tx_buffer[CONFIG_APP_TELEMETRY_USB_TX_BUFFER_SIZE];
+#endif
+
+static uint8_t *const tx_buffers[TELEMETRY_LINK_COUNT] = {
+    [TELEMETRY_LINK_GROUND] = ground_tx_buffer,
+#ifdef CONFIG_APP_TELEMETRY_USB
+    [TELEMETRY_LINK_USB] = usb_tx_buffer,
+#endif
+};
+
+static const size_t tx_buffer_sizes[TELEMETRY_LINK_COUNT] = {
+    [TELEMETRY_LINK_GROUND] = sizeof(ground_tx_buffer),
+#ifdef CONFIG_APP_TELEMETRY_USB
+    [TELEMETRY_LINK_USB] = sizeof(usb_tx_buffer),
+#endif
+};
+
+static void throughput_handler(struct k_work *work);
+static K_WORK_DEFINE(throughput_work, throughput_handler);
+
+static void throughput_notify(struct k_timer *timer_id) {
+    k_work_submit(&throughput_work);
+}
+
+K_TIMER_DEFINE(telemetry_link_throughput_timer, throughput_notify, NULL);
+
+static const char *const class_names[TELEMETRY_CLASS_COUNT] = {
+    [TELEMETRY_CLASS_CRITICAL] = "critical",
+    [TELEMETRY_CLASS_NORMAL] = "normal",
+    [TELEMETRY_CLASS_BULK] = "bulk",
+};
+
+// Link keepalive and command replies get through a saturated link, while data
+// which is only useful in volume yields to everything else
+static uint8_t message_class(uint32_t msgid) {
+    switch (msgid) {
+    case MAVLINK_MSG_ID_HEARTBEAT:
+    case MAVLINK_MSG_ID_COMMAND_ACK:
+        return TELEMETRY_CLASS_CRITICAL;
+    case MAVLINK_MSG_ID_SCALED_IMU:
+    case MAVLINK_MSG_ID_IMU_BATCH:
+    case MAVLINK_MSG_ID_LOG_ENTRY:
+    case MAVLINK_MSG_ID_LOG_DATA:
+    case MAVLINK_MSG_ID_LOGGING_DATA:
+    case MAVLINK_MSG_ID_LOGGING_DATA_ACKED:
+        return TELEMETRY_CLASS_BULK;
+    default:
+        return TELEMETRY_CLASS_NORMAL;
+    }
+}
+
+// The first bytes of a frame hold its header, with the message ID
+static uint8_t frame_class(const uint8_t *buf, uint16_t len) {
+    if (len >= MAVLINK_CORE_HEADER_LEN + 1 && buf[0] == MAVLINK_STX) {
+        return message_class(buf[7] | (buf[8] << 8) | ((uint32_t)buf[9] << 16));
+    }
+
+    if (len >= MAVLINK_CORE_HEADER_MAVLINK1_LEN + 1 &&
+        buf[0] == MAVLINK_STX_MAVLINK1) {
+        return message_class(buf[5]);
+    }
+
+    return TELEMETRY_CLASS_NORMAL;
+}
+
+// Hands the longest contiguous region of the highest class with data to the
+// backend, called with the lock held
+static void start_tx(struct telemetry_link *link) {
+    if (link->start == NULL) {
+        return;
+    }
+
+    const uint8_t *data = NULL;
+    size_t len = 0;
+    uint8_t cls = link->tx_class;
+
+    if (link->tx_partial) {
+        len = TX_RING_Claim(&link->rings[cls], &data);
+    } else {
+        for (cls = 0; cls < TELEMETRY_CLASS_COUNT; cls++) {
+            len = TX_RING_Claim(&link->rings[cls], &data);
+            if (len > 0) {
+                break;
+            }
+        }
+    }
+
+    if (len == 0 || link->start(data, len) < 0) {
+        return;
+    }
+
+    link->tx_class = cls;
+    link->tx_len = len;
+    link->busy = true;
+    link->stats.transfers++;
+}
+
+static void throughput_handler(struct k_work *work) {
+    for (int i = 0; i < TELEMETRY_LINK_COUNT; i++) {
+        struct telemetry_link_stats *stats = &links[i].stats;
+
+        const uint32_t bytes_sent = stats->bytes_sent;
+        stats->throughput_bps = (bytes_sent - stats->throughput_bytes_sent) *
+                                MSEC_PER_SEC / THROUGHPUT_PERIOD_MS;
+        stats->throughput_bytes_sent = bytes_sent;
+        stats->throughput_max_bps =
+            MAX(stats->throughput_max_bps, stats->throughput_bps);
+    }
+}
+
+// The critical class gets a fixed share, the rest is split between the normal
+// and the bulk class
+static void init_rings(struct telemetry_link *link, uint8_t *buffer,
+                       size_t size) {
+    const size_t critical_size = CONFIG_APP_TELEMETRY_TX_CRITICAL_SIZE;
+    const size_t bulk_size = (size - critical_size) *
+                             CONFIG_APP_TELEMETRY_TX_BULK_PERCENT / 100;
+    const size_t normal_size = size - critical_size - bulk_size;
+
+    TX_RING_Init(&link->rings[TELEMETRY_CLASS_CRITICAL], buffer,
+                 critical_size);
+    TX_RING_Init(&link->rings[TELEMETRY_CLASS_NORMAL], buffer + critical_size,
+                 normal_size);
+    TX_RING_Init(&link->rings[TELEMETRY_CLASS_BULK],
+                 buffer + critical_size + normal_size, bulk_size);
+}
+
+static int telemetry_link_init(void) {
+    for (int i = 0; i < TELEMETRY_LINK_COUNT; i++) {
+        init_rings(&links[i], tx_buffers[i], tx_buffer_sizes[i]);
+        k_mutex_init(&links[i].frame_mutex);
+    }
+
+    k_timer_start(&telemetry_link_throughput_timer,
+                  K_MSEC(THROUGHPUT_PERIOD_MS), K_MSEC(THROUGHPUT_PERIOD_MS));
+
+    return 0;
+}
+
+SYS_INIT(telemetry_link_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
+int telemetry_link_register(uint8_t chan, telemetry_link_start_fn start,
+                            uint32_t bytes_per_s) {
+    if (chan >= TELEMETRY_LINK_COUNT || start == NULL || bytes_per_s == 0) {
+        return -EINVAL;
+    }
+
+    struct telemetry_link *link = &links[chan];
+
+    K_SPINLOCK(&link->lock) {
+        link->start = start;
+        link->bytes_per_s = bytes_per_s;
+        start_tx(link);
+    }
+
+    return 0;
+}
+
+uint32_t telemetry_link_rate(uint8_t chan) {
+    if (chan >= TELEMETRY_LINK_COUNT) {
+        return 0;
+    }
+
+    return links[chan].bytes_per_s;
+}
+
+size_t telemetry_link_class_size(uint8_t chan, enum telemetry_class cls) {
+    if (chan >= TELEMETRY_LINK_COUNT || cls >= TELEMETRY_CLASS_COUNT) {
+        return 0;
+    }
+
+    return links[chan].rings[cls].size;
+}
+
+size_t telemetry_link_class_used(uint8_t chan, enum telemetry_class cls) {
+    if (chan >= TELEMETRY_LINK_COUNT || cls >= TELEMETRY_CLASS_COUNT) {
+        return 0;
+    }
+
+    size_t used = 0;
+
+    K_SPINLOCK(&links[chan].lock) {
+        used = TX_RING_Used(&links[chan].rings[cls]);
+    }
+
+    return used;
+}
+
+void telemetry_link_tx_done(uint8_t chan, size_t len) {
+    struct telemetry_link *link = &links[chan];
+
+    K_SPINLOCK(&link->lock) {
+        TX_RING_Release(&link->rings[link->tx_class], len);
+        link->stats.bytes_sent += len;
+        link->tx_partial = len < link->tx_len;
+        link->busy = false;
+
+        // Frames committed during the transfer are chained right away
+        start_tx(link);
+    }
+}
+
+void telemetry_link_lock(uint8_t chan) {
+    if (chan >= TELEMETRY_LINK_COUNT) {
+        return;
+    }
+
+    k_mutex_lock(&links[chan].frame_mutex, K_FOREVER);
+}
+
+void telemetry_link_unlock(uint8_t chan) {
+    if (chan >= TELEMETRY_LINK_COUNT) {
+        return;
+    }
+
+    k_mutex_unlock(&links[chan].frame_mutex);
+}
+
+// The MAVLink send functions frame every message straight into the ring of
+// its class, in the order start, bytes and end. The frame becomes visible to
+// the backend only once it is complete.
+void mavlink_start_uart_send(mavlink_channel_t chan, uint16_t len) {
+    if (chan >= TELEMETRY_LINK_COUNT) {
+        return;
+    }
+
+    struct telemetry_link *link = &links[chan];
+
+    k_mutex_lock(&link->frame_mutex, K_FOREVER);
+
+    link->frame_reserved = false;
+    link->frame = NULL;
+    link->frame_len = len;
+    link->frame_offset = 0;
+}
+
+static void reserve_frame(struct telemetry_link *link, const uint8_t *buf,
+                          uint16_t len) {
+    TX_RING_Error_Type status = TX_RING_NO_SPACE;
+
+    link->frame_reserved = true;
+    link->frame_class = frame_class(buf, len);
+
+    K_SPINLOCK(&link->lock) {
+        status = TX_RING_Reserve(&link->rings[link->frame_class],
+                                 link->frame_len, &link->frame);
+    }
+
+    // The whole frame is dropped, a partial frame would corrupt the stream
+    if (status != TX_RING_SUCCESS) {
+        link->frame = NULL;
+        link->stats.frames_dropped[link->frame_class]++;
+    }
+}
+
+void mavlink_send_uart_bytes(mavlink_channel_t chan, const uint8_t *buf,
+                             uint16_t len) {
+    if (chan >= TELEMETRY_LINK_COUNT) {
+        return;
+    }
+
+    struct telemetry_link *link = &links[chan];
+
+    if (!link->frame_reserved) {
+        reserve_frame(link, buf, len);
+    }
+
+    if (link->frame == NULL) {
+        return;
+    }
+
+    if (link->frame_offset + len > link->frame_len) {
+        LOG_ERR("Frame is longer than announced, dropping it!");
+
+        K_SPINLOCK(&link->lock) {
+            TX_RING_Commit(&link->rings[link->frame_class], 0);
+        }
+
+        link->frame = NULL;
+        link->stats.frames_dropped[link->frame_class]++;
+        return;
+    }
+
+    memcpy(&link->frame[link->frame_offset], buf, len);
+    link->frame_offset += len;
+}
+
+void mavlink_end_uart_send(mavlink_channel_t chan, uint16_t len) {
+    if (chan >= TELEMETRY_LINK_COUNT) {
+        return;
+    }
+
+    struct telemetry_link *link = &links[chan];
+
+    if (link->frame != NULL) {
+        K_SPINLOCK(&link->lock) {
+            TX_RING_Commit(&link->rings[link->frame_class],
+                           link->frame_offset);
+            link->stats.frames++;
+            link->stats.used_max =
+                MAX(link->stats.used_max,
+                    TX_RING_Used(&link->rings[link->frame_class]));
+
+            if (!link->busy) {
+                start_tx(link);
+            }
+        }
+
+        link->frame = NULL;
+    }
+
+    k_mutex_unlock(&link->frame_mutex);
+}
+
+int telemetry_link_send_frame(uint8_t chan, const uint8_t *frame,
+                              uint16_t len) {
+    if (chan >= TELEMETRY_LINK_COUNT) {
+        return -EINVAL;
+    }
+
+    // Queued like a frame of the local send functions, so it is classified
+    // and serialized with them the same way
+    mavlink_start_uart_send(chan, len);
+    mavlink_send_uart_bytes(chan, frame, len);
+
+    const bool queued = links[chan].frame != NULL;
+
+    mavlink_end_uart_send(chan, len);
+
+    return queued ? 0 : -ENOBUFS;
+}
+
+uint32_t telemetry_link_dropped(uint8_t chan) {
+    if (chan >= TELEMETRY_LINK_COUNT) {
+        return 0;
+    }
+
+    uint32_t dropped = 0;
+
+    for (int i = 0; i < TELEMETRY_CLASS_COUNT; i++) {
+        dropped += links[chan].stats.frames_dropped[i];
+    }
+
+    return dropped;
+}
+
+static int cmd_telemetry_stats(const struct shell *sh, size_t argc,
+                               char **argv) {
+    for (int i = 0; i < TELEMETRY_LINK_COUNT; i++) {
+        const struct telemetry_link *link = &links[i];
+
+        shell_print(sh, "Link %d: capacity %u bytes/s, %u frames", i,
+                    link->bytes_per_s, link->stats.frames);
+        shell_print(sh, "  Sent: %u bytes in %u transfers",
+                    link->stats.bytes_sent, link->stats.transfers);
+        shell_print(sh, "  Throughput: %u bytes/s, most: %u bytes/s",
+                    link->stats.throughput_bps,
+                    link->stats.throughput_max_bps);
+
+        for (int cls = 0; cls < TELEMETRY_CLASS_COUNT; cls++) {
+            const TX_RING_Inst_Type *ring = &link->rings[cls];
+
+            shell_print(sh, "  %-8s buffered: %u of %u bytes, dropped: %u",
+                        class_names[cls], TX_RING_Used(ring), ring->size,
+                        link->stats.frames_dropped[cls]);
+        }
+
+        shell_print(sh, "  Most buffered in a class: %u bytes",
+                    link->stats.used_max);
+    }
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    telemetry_cmds,
+    SHELL_CMD(stats, NULL, "Show link transmit statistics",
+              cmd_telemetry_stats),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(telemetry, &telemetry_cmds, "Telemetry links", NULL);
@@ -0,0 +1,78 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Links are indexed by the MAVLink channel their frames are sent on
+#define TELEMETRY_LINK_GROUND 0
+#ifdef CONFIG_APP_TELEMETRY_USB
+#define TELEMETRY_LINK_USB 1
+#define TELEMETRY_LINK_COUNT 2
+#else
+#define TELEMETRY_LINK_COUNT 1
+#endif
+
+// Transmit priority classes, drained strictly in this order. Every class has
+// its own part of the transmit buffer, so when the link is saturated only the
+// frames of the class which overflows are dropped.
+enum telemetry_class {
+    TELEMETRY_CLASS_CRITICAL, // Heartbeats and command replies
+    TELEMETRY_CLASS_NORMAL,
+    TELEMETRY_CLASS_BULK, // Log transfers and high rate streams
+    TELEMETRY_CLASS_COUNT,
+};
+
+// Starts sending a contiguous region of the transmit ring without blocking,
+// the backend reports the end of the transfer with telemetry_link_tx_done
+typedef int (*telemetry_link_start_fn)(const uint8_t *data, size_t len);
+
+// Attaches the backend which drains the transmit ring of a link, frames queued
+// before are sent right away. The rate is what the backend can carry, and is
+// used to budget the telemetry streams of the link.
+int telemetry_link_register(uint8_t chan, telemetry_link_start_fn start,
+                            uint32_t bytes_per_s);
+
+// Rate of the link in bytes per second, zero while no backend is attached
+uint32_t telemetry_link_rate(uint8_t chan);
+
+// Size of the transmit ring of a class, which is all its frames can fill no
+// matter how empty the other classes are
+size_t telemetry_link_class_size(uint8_t chan, enum telemetry_class cls);
+
+// Bytes queued in the transmit ring of a class
+size_t telemetry_link_class_used(uint8_t chan, enum telemetry_class cls);
+
+// Frames dropped because the ring of their class was full, so senders which
+// need every frame can tell whether theirs was sent
+uint32_t telemetry_link_dropped(uint8_t chan);
+
+// Held around every MAVLink send call on the link. The send functions take
+// the sequence number of the channel before its frame is started, so without
+// the lock frames of different threads can leave with duplicate or reordered
+// sequence numbers.
+void telemetry_link_lock(uint8_t chan);
+void telemetry_link_unlock(uint8_t chan);
+
+// Queues a complete frame received on another link, as it is. Returns
+// -ENOBUFS if the ring of its class is full.
+int telemetry_link_send_frame(uint8_t chan, const uint8_t *frame,
+                              uint16_t len);
+
+// Frees the bytes sent by the backend and starts the next transfer, can be
+// called from an interrupt
+void telemetry_link_tx_done(uint8_t chan, size_t len);
@@ -15,127 +15,644 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <math.h>
+#include <stdlib.h>
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/util.h>
 #include <zephyr/zbus/zbus.h>
 
 // MAVLink headers
 // clang-format off
 #include "mavlink_custom.h" // Needs to be included before any MAVLink header inclusion
-#include "common/mavlink.h"
+#include "efc/mavlink.h"
 // clang-format on
 
+#include "telemetry_link.h"
+#include "telemetry_packer.h"
+#include "telemetry_params.h"
 #include "types.h"
 
 LOG_MODULE_REGISTER(telemetry_packer);
 
 ZBUS_CHAN_DECLARE(imu_chan);
 ZBUS_CHAN_DECLARE(baro_chan);
+ZBUS_CHAN_DECLARE(attitude_chan);
+ZBUS_CHAN_DECLARE(vertical_state_chan);
+ZBUS_CHAN_DECLARE(battery_chan);
 
-ZBUS_CHAN_DEFINE(heartbeat_chan, bool, NULL, NULL,
-                 ZBUS_OBSERVERS(telemetry_packer_sub), 0);
+mavlink_system_t mavlink_system = {
+    .sysid = 0,
+    .compid = MAV_COMP_ID_AUTOPILOT1,
+};
 
-ZBUS_SUBSCRIBER_DEFINE_WITH_ENABLE(telemetry_packer_sub, 16, false);
+static const uint32_t telemetry_sensors_present =
+    MAV_SYS_STATUS_SENSOR_3D_GYRO | MAV_SYS_STATUS_SENSOR_3D_ACCEL |
+    MAV_SYS_STATUS_SENSOR_ABSOLUTE_PRESSURE | MAV_SYS_STATUS_SENSOR_BATTERY;
 
-const uint8_t telemetry_system_id = 0;
-const uint8_t telemetry_component_id = MAV_COMP_ID_AUTOPILOT1;
-const uint8_t telemetry_channel_ground = MAVLINK_COMM_0;
+// Streams outside of any REQUEST_DATA_STREAM group
+#define STREAM_GROUP_NONE UINT8_MAX
 
-static struct k_timer heartbeat_timer;
+// Every message is sent on its own interval, from the latest value of its
+// topic, so the link load does not depend on the sensor rates
+struct telemetry_stream {
+    const char *name;
+    uint32_t msgid;
+    uint8_t group;      // MAV_DATA_STREAM_* it belongs to
+    uint16_t frame_len; // Longest frame, charged against the link budget
+    int32_t default_interval_ms[TELEMETRY_LINK_COUNT];
+    // Sends the latest value, returns -ENODATA if it was already sent
+    int (*send)(uint8_t chan, uint64_t *last_timestamp_us);
+};
 
-static mavlink_message_t mavlink_msg;
-static uint8_t mavlink_ser_buf[MAVLINK_MAX_PACKET_LEN];
+struct telemetry_stream_state {
+    int32_t interval_us; // Negative while disabled
+    int64_t next_us;
+    uint64_t last_timestamp_us;
+    uint32_t sent;
+    uint32_t deferred;
+};
 
-extern struct k_pipe telemetry_ground_pipe;
+// Every link has its own profile of default intervals
+#ifdef CONFIG_APP_TELEMETRY_USB
+#define STREAM_INTERVALS(msg)                                                  \
+    {CONFIG_APP_TELEMETRY_##msg##_INTERVAL_MS,                                 \
+     CONFIG_APP_TELEMETRY_USB_##msg##_INTERVAL_MS}
+#else
+#define STREAM_INTERVALS(msg) {CONFIG_APP_TELEMETRY_##msg##_INTERVAL_MS}
+#endif
 
-static void heartbeat_notify(struct k_timer *timer_id) {
-    int ret = zbus_chan_notify(&heartbeat_chan, K_NO_WAIT);
+#define STREAM_FRAME_LEN(payload_len)                                          \
+    (MAVLINK_NUM_NON_PAYLOAD_BYTES + (payload_len))
+
+// IMU samples are batched at a fixed interval, every batched sample is the
+// average of the IMU samples in it
+#define IMU_BATCH_RATIO                                                        \
+    (CONFIG_APP_IMU_RATE_HZ / CONFIG_APP_TELEMETRY_IMU_BATCH_RATE_HZ)
+#define IMU_BATCH_DT_US (USEC_PER_SEC / CONFIG_APP_TELEMETRY_IMU_BATCH_RATE_HZ)
+#define IMU_BATCH_SAMPLES (MAVLINK_MSG_IMU_BATCH_FIELD_GYRO_LEN / 3)
+
+BUILD_ASSERT(CONFIG_APP_IMU_RATE_HZ % CONFIG_APP_TELEMETRY_IMU_BATCH_RATE_HZ ==
+                 0,
+             "The IMU rate has to be a multiple of the IMU batch rate");
+
+struct imu_batch_collector {
+    float gyro_sum[3];
+    float accel_sum[3];
+    uint8_t summed;
+
+    float gyro[IMU_BATCH_SAMPLES][3];
+    float accel[IMU_BATCH_SAMPLES][3];
+    uint8_t count;
+    uint64_t time_usec;
+    uint64_t last_us;
+};
+
+// Filled by the listener in the context of the IMU publisher
+static struct imu_batch_collector imu_collector;
+
+// Latest complete batch, sent by the stream of every link
+static mavlink_imu_batch_t imu_batch;
+static struct k_spinlock imu_batch_lock;
+
+// Scales the batch to the full int16 range of its largest value
+static float imu_batch_scale(const float (*values)[3], uint8_t count) {
+    float max = 0.0f;
+
+    for (int i = 0; i < count; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            max = MAX(max, fabsf(values[i][axis]));
+        }
+    }
+
+    return max > 0.0f ? max / INT16_MAX : 1.0f;
+}
+
+static void imu_batch_complete(struct imu_batch_collector *col) {
+    mavlink_imu_batch_t batch = {
+        .time_usec = col->time_usec,
+        .dt_us = IMU_BATCH_DT_US,
+        .count = col->count,
+        .gyro_scale = imu_batch_scale(col->gyro, col->count),
+        .accel_scale = imu_batch_scale(col->accel, col->count),
+    };
+
+    for (int i = 0; i < col->count; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            batch.gyro[i * 3 + axis] =
+                (int16_t)lroundf(col->gyro[i][axis] / batch.gyro_scale);
+            batch.accel[i * 3 + axis] =
+                (int16_t)lroundf(col->accel[i][axis] / batch.accel_scale);
+        }
+    }
+
+    K_SPINLOCK(&imu_batch_lock) {
+        imu_batch = batch;
+    }
+
+    col->count = 0;
+}
+
+static void imu_batch_listener(const struct zbus_channel *chan) {
+    const struct imu_6dof_data *msg = zbus_chan_const_msg(chan);
+    struct imu_batch_collector *col = &imu_collector;
+
+    for (int axis = 0; axis < 3; axis++) {
+        col->gyro_sum[axis] += msg->gyro_radps[axis];
+        col->accel_sum[axis] += msg->accel_mps2[axis];
+    }
+
+    if (++col->summed < IMU_BATCH_RATIO) {
+        return;
+    }
+
+    // A missed sample breaks the fixed interval, so the batch ends before it
+    if (col->count > 0 &&
+        msg->timestamp_us - col->last_us > IMU_BATCH_DT_US * 3 / 2) {
+        imu_batch_complete(col);
+    }
+
+    if (col->count == 0) {
+        col->time_usec = msg->timestamp_us;
+    }
+
+    for (int axis = 0; axis < 3; axis++) {
+        col->gyro[col->count][axis] = col->gyro_sum[axis] / IMU_BATCH_RATIO;
+        col->accel[col->count][axis] = col->accel_sum[axis] / IMU_BATCH_RATIO;
+        col->gyro_sum[axis] = 0.0f;
+        col->accel_sum[axis] = 0.0f;
+    }
+
+    col->summed = 0;
+    col->last_us = msg->timestamp_us;
+
+    if (++col->count == IMU_BATCH_SAMPLES) {
+        imu_batch_complete(col);
+    }
+}
+
+ZBUS_LISTENER_DEFINE(telemetry_imu_batch_lis, imu_batch_listener);
+
+static int send_heartbeat(uint8_t chan, uint64_t *last_timestamp_us) {
+    mavlink_msg_heartbeat_send(chan, MAV_TYPE_GENERIC, MAV_AUTOPILOT_GENERIC,
+                               MAV_MODE_FLAG_MANUAL_INPUT_ENABLED, 0,
+                               MAV_STATE_ACTIVE);
+
+    return 0;
+}
+
+static int send_param_value(uint8_t chan, uint64_t *last_timestamp_us) {
+    return telemetry_params_send_next(chan);
+}
+
+static int send_sys_status(uint8_t chan, uint64_t *last_timestamp_us) {
+    struct battery_data msg;
+    int ret = zbus_chan_read(&battery_chan, &msg, K_USEC(1));
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (msg.timestamp_us == *last_timestamp_us) {
+        return -ENODATA;
+    }
+
+    *last_timestamp_us = msg.timestamp_us;
+
+    const int16_t current_ca =
+        isnan(msg.current_a) ? -1 : (int16_t)(msg.current_a * 100.0f);
+
+    mavlink_msg_sys_status_send(
+        chan, telemetry_sensors_present, telemetry_sensors_present,
+        telemetry_sensors_present, 0, (uint16_t)(msg.voltage_v * 1000.0f),
+        current_ca, (int8_t)(msg.remaining * 100.0f), 0, 0, 0, 0, 0, 0, 0, 0,
+        0);
+
+    return 0;
+}
+
+static int send_battery_status(uint8_t chan, uint64_t *last_timestamp_us) {
+    struct battery_data msg;
+    int ret = zbus_chan_read(&battery_chan, &msg, K_USEC(1));
     if (ret < 0) {
-        LOG_ERR("Could not notify telemetry packer to send heartbeat!");
+        return ret;
+    }
+
+    if (msg.timestamp_us == *last_timestamp_us) {
+        return -ENODATA;
+    }
+
+    *last_timestamp_us = msg.timestamp_us;
+
+    const int16_t current_ca =
+        isnan(msg.current_a) ? -1 : (int16_t)(msg.current_a * 100.0f);
+    const int32_t consumed_mah =
+        isnan(msg.current_a) ? -1 : (int32_t)msg.consumed_mah;
+
+    // Individual cells are not measured, so the total voltage goes into the
+    // first cell as the message definition requires
+    uint16_t voltages_mv[10];
+    uint16_t voltages_ext_mv[4];
+    for (int i = 0; i < ARRAY_SIZE(voltages_mv); i++) {
+        voltages_mv[i] = UINT16_MAX;
+    }
+    for (int i = 0; i < ARRAY_SIZE(voltages_ext_mv); i++) {
+        voltages_ext_mv[i] = 0;
+    }
+    voltages_mv[0] = (uint16_t)(msg.voltage_v * 1000.0f);
+
+    mavlink_msg_battery_status_send(
+        chan, 0, MAV_BATTERY_FUNCTION_ALL, MAV_BATTERY_TYPE_LIPO, INT16_MAX,
+        voltages_mv, current_ca, consumed_mah, -1,
+        (int8_t)(msg.remaining * 100.0f), 0, MAV_BATTERY_CHARGE_STATE_OK,
+        voltages_ext_mv, MAV_BATTERY_MODE_UNKNOWN, 0);
+
+    return 0;
+}
+
+static int send_attitude_quaternion(uint8_t chan,
+                                    uint64_t *last_timestamp_us) {
+    struct attitude_data msg;
+    int ret = zbus_chan_read(&attitude_chan, &msg, K_USEC(1));
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (msg.timestamp_us == *last_timestamp_us) {
+        return -ENODATA;
+    }
+
+    *last_timestamp_us = msg.timestamp_us;
+
+    const float repr_offset_q[4] = {0};
+
+    mavlink_msg_attitude_quaternion_send(
+        chan, msg.timestamp_us / 1000, msg.q[0], msg.q[1], msg.q[2], msg.q[3],
+        msg.rate_radps[0], msg.rate_radps[1], msg.rate_radps[2],
+        repr_offset_q);
+
+    return 0;
+}
+
+static int send_altitude(uint8_t chan, uint64_t *last_timestamp_us) {
+    // Local altitude is reported relative to the first vertical state
+    static bool altitude_origin_set = false;
+    static float altitude_origin_m = 0.0f;
+
+    struct vertical_state_data msg;
+    int ret = zbus_chan_read(&vertical_state_chan, &msg, K_USEC(1));
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (msg.timestamp_us == *last_timestamp_us) {
+        return -ENODATA;
+    }
+
+    *last_timestamp_us = msg.timestamp_us;
+
+    if (!altitude_origin_set) {
+        altitude_origin_m = msg.altitude_m;
+        altitude_origin_set = true;
+    }
+
+    const float altitude_local_m = msg.altitude_m - altitude_origin_m;
+
+    mavlink_msg_altitude_send(chan, msg.timestamp_us, msg.altitude_m,
+                              msg.altitude_m, altitude_local_m,
+                              altitude_local_m, NAN, NAN);
+
+    return 0;
+}
+
+static int send_scaled_imu(uint8_t chan, uint64_t *last_timestamp_us) {
+    struct imu_6dof_data msg;
+    int ret = zbus_chan_read(&imu_chan, &msg, K_USEC(1));
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (msg.timestamp_us == *last_timestamp_us) {
+        return -ENODATA;
+    }
+
+    *last_timestamp_us = msg.timestamp_us;
+
+    mavlink_msg_scaled_imu_send(chan, msg.timestamp_us / 1000,
+                                (int16_t)(msg.accel_mps2[0] * 1000.0f),
+                                (int16_t)(msg.accel_mps2[1] * 1000.0f),
+                                (int16_t)(msg.accel_mps2[2] * 1000.0f),
+                                (int16_t)(msg.gyro_radps[0] * 1000.0f),
+                                (int16_t)(msg.gyro_radps[1] * 1000.0f),
+                                (int16_t)(msg.gyro_radps[2] * 1000.0f), 0, 0, 0,
+                                (int16_t)(msg.temperature_degc * 100.0f));
+
+    return 0;
+}
+
+static int send_imu_batch(uint8_t chan, uint64_t *last_timestamp_us) {
+    mavlink_imu_batch_t batch;
+
+    K_SPINLOCK(&imu_batch_lock) {
+        batch = imu_batch;
+    }
+
+    if (batch.count == 0 || batch.time_usec == *last_timestamp_us) {
+        return -ENODATA;
+    }
+
+    *last_timestamp_us = batch.time_usec;
+
+    mavlink_msg_imu_batch_send_struct(chan, &batch);
+
+    return 0;
+}
+
+static int send_scaled_pressure(uint8_t chan, uint64_t *last_timestamp_us) {
+    struct baro_data msg;
+    int ret = zbus_chan_read(&baro_chan, &msg, K_USEC(1));
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (msg.timestamp_us == *last_timestamp_us) {
+        return -ENODATA;
+    }
+
+    *last_timestamp_us = msg.timestamp_us;
+
+    mavlink_msg_scaled_pressure_send(chan, msg.timestamp_us / 1000,
+                                     msg.pressure_kpa * 10.0f, 0.0f,
+                                     (int16_t)(msg.temperature_degc * 100.0f),
+                                     0);
+
+    return 0;
+}
+
+// Ordered by priority, when the link budget runs out the streams at the end
+// are deferred first
+static const struct telemetry_stream streams[] = {
+    {"HEARTBEAT", MAVLINK_MSG_ID_HEARTBEAT, STREAM_GROUP_NONE,
+     STREAM_FRAME_LEN(MAVLINK_MSG_ID_HEARTBEAT_LEN),
+     STREAM_INTERVALS(HEARTBEAT), send_heartbeat},
+    {"SYS_STATUS", MAVLINK_MSG_ID_SYS_STATUS, MAV_DATA_STREAM_EXTENDED_STATUS,
+     STREAM_FRAME_LEN(MAVLINK_MSG_ID_SYS_STATUS_LEN),
+     STREAM_INTERVALS(SYS_STATUS), send_sys_status},
+    {"PARAM_VALUE", MAVLINK_MSG_ID_PARAM_VALUE, STREAM_GROUP_NONE,
+     STREAM_FRAME_LEN(MAVLINK_MSG_ID_PARAM_VALUE_LEN),
+     STREAM_INTERVALS(PARAM), send_param_value},
+    {"ATTITUDE_QUATERNION", MAVLINK_MSG_ID_ATTITUDE_QUATERNION,
+     MAV_DATA_STREAM_EXTRA1,
+     STREAM_FRAME_LEN(MAVLINK_MSG_ID_ATTITUDE_QUATERNION_LEN),
+     STREAM_INTERVALS(ATTITUDE), send_attitude_quaternion},
+    {"ALTITUDE", MAVLINK_MSG_ID_ALTITUDE, MAV_DATA_STREAM_POSITION,
+     STREAM_FRAME_LEN(MAVLINK_MSG_ID_ALTITUDE_LEN),
+     STREAM_INTERVALS(ALTITUDE), send_altitude},
+    {"BATTERY_STATUS", MAVLINK_MSG_ID_BATTERY_STATUS,
+     MAV_DATA_STREAM_EXTENDED_STATUS,
+     STREAM_FRAME_LEN(MAVLINK_MSG_ID_BATTERY_STATUS_LEN),
+     STREAM_INTERVALS(BATTERY_STATUS), send_battery_status},
+    {"SCALED_IMU", MAVLINK_MSG_ID_SCALED_IMU, MAV_DATA_STREAM_RAW_SENSORS,
+     STREAM_FRAME_LEN(MAVLINK_MSG_ID_SCALED_IMU_LEN),
+     STREAM_INTERVALS(SCALED_IMU), send_scaled_imu},
+    {"IMU_BATCH", MAVLINK_MSG_ID_IMU_BATCH, MAV_DATA_STREAM_RAW_SENSORS,
+     STREAM_FRAME_LEN(MAVLINK_MSG_ID_IMU_BATCH_LEN),
+     STREAM_INTERVALS(IMU_BATCH), send_imu_batch},
+    {"SCALED_PRESSURE", MAVLINK_MSG_ID_SCALED_PRESSURE,
+     MAV_DATA_STREAM_RAW_SENSORS,
+     STREAM_FRAME_LEN(MAVLINK_MSG_ID_SCALED_PRESSURE_LEN),
+     STREAM_INTERVALS(SCALED_PRESSURE), send_scaled_pressure},
+};
+
+#define STREAM_COUNT ARRAY_SIZE(streams)
+
+static struct telemetry_stream_state states[TELEMETRY_LINK_COUNT]
+                                           [STREAM_COUNT];
+
+// Bytes the link can still take, scaled by a million so the budget added in
+// every tick is exact at any rate
+static int64_t link_budget[TELEMETRY_LINK_COUNT];
+
+// Guards the intervals, which are also changed on request of the ground
+static K_MUTEX_DEFINE(stream_mutex);
+
+K_TIMER_DEFINE(telemetry_stream_timer, NULL, NULL);
+
+static int32_t default_interval_us(uint8_t chan,
+                                   const struct telemetry_stream *stream) {
+    if (stream->default_interval_ms[chan] == 0) {
+        return -1;
+    }
+
+    return stream->default_interval_ms[chan] * USEC_PER_MSEC;
+}
+
+static int find_stream(uint32_t msgid) {
+    for (int i = 0; i < STREAM_COUNT; i++) {
+        if (streams[i].msgid == msgid) {
+            return i;
+        }
+    }
+
+    return -ENOENT;
+}
+
+static void set_interval(uint8_t chan, int stream, int32_t interval_us) {
+    struct telemetry_stream_state *state = &states[chan][stream];
+
+    state->interval_us = interval_us;
+    state->next_us = k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+int telemetry_stream_set_interval(uint8_t chan, uint32_t msgid,
+                                  int32_t interval_us) {
+    if (chan >= TELEMETRY_LINK_COUNT) {
+        return -EINVAL;
+    }
+
+    const int stream = find_stream(msgid);
+    if (stream < 0) {
+        return stream;
+    }
+
+    if (interval_us == 0) {
+        interval_us = default_interval_us(chan, &streams[stream]);
+    } else if (interval_us < 0) {
+        interval_us = -1;
+    }
+
+    k_mutex_lock(&stream_mutex, K_FOREVER);
+    set_interval(chan, stream, interval_us);
+    k_mutex_unlock(&stream_mutex);
+
+    return 0;
+}
+
+int32_t telemetry_stream_get_interval(uint8_t chan, uint32_t msgid) {
+    const int stream = find_stream(msgid);
+    if (chan >= TELEMETRY_LINK_COUNT || stream < 0) {
+        return 0;
+    }
+
+    return states[chan][stream].interval_us;
+}
+
+int telemetry_stream_request(uint8_t chan, uint8_t group, uint16_t rate_hz,
+                             bool start) {
+    if (chan >= TELEMETRY_LINK_COUNT) {
+        return -EINVAL;
+    }
+
+    const int32_t interval_us =
+        (start && rate_hz > 0) ? (int32_t)(USEC_PER_SEC / rate_hz) : -1;
+    int ret = -ENOENT;
+
+    k_mutex_lock(&stream_mutex, K_FOREVER);
+
+    for (int i = 0; i < STREAM_COUNT; i++) {
+        if (streams[i].group == STREAM_GROUP_NONE) {
+            continue;
+        }
+
+        if (group == MAV_DATA_STREAM_ALL || group == streams[i].group) {
+            set_interval(chan, i, interval_us);
+            ret = 0;
+        }
+    }
+
+    k_mutex_unlock(&stream_mutex);
+
+    return ret;
+}
+
+static void schedule_link(uint8_t chan, int64_t now_us, int64_t elapsed_us) {
+    const uint32_t bytes_per_s = telemetry_link_rate(chan);
+    if (bytes_per_s == 0) {
+        return;
+    }
+
+    // Up to two ticks worth of bytes are saved up, but at least one frame of
+    // any length, so slow links still send long messages
+    const int64_t budget_max =
+        MAX((int64_t)bytes_per_s * CONFIG_APP_TELEMETRY_STREAM_TICK_MS * 2 *
+                USEC_PER_MSEC,
+            (int64_t)MAVLINK_MAX_PACKET_LEN * USEC_PER_SEC);
+
+    // A backlog means the link carries less than its nominal rate, e.g. a
+    // radio retrying, so nothing is added to the budget until it drains. Only
+    // the normal class is looked at, the bulk class is kept full by log
+    // transfers on a healthy link too.
+    if (telemetry_link_class_used(chan, TELEMETRY_CLASS_NORMAL) <
+        telemetry_link_class_size(chan, TELEMETRY_CLASS_NORMAL) / 2) {
+        link_budget[chan] = MIN(
+            link_budget[chan] + (int64_t)bytes_per_s * elapsed_us, budget_max);
+    }
+
+    bool exhausted = false;
+
+    for (int i = 0; i < STREAM_COUNT; i++) {
+        const struct telemetry_stream *stream = &streams[i];
+        struct telemetry_stream_state *state = &states[chan][i];
+
+        if (state->interval_us < 0 || now_us < state->next_us) {
+            continue;
+        }
+
+        // Once a stream does not fit, every stream of lower priority waits
+        // too, so the budget left over goes to the higher priority first
+        const int64_t cost = (int64_t)stream->frame_len * USEC_PER_SEC;
+        if (exhausted || cost > link_budget[chan]) {
+            exhausted = true;
+            state->deferred++;
+            continue;
+        }
+
+        // Without a new value the stream stays due and is sent as soon as the
+        // topic is published
+        telemetry_link_lock(chan);
+        const int ret = stream->send(chan, &state->last_timestamp_us);
+        telemetry_link_unlock(chan);
+
+        if (ret < 0) {
+            continue;
+        }
+
+        link_budget[chan] -= cost;
+        state->sent++;
+
+        // A late stream is caught up with once, not by sending a burst
+        state->next_us = MAX(state->next_us + state->interval_us, now_us);
     }
 }
 
 void telemetry_packer(void *dummy1, void *dummy2, void *dummy3) {
-    k_timer_init(&heartbeat_timer, heartbeat_notify, NULL);
-    k_timer_start(&heartbeat_timer, K_SECONDS(1), K_SECONDS(1));
+    for (int chan = 0; chan < TELEMETRY_LINK_COUNT; chan++) {
+        for (int i = 0; i < STREAM_COUNT; i++) {
+            set_interval(chan, i, default_interval_us(chan, &streams[i]));
+        }
+    }
+
+    k_timer_start(&telemetry_stream_timer,
+                  K_MSEC(CONFIG_APP_TELEMETRY_STREAM_TICK_MS),
+                  K_MSEC(CONFIG_APP_TELEMETRY_STREAM_TICK_MS));
 
-    zbus_obs_set_enable(&telemetry_packer_sub, true);
+    int64_t last_us = k_ticks_to_us_floor64(k_uptime_ticks());
 
     while (true) {
-        const struct zbus_channel *chan;
-        int ret = zbus_sub_wait(&telemetry_packer_sub, &chan, K_FOREVER);
-        if (ret < 0) {
-            LOG_ERR(
-                "Could not wait on the telemetry packer subscriber, aborting.");
-            return;
+        k_timer_status_sync(&telemetry_stream_timer);
+
+        const int64_t now_us = k_ticks_to_us_floor64(k_uptime_ticks());
+
+        k_mutex_lock(&stream_mutex, K_FOREVER);
+
+        for (int chan = 0; chan < TELEMETRY_LINK_COUNT; chan++) {
+            schedule_link(chan, now_us, now_us - last_us);
         }
 
-        if (chan == &imu_chan) {
-            struct imu_6dof_data msg;
-            ret = zbus_chan_read(chan, &msg, K_USEC(1));
-            if (ret < 0) {
-                LOG_ERR("Failed to read from logger subscriber!");
-            }
-
-            mavlink_msg_scaled_imu_pack_chan(
-                telemetry_system_id, telemetry_component_id,
-                telemetry_channel_ground, &mavlink_msg, msg.timestamp_us / 1000,
-                (int16_t)(msg.accel_mps2[0] * 1000.0f),
-                (int16_t)(msg.accel_mps2[1] * 1000.0f),
-                (int16_t)(msg.accel_mps2[2] * 1000.0f),
-                (int16_t)(msg.gyro_radps[0] * 1000.0f),
-                (int16_t)(msg.gyro_radps[1] * 1000.0f),
-                (int16_t)(msg.gyro_radps[2] * 1000.0f), 0, 0, 0,
-                (int16_t)(msg.temperature_degc * 100.0f));
-
-            const uint16_t telemetry_msg_len =
-                mavlink_msg_to_send_buffer(mavlink_ser_buf, &mavlink_msg);
-
-            ret = k_pipe_write(&telemetry_ground_pipe, mavlink_ser_buf,
-                               telemetry_msg_len, K_NO_WAIT);
-
-            if (ret < 0) {
-                LOG_WRN("Could not fit data into telemetry pipe!");
-            }
-
-        } else if (chan == &baro_chan) {
-            struct baro_data msg;
-            ret = zbus_chan_read(chan, &msg, K_USEC(1));
-            if (ret < 0) {
-                LOG_ERR("Failed to read from logger subscriber!");
-            }
-
-            mavlink_msg_scaled_pressure_pack_chan(
-                telemetry_system_id, telemetry_component_id,
-                telemetry_channel_ground, &mavlink_msg, msg.timestamp_us / 1000,
-                msg.pressure_kpa * 10.0f, 0.0f,
-                (int16_t)(msg.temperature_degc * 100.0f), 0);
-
-            const uint16_t telemetry_msg_len =
-                mavlink_msg_to_send_buffer(mavlink_ser_buf, &mavlink_msg);
-
-            ret = k_pipe_write(&telemetry_ground_pipe, mavlink_ser_buf,
-                               telemetry_msg_len, K_NO_WAIT);
-
-            if (ret < 0) {
-                LOG_WRN("Could not fit data into telemetry pipe!");
-            }
-        } else if (chan == &heartbeat_chan) {
-            mavlink_msg_heartbeat_pack_chan(
-                telemetry_system_id, telemetry_component_id,
-                telemetry_channel_ground, &mavlink_msg, MAV_TYPE_GENERIC,
-                MAV_AUTOPILOT_GENERIC, MAV_MODE_FLAG_MANUAL_INPUT_ENABLED, 0,
-                MAV_STATE_ACTIVE);
-
-            const uint16_t telemetry_msg_len =
-                mavlink_msg_to_send_buffer(mavlink_ser_buf, &mavlink_msg);
-
-            int ret = k_pipe_write(&telemetry_ground_pipe, mavlink_ser_buf,
-                                   telemetry_msg_len, K_NO_WAIT);
-
-            if (ret < 0) {
-                LOG_WRN("Could not fit data into telemetry pipe!");
-            }
+        k_mutex_unlock(&stream_mutex);
+
+        last_us = now_us;
+    }
+}
+
+static int cmd_stream_show(const struct shell *sh, size_t argc, char **argv) {
+    for (int chan = 0; chan < TELEMETRY_LINK_COUNT; chan++) {
+        shell_print(sh, "Link %d:", chan);
+
+        for (int i = 0; i < STREAM_COUNT; i++) {
+            const struct telemetry_stream_state *state = &states[chan][i];
+
+            shell_print(sh, "  %-20s %6d us, sent: %u, deferred: %u",
+                        streams[i].name, state->interval_us, state->sent,
+                        state->deferred);
         }
     }
+
+    return 0;
+}
+
+static int cmd_stream_interval(const struct shell *sh, size_t argc,
+                               char **argv) {
+    const uint8_t chan = (uint8_t)strtoul(argv[1], NULL, 10);
+    const uint32_t msgid = strtoul(argv[2], NULL, 10);
+    const int32_t interval_us = strtol(argv[3], NULL, 10);
+
+    int ret = telemetry_stream_set_interval(chan, msgid, interval_us);
+    if (ret < 0) {
+        shell_error(sh, "Message %u is not streamed on link %u", msgid, chan);
+        return ret;
+    }
+
+    return 0;
 }
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    stream_cmds,
+    SHELL_CMD(show, NULL, "Show the intervals of all streams", cmd_stream_show),
+    SHELL_CMD_ARG(interval, NULL,
+                  "Set a message interval: <link> <msgid> <interval us>, "
+                  "-1 disables, 0 restores the default",
+                  cmd_stream_interval, 4, 0),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(stream, &stream_cmds, "Telemetry streams", NULL);
@@ -15,4 +15,22 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdbool.h>
+#include <stdint.h>
+
 void telemetry_packer(void *dummy1, void *dummy2, void *dummy3);
+
+// Sets the interval of a message on a link as MAV_CMD_SET_MESSAGE_INTERVAL
+// does, a negative interval disables it and zero restores the default.
+// Returns -ENOENT if the message is not streamed.
+int telemetry_stream_set_interval(uint8_t chan, uint32_t msgid,
+                                  int32_t interval_us);
+
+// Gets the interval of a message as MAV_CMD_GET_MESSAGE_INTERVAL reports it,
+// -1 while disabled and zero if the message is not streamed
+int32_t telemetry_stream_get_interval(uint8_t chan, uint32_t msgid);
+
+// Starts or stops a MAV_DATA_STREAM group as REQUEST_DATA_STREAM does.
+// Returns -ENOENT if no stream belongs to the group.
+int telemetry_stream_request(uint8_t chan, uint8_t group, uint16_t rate_hz,
+                             bool start);
@@ -0,0 +1,142 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+
+// MAVLink headers
+// clang-format off
+#include "mavlink_custom.h" // Needs to be included before any MAVLink header inclusion
+#include "efc/mavlink.h"
+// clang-format on
+
+#include "params.h"
+#include "telemetry_link.h"
+#include "telemetry_params.h"
+
+LOG_MODULE_REGISTER(telemetry_params);
+
+// Parameters of the requested list still to be sent on every link, the list
+// is sent by the stream scheduler within the link budget
+static atomic_t list_remaining[TELEMETRY_LINK_COUNT];
+
+static bool is_for_us(uint8_t target_system) {
+    return target_system == 0 || target_system == mavlink_system.sysid;
+}
+
+// Integers are sent cast to float, which is exact up to 2^24
+static void send_param_value(uint8_t chan, enum param_id id) {
+    char name[PARAM_NAME_LEN] = {0};
+    strncpy(name, param_name(id), sizeof(name));
+
+    float value;
+    uint8_t type;
+
+    if (param_type(id) == PARAM_TYPE_INT32) {
+        value = (float)param_get_int32(id);
+        type = MAV_PARAM_TYPE_INT32;
+    } else {
+        value = param_get_float(id);
+        type = MAV_PARAM_TYPE_REAL32;
+    }
+
+    telemetry_link_lock(chan);
+    mavlink_msg_param_value_send(chan, name, value, type, PARAM_COUNT, id);
+    telemetry_link_unlock(chan);
+}
+
+void telemetry_params_handle_request_list(uint8_t chan,
+                                          const mavlink_message_t *msg) {
+    if (chan >= TELEMETRY_LINK_COUNT ||
+        !is_for_us(mavlink_msg_param_request_list_get_target_system(msg))) {
+        return;
+    }
+
+    // A new request restarts the list
+    atomic_set(&list_remaining[chan], PARAM_COUNT);
+}
+
+void telemetry_params_handle_request_read(uint8_t chan,
+                                          const mavlink_message_t *msg) {
+    mavlink_param_request_read_t req;
+    mavlink_msg_param_request_read_decode(msg, &req);
+
+    if (!is_for_us(req.target_system)) {
+        return;
+    }
+
+    // The index is used unless it is negative, then the name
+    int id;
+    if (req.param_index >= 0) {
+        id = req.param_index < PARAM_COUNT ? req.param_index : -ENOENT;
+    } else {
+        id = param_find(req.param_id);
+    }
+
+    if (id < 0) {
+        return;
+    }
+
+    send_param_value(chan, id);
+}
+
+void telemetry_params_handle_set(uint8_t chan, const mavlink_message_t *msg) {
+    mavlink_param_set_t set;
+    mavlink_msg_param_set_decode(msg, &set);
+
+    if (!is_for_us(set.target_system)) {
+        return;
+    }
+
+    const int id = param_find(set.param_id);
+    if (id < 0) {
+        LOG_WRN("Set of unknown parameter %.16s", set.param_id);
+        return;
+    }
+
+    union param_value value;
+    if (param_type(id) == PARAM_TYPE_INT32) {
+        value.i = (int32_t)set.param_value;
+    } else {
+        value.f = set.param_value;
+    }
+
+    if (param_set(id, value) < 0) {
+        LOG_WRN("Rejected out of range value for %s", param_name(id));
+    }
+
+    // The current value is sent back either way, which tells the GCS
+    // whether the set was accepted
+    send_param_value(chan, id);
+}
+
+int telemetry_params_send_next(uint8_t chan) {
+    atomic_val_t remaining;
+
+    do {
+        remaining = atomic_get(&list_remaining[chan]);
+        if (remaining <= 0) {
+            return -ENODATA;
+        }
+    } while (!atomic_cas(&list_remaining[chan], remaining, remaining - 1));
+
+    send_param_value(chan, PARAM_COUNT - remaining);
+
+    return 0;
+}
@@ -0,0 +1,32 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+
+struct __mavlink_message;
+
+// PARAM protocol handlers for the receiver dispatch table
+void telemetry_params_handle_request_list(uint8_t chan,
+                                          const struct __mavlink_message *msg);
+void telemetry_params_handle_request_read(uint8_t chan,
+                                          const struct __mavlink_message *msg);
+void telemetry_params_handle_set(uint8_t chan,
+                                 const struct __mavlink_message *msg);
+
+// Sends the next parameter of a requested list on the link, returns -ENODATA
+// when the whole list was sent
+int telemetry_params_send_next(uint8_t chan);
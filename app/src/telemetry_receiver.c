@@ -0,0 +1,378 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/ring_buffer.h>
+
+// MAVLink headers
+// clang-format off
+#include "mavlink_custom.h" // Needs to be included before any MAVLink header inclusion
+#include "efc/mavlink.h"
+// clang-format on
+
+#include "log_stream.h"
+#include "log_transfer.h"
+#include "telemetry_link.h"
+#include "telemetry_packer.h"
+#include "telemetry_params.h"
+#include "telemetry_receiver.h"
+#include "telemetry_router.h"
+
+LOG_MODULE_REGISTER(telemetry_receiver);
+
+// A GCS is considered lost after missing this many heartbeats
+#define GCS_TIMEOUT_MS 3000
+
+struct telemetry_receiver_stats {
+    uint32_t bytes;
+    uint32_t frames;
+    uint32_t unhandled;
+    uint32_t bytes_dropped;
+    uint32_t rx_errors;
+    uint32_t parse_errors;
+    uint32_t bad_crc; // Also counts frames failing the signature check
+    uint32_t seq_lost;
+};
+
+struct telemetry_receiver_link {
+    // Filled by the backend, which is its only producer, and drained by the
+    // receiver thread, so it needs no lock
+    struct ring_buf ring;
+    uint8_t buffer[CONFIG_APP_TELEMETRY_RX_BUFFER_SIZE];
+
+    // Raw bytes of the frame being parsed, held whenever it spans two claims
+    // of the ring, because it wraps around the end of the ring or its rest
+    // had not been received yet. Otherwise it is routed straight from the
+    // ring.
+    uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+    uint16_t frame_held;
+    bool frame_active;
+
+    // Sender of the last good frame, gaps are only counted between frames
+    // of the same sender, which covers the usual single GCS on a link
+    uint8_t last_sysid;
+    uint8_t last_compid;
+    uint8_t last_seq;
+    bool seq_valid;
+
+    int64_t gcs_heartbeat_ms;
+    bool gcs_connected;
+
+    struct telemetry_receiver_stats stats;
+};
+
+struct telemetry_handler {
+    uint32_t msgid;
+    void (*handle)(uint8_t chan, const mavlink_message_t *msg);
+};
+
+static struct telemetry_receiver_link links[TELEMETRY_LINK_COUNT];
+
+static K_SEM_DEFINE(rx_sem, 0, 1);
+
+static int telemetry_receiver_init(void) {
+    for (int i = 0; i < TELEMETRY_LINK_COUNT; i++) {
+        ring_buf_init(&links[i].ring, sizeof(links[i].buffer),
+                      links[i].buffer);
+    }
+
+    return 0;
+}
+
+SYS_INIT(telemetry_receiver_init, APPLICATION,
+         CONFIG_APPLICATION_INIT_PRIORITY);
+
+void telemetry_receiver_feed(uint8_t chan, const uint8_t *data, size_t len) {
+    if (chan >= TELEMETRY_LINK_COUNT) {
+        return;
+    }
+
+    struct telemetry_receiver_link *link = &links[chan];
+
+    const uint32_t queued = ring_buf_put(&link->ring, data, len);
+    link->stats.bytes_dropped += len - queued;
+
+    k_sem_give(&rx_sem);
+}
+
+void telemetry_receiver_error(uint8_t chan) {
+    if (chan >= TELEMETRY_LINK_COUNT) {
+        return;
+    }
+
+    links[chan].stats.rx_errors++;
+}
+
+static bool is_for_us(uint8_t target_system) {
+    return target_system == 0 || target_system == mavlink_system.sysid;
+}
+
+static void handle_heartbeat(uint8_t chan, const mavlink_message_t *msg) {
+    if (mavlink_msg_heartbeat_get_type(msg) != MAV_TYPE_GCS) {
+        return;
+    }
+
+    struct telemetry_receiver_link *link = &links[chan];
+
+    if (!link->gcs_connected) {
+        LOG_INF("GCS %u connected on link %u", msg->sysid, chan);
+        link->gcs_connected = true;
+    }
+
+    link->gcs_heartbeat_ms = k_uptime_get();
+}
+
+static void handle_command_long(uint8_t chan, const mavlink_message_t *msg) {
+    mavlink_command_long_t cmd;
+    mavlink_msg_command_long_decode(msg, &cmd);
+
+    if (!is_for_us(cmd.target_system)) {
+        return;
+    }
+
+    uint8_t result = MAV_RESULT_UNSUPPORTED;
+
+    switch (cmd.command) {
+    case MAV_CMD_SET_MESSAGE_INTERVAL: {
+        const int ret = telemetry_stream_set_interval(
+            chan, (uint32_t)cmd.param1, (int32_t)cmd.param2);
+        result = ret < 0 ? MAV_RESULT_DENIED : MAV_RESULT_ACCEPTED;
+        break;
+    }
+    case MAV_CMD_GET_MESSAGE_INTERVAL: {
+        // Read before the link is locked, the scheduler locks the link while
+        // holding the streams
+        const int32_t interval_us =
+            telemetry_stream_get_interval(chan, (uint32_t)cmd.param1);
+
+        telemetry_link_lock(chan);
+        mavlink_msg_message_interval_send(chan, (uint16_t)cmd.param1,
+                                          interval_us);
+        telemetry_link_unlock(chan);
+        result = MAV_RESULT_ACCEPTED;
+        break;
+    }
+    case MAV_CMD_LOGGING_START: {
+        const int ret = log_stream_start(chan, msg->sysid, msg->compid);
+        result = ret < 0 ? MAV_RESULT_DENIED : MAV_RESULT_ACCEPTED;
+        break;
+    }
+    case MAV_CMD_LOGGING_STOP:
+        log_stream_stop();
+        result = MAV_RESULT_ACCEPTED;
+        break;
+    default:
+        break;
+    }
+
+    telemetry_link_lock(chan);
+    mavlink_msg_command_ack_send(chan, cmd.command, result, 0, 0, msg->sysid,
+                                 msg->compid);
+    telemetry_link_unlock(chan);
+}
+
+static void handle_request_data_stream(uint8_t chan,
+                                       const mavlink_message_t *msg) {
+    mavlink_request_data_stream_t req;
+    mavlink_msg_request_data_stream_decode(msg, &req);
+
+    if (!is_for_us(req.target_system)) {
+        return;
+    }
+
+    telemetry_stream_request(chan, req.req_stream_id, req.req_message_rate,
+                             req.start_stop != 0);
+}
+
+static const struct telemetry_handler handlers[] = {
+    {MAVLINK_MSG_ID_HEARTBEAT, handle_heartbeat},
+    {MAVLINK_MSG_ID_COMMAND_LONG, handle_command_long},
+    {MAVLINK_MSG_ID_REQUEST_DATA_STREAM, handle_request_data_stream},
+    {MAVLINK_MSG_ID_PARAM_REQUEST_LIST, telemetry_params_handle_request_list},
+    {MAVLINK_MSG_ID_PARAM_REQUEST_READ, telemetry_params_handle_request_read},
+    {MAVLINK_MSG_ID_PARAM_SET, telemetry_params_handle_set},
+    {MAVLINK_MSG_ID_LOG_REQUEST_LIST, log_transfer_handle_request_list},
+    {MAVLINK_MSG_ID_LOG_REQUEST_DATA, log_transfer_handle_request_data},
+    {MAVLINK_MSG_ID_LOG_REQUEST_END, log_transfer_handle_request_end},
+    {MAVLINK_MSG_ID_LOGGING_ACK, log_stream_handle_ack},
+};
+
+static void dispatch(uint8_t chan, const mavlink_message_t *msg) {
+    for (int i = 0; i < ARRAY_SIZE(handlers); i++) {
+        if (handlers[i].msgid == msg->msgid) {
+            handlers[i].handle(chan, msg);
+            return;
+        }
+    }
+
+    links[chan].stats.unhandled++;
+}
+
+static void count_seq_lost(uint8_t chan, const mavlink_message_t *msg) {
+    struct telemetry_receiver_link *link = &links[chan];
+
+    if (link->seq_valid && msg->sysid == link->last_sysid &&
+        msg->compid == link->last_compid) {
+        link->stats.seq_lost += (uint8_t)(msg->seq - link->last_seq - 1);
+    }
+
+    link->last_sysid = msg->sysid;
+    link->last_compid = msg->compid;
+    link->last_seq = msg->seq;
+    link->seq_valid = true;
+}
+
+static void route_frame(uint8_t chan, const mavlink_message_t *msg,
+                        const uint8_t *data, uint32_t len) {
+    struct telemetry_receiver_link *link = &links[chan];
+
+    if (link->frame_held == 0) {
+        telemetry_router_route(chan, msg, data, len);
+        return;
+    }
+
+    if (link->frame_held + len > sizeof(link->frame)) {
+        telemetry_router_drop(chan);
+        return;
+    }
+
+    memcpy(&link->frame[link->frame_held], data, len);
+    telemetry_router_route(chan, msg, link->frame, link->frame_held + len);
+}
+
+static void hold_frame(uint8_t chan, const uint8_t *data, uint32_t len) {
+    struct telemetry_receiver_link *link = &links[chan];
+
+    // The frame is not routed once it is complete, so it is counted here
+    if (link->frame_held + len > sizeof(link->frame)) {
+        link->frame_active = false;
+        telemetry_router_drop(chan);
+        return;
+    }
+
+    memcpy(&link->frame[link->frame_held], data, len);
+    link->frame_held += len;
+}
+
+static void parse_link(uint8_t chan) {
+    struct telemetry_receiver_link *link = &links[chan];
+    uint8_t *data;
+    uint32_t len;
+
+    while ((len = ring_buf_get_claim(&link->ring, &data, UINT32_MAX)) > 0) {
+        uint32_t start = 0;
+
+        for (uint32_t i = 0; i < len; i++) {
+            mavlink_message_t msg;
+            mavlink_status_t status;
+
+            const uint8_t ret =
+                mavlink_frame_char(chan, data[i], &msg, &status);
+
+            // The channel clears its error count on every call and hands it
+            // over in the drop count of the returned status
+            link->stats.parse_errors += status.packet_rx_drop_count;
+
+            if (status.parse_state == MAVLINK_PARSE_STATE_GOT_STX) {
+                link->frame_active = true;
+                link->frame_held = 0;
+                start = i;
+            }
+
+            if (ret == MAVLINK_FRAMING_INCOMPLETE) {
+                continue;
+            }
+
+            // Frames of messages this dialect does not know can not have
+            // their CRC checked, they are still routed to the other links
+            if (link->frame_active &&
+                (ret == MAVLINK_FRAMING_OK ||
+                 (ret == MAVLINK_FRAMING_BAD_CRC &&
+                  mavlink_get_msg_entry(msg.msgid) == NULL))) {
+                route_frame(chan, &msg, &data[start], i + 1 - start);
+            }
+
+            link->frame_active = false;
+
+            if (ret == MAVLINK_FRAMING_OK) {
+                link->stats.frames++;
+                count_seq_lost(chan, &msg);
+                dispatch(chan, &msg);
+            } else if (ret == MAVLINK_FRAMING_BAD_SIGNATURE ||
+                       mavlink_get_msg_entry(msg.msgid) != NULL) {
+                link->stats.bad_crc++;
+            }
+        }
+
+        // The rest of the frame is in the next claim
+        if (link->frame_active) {
+            hold_frame(chan, &data[start], len - start);
+        }
+
+        link->stats.bytes += len;
+        ring_buf_get_finish(&link->ring, len);
+    }
+
+    if (link->gcs_connected &&
+        k_uptime_get() - link->gcs_heartbeat_ms > GCS_TIMEOUT_MS) {
+        LOG_WRN("GCS lost on link %u", chan);
+        link->gcs_connected = false;
+    }
+}
+
+void telemetry_receiver(void *dummy1, void *dummy2, void *dummy3) {
+    while (true) {
+        // Woken up by received data, and at least once per second to notice
+        // a GCS which went silent
+        k_sem_take(&rx_sem, K_SECONDS(1));
+
+        for (int chan = 0; chan < TELEMETRY_LINK_COUNT; chan++) {
+            parse_link(chan);
+        }
+    }
+}
+
+static int cmd_receiver_stats(const struct shell *sh, size_t argc,
+                              char **argv) {
+    for (int i = 0; i < TELEMETRY_LINK_COUNT; i++) {
+        const struct telemetry_receiver_link *link = &links[i];
+
+        shell_print(sh, "Link %d: GCS %s", i,
+                    link->gcs_connected ? "connected" : "not connected");
+        shell_print(sh, "  Received: %u bytes, %u frames, unhandled: %u",
+                    link->stats.bytes, link->stats.frames,
+                    link->stats.unhandled);
+        shell_print(sh, "  Parse errors: %u, bad CRC: %u, sequence lost: %u",
+                    link->stats.parse_errors, link->stats.bad_crc,
+                    link->stats.seq_lost);
+        shell_print(sh, "  Overruns: %u bytes dropped, %u receive errors",
+                    link->stats.bytes_dropped, link->stats.rx_errors);
+    }
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    receiver_cmds,
+    SHELL_CMD(stats, NULL, "Show link receive statistics", cmd_receiver_stats),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(receiver, &receiver_cmds, "Telemetry receiver", NULL);
@@ -0,0 +1,28 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Queues bytes received on a link for the receiver thread, can be called from
+// an interrupt. Bytes which do not fit are dropped and counted.
+void telemetry_receiver_feed(uint8_t chan, const uint8_t *data, size_t len);
+
+// Counts reception errors reported by the backend, e.g. UART overruns
+void telemetry_receiver_error(uint8_t chan);
+
+void telemetry_receiver(void *dummy1, void *dummy2, void *dummy3);
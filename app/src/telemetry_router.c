@@ -0,0 +1,184 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/util.h>
+
+// MAVLink headers
+// clang-format off
+#include "mavlink_custom.h" // Needs to be included before any MAVLink header inclusion
+#include "efc/mavlink.h"
+// clang-format on
+
+#include "telemetry_link.h"
+#include "telemetry_router.h"
+
+LOG_MODULE_REGISTER(telemetry_router);
+
+// A system which was not heard from for this long is no longer routed to
+#define ROUTE_TIMEOUT_MS 10000
+
+struct telemetry_route {
+    uint8_t sysid;
+    uint8_t compid;
+    uint8_t chan;
+    int64_t seen_ms;
+};
+
+struct telemetry_router_stats {
+    uint32_t frames_forwarded;
+    uint32_t bytes_forwarded;
+    uint32_t frames_dropped;
+};
+
+// Only used by the receiver thread, the shell merely reads it
+static struct telemetry_route routes[CONFIG_APP_TELEMETRY_ROUTER_MAX_ROUTES];
+static uint8_t route_count;
+
+// Counted on the link frames are forwarded to, frames which could not be
+// routed at all on the link they were received on
+static struct telemetry_router_stats stats[TELEMETRY_LINK_COUNT];
+
+static void learn(uint8_t chan, uint8_t sysid, uint8_t compid, int64_t now) {
+    int oldest = 0;
+
+    for (int i = 0; i < route_count; i++) {
+        if (routes[i].sysid == sysid && routes[i].compid == compid) {
+            routes[i].chan = chan;
+            routes[i].seen_ms = now;
+            return;
+        }
+
+        if (routes[i].seen_ms < routes[oldest].seen_ms) {
+            oldest = i;
+        }
+    }
+
+    // The table is full, the system heard from the longest ago is replaced
+    const int index = route_count < ARRAY_SIZE(routes) ? route_count++ : oldest;
+
+    routes[index] = (struct telemetry_route){
+        .sysid = sysid,
+        .compid = compid,
+        .chan = chan,
+        .seen_ms = now,
+    };
+
+    LOG_INF("System %u component %u reachable on link %u", sysid, compid,
+            chan);
+}
+
+// Links on which a system was heard from recently, as a bit mask
+static uint32_t find_links(uint8_t sysid, int64_t now) {
+    uint32_t mask = 0;
+
+    for (int i = 0; i < route_count; i++) {
+        if (routes[i].sysid == sysid &&
+            now - routes[i].seen_ms < ROUTE_TIMEOUT_MS) {
+            mask |= BIT(routes[i].chan);
+        }
+    }
+
+    return mask;
+}
+
+void telemetry_router_route(uint8_t chan, const mavlink_message_t *msg,
+                            const uint8_t *frame, uint16_t len) {
+    if (TELEMETRY_LINK_COUNT < 2) {
+        return;
+    }
+
+    const int64_t now = k_uptime_get();
+    const mavlink_msg_entry_t *entry = mavlink_get_msg_entry(msg->msgid);
+
+    // Without an entry the CRC was not checked, so neither is the sender
+    // learned, nor the target known
+    uint8_t target = 0;
+
+    if (entry != NULL) {
+        if (msg->sysid != 0 && msg->sysid != mavlink_system.sysid) {
+            learn(chan, msg->sysid, msg->compid, now);
+        }
+
+        if (entry->flags & MAV_MSG_ENTRY_FLAG_HAVE_TARGET_SYSTEM) {
+            target = _MAV_PAYLOAD(msg)[entry->target_system_ofs];
+        }
+    }
+
+    uint32_t mask;
+
+    if (target == 0) {
+        mask = BIT_MASK(TELEMETRY_LINK_COUNT);
+    } else if (target == mavlink_system.sysid) {
+        return;
+    } else {
+        mask = find_links(target, now);
+    }
+
+    // Never back to where it came from
+    mask &= ~BIT(chan);
+
+    for (uint8_t dst = 0; dst < TELEMETRY_LINK_COUNT; dst++) {
+        if (!(mask & BIT(dst)) || telemetry_link_rate(dst) == 0) {
+            continue;
+        }
+
+        if (telemetry_link_send_frame(dst, frame, len) < 0) {
+            stats[dst].frames_dropped++;
+            continue;
+        }
+
+        stats[dst].frames_forwarded++;
+        stats[dst].bytes_forwarded += len;
+    }
+}
+
+void telemetry_router_drop(uint8_t chan) {
+    if (chan >= TELEMETRY_LINK_COUNT) {
+        return;
+    }
+
+    stats[chan].frames_dropped++;
+}
+
+static int cmd_router_show(const struct shell *sh, size_t argc, char **argv) {
+    const int64_t now = k_uptime_get();
+
+    for (int i = 0; i < route_count; i++) {
+        shell_print(sh, "System %3u component %3u: link %u, seen %lld ms ago",
+                    routes[i].sysid, routes[i].compid, routes[i].chan,
+                    now - routes[i].seen_ms);
+    }
+
+    for (int i = 0; i < TELEMETRY_LINK_COUNT; i++) {
+        shell_print(sh, "Link %d: forwarded %u frames, %u bytes, dropped: %u",
+                    i, stats[i].frames_forwarded, stats[i].bytes_forwarded,
+                    stats[i].frames_dropped);
+    }
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    router_cmds,
+    SHELL_CMD(show, NULL, "Show routes and forwarding statistics",
+              cmd_router_show),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(router, &router_cmds, "MAVLink router", NULL);
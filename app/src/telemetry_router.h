@@ -0,0 +1,31 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct __mavlink_message;
+
+// Learns the systems reachable on a link from a frame received on it, and
+// forwards the frame as it is to the links its target is reachable on.
+// Broadcasts go to every other link.
+void telemetry_router_route(uint8_t chan, const struct __mavlink_message *msg,
+                            const uint8_t *frame, uint16_t len);
+
+// Counts a frame received on a link which could not be routed, because its
+// raw bytes were not kept
+void telemetry_router_drop(uint8_t chan);
@@ -20,31 +20,114 @@
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 
+#include "telemetry_link.h"
+#include "telemetry_receiver.h"
 #include "telemetry_sender.h"
 
 LOG_MODULE_REGISTER(telemetry_sender);
 
-extern struct k_pipe telemetry_ground_pipe;
+// Received data is handed to the receiver on every idle line and whenever a
+// buffer fills up, while the DMA goes on in the other buffer
+#define GROUND_RX_BUFFER_LEN 128
+
 static const struct device *const ground_telemetry_uart =
     DEVICE_DT_GET(DT_CHOSEN(telemetry_ground));
 
-void telemetry_sender(void *dummy1, void *dummy2, void *dummy3) {
+static uint8_t rx_buffers[2][GROUND_RX_BUFFER_LEN];
+static uint8_t next_rx_buffer;
+
+// Idle time after which received data is handed over
+static int32_t rx_timeout_us;
+
+// The region stays in the transmit ring until the DMA is done with it
+static int start_tx(const uint8_t *data, size_t len) {
+    return uart_tx(ground_telemetry_uart, data, len, SYS_FOREVER_US);
+}
+
+static int start_rx(void) {
+    next_rx_buffer = 1;
+
+    return uart_rx_enable(ground_telemetry_uart, rx_buffers[0],
+                          GROUND_RX_BUFFER_LEN, rx_timeout_us);
+}
+
+static void uart_callback(const struct device *dev, struct uart_event *evt,
+                          void *user_data) {
+    switch (evt->type) {
+    case UART_TX_DONE:
+    case UART_TX_ABORTED:
+        telemetry_link_tx_done(TELEMETRY_LINK_GROUND, evt->data.tx.len);
+        break;
+    case UART_RX_RDY:
+        telemetry_receiver_feed(TELEMETRY_LINK_GROUND,
+                                &evt->data.rx.buf[evt->data.rx.offset],
+                                evt->data.rx.len);
+        break;
+    case UART_RX_BUF_REQUEST:
+        uart_rx_buf_rsp(dev, rx_buffers[next_rx_buffer], GROUND_RX_BUFFER_LEN);
+        next_rx_buffer ^= 1;
+        break;
+    case UART_RX_STOPPED:
+        telemetry_receiver_error(TELEMETRY_LINK_GROUND);
+        break;
+    case UART_RX_DISABLED:
+        // Reception is disabled after errors, so it is restarted right away
+        if (start_rx() < 0) {
+            LOG_ERR("Could not restart ground telemetry reception!");
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+int telemetry_sender_init(void) {
     if (!device_is_ready(ground_telemetry_uart)) {
         LOG_ERR("Ground telemetry UART device not found, device operation will "
                 "proceed without telemetry!");
-        return;
+        return -ENODEV;
     }
 
-    while (true) {
-        uint8_t read_byte;
+    struct uart_config cfg;
+    int ret = uart_config_get(ground_telemetry_uart, &cfg);
+    if (ret < 0) {
+        LOG_ERR("Could not get the ground telemetry UART configuration!");
+        return ret;
+    }
 
-        int ret = k_pipe_read(&telemetry_ground_pipe, &read_byte,
-                              sizeof(read_byte), K_FOREVER);
+#if CONFIG_APP_TELEMETRY_BAUDRATE > 0 || CONFIG_APP_TELEMETRY_FLOW_CONTROL
+    if (CONFIG_APP_TELEMETRY_BAUDRATE > 0) {
+        cfg.baudrate = CONFIG_APP_TELEMETRY_BAUDRATE;
+    }
 
-        if (ret > 0) {
-            uart_poll_out(ground_telemetry_uart, read_byte);
-        } else {
-            LOG_ERR("Could not read from telemetry pipe!");
-        }
+    if (IS_ENABLED(CONFIG_APP_TELEMETRY_FLOW_CONTROL)) {
+        cfg.flow_ctrl = UART_CFG_FLOW_CTRL_RTS_CTS;
     }
+
+    ret = uart_configure(ground_telemetry_uart, &cfg);
+    if (ret < 0) {
+        LOG_ERR("Could not configure the ground telemetry UART!");
+        return ret;
+    }
+#endif
+
+    ret = uart_callback_set(ground_telemetry_uart, uart_callback, NULL);
+    if (ret < 0) {
+        LOG_ERR("Ground telemetry UART does not support the async API!");
+        return ret;
+    }
+
+    // Every byte takes a start and a stop bit on the wire, reception is
+    // handed over after three bytes of idle line
+    const uint32_t bytes_per_s = cfg.baudrate / 10;
+    rx_timeout_us = 3 * USEC_PER_SEC / bytes_per_s;
+
+    ret = start_rx();
+    if (ret < 0) {
+        LOG_ERR("Could not start ground telemetry reception!");
+        return ret;
+    }
+
+    return telemetry_link_register(TELEMETRY_LINK_GROUND, start_tx,
+                                   bytes_per_s);
 }
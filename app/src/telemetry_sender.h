@@ -15,4 +15,6 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
-void telemetry_sender(void *dummy1, void *dummy2, void *dummy3);
+// Drains the transmit ring of the ground link over the telemetry UART and
+// feeds the received data to the telemetry receiver
+int telemetry_sender_init(void);
@@ -0,0 +1,104 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "telemetry_link.h"
+#include "telemetry_receiver.h"
+#include "telemetry_usb.h"
+
+LOG_MODULE_REGISTER(telemetry_usb);
+
+// Bytes read from the CDC ACM FIFO at once
+#define USB_RX_CHUNK_LEN 64
+
+static const struct device *const usb_telemetry_uart =
+    DEVICE_DT_GET(DT_CHOSEN(telemetry_usb));
+
+// Region of the transmit ring being written into the CDC ACM FIFO, which
+// only takes a part of it at a time
+static const uint8_t *tx_data;
+static size_t tx_len;
+static size_t tx_offset;
+
+static int start_tx(const uint8_t *data, size_t len) {
+    tx_data = data;
+    tx_len = len;
+    tx_offset = 0;
+
+    uart_irq_tx_enable(usb_telemetry_uart);
+
+    return 0;
+}
+
+static void uart_isr(const struct device *dev, void *user_data) {
+    while (uart_irq_update(dev) && uart_irq_is_pending(dev)) {
+        if (uart_irq_rx_ready(dev)) {
+            uint8_t buf[USB_RX_CHUNK_LEN];
+
+            const int len = uart_fifo_read(dev, buf, sizeof(buf));
+            if (len > 0) {
+                telemetry_receiver_feed(TELEMETRY_LINK_USB, buf, len);
+            }
+        }
+
+        if (uart_irq_tx_ready(dev)) {
+            if (tx_offset < tx_len) {
+                const int len = uart_fifo_fill(dev, &tx_data[tx_offset],
+                                               tx_len - tx_offset);
+                if (len > 0) {
+                    tx_offset += len;
+                }
+            }
+
+            if (tx_offset == tx_len) {
+                const size_t sent = tx_len;
+
+                uart_irq_tx_disable(dev);
+                tx_len = 0;
+                tx_offset = 0;
+
+                // Starts the next region, which enables the interrupt again
+                if (sent > 0) {
+                    telemetry_link_tx_done(TELEMETRY_LINK_USB, sent);
+                }
+            }
+        }
+    }
+}
+
+int telemetry_usb_init(void) {
+    if (!device_is_ready(usb_telemetry_uart)) {
+        LOG_ERR("USB telemetry port not found!");
+        return -ENODEV;
+    }
+
+    int ret = uart_irq_callback_user_data_set(usb_telemetry_uart, uart_isr,
+                                              NULL);
+    if (ret < 0) {
+        LOG_ERR("USB telemetry port does not support interrupts!");
+        return ret;
+    }
+
+    uart_irq_rx_enable(usb_telemetry_uart);
+
+    return telemetry_link_register(TELEMETRY_LINK_USB, start_tx,
+                                   CONFIG_APP_TELEMETRY_USB_RATE);
+}
@@ -15,10 +15,14 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 
 struct imu_6dof_data {
     uint64_t timestamp_us;
+    uint32_t origin_cycles; // Cycle counter at data ready, for latency tracing
+    // Cycle counter when the filtered sample is published
+    uint32_t publish_cycles;
     float temperature_degc;
     float accel_mps2[3];
     float gyro_radps[3];
@@ -29,3 +33,99 @@ struct baro_data {
     float temperature_degc;
     float pressure_kpa;
 };
+
+struct dyn_notch_data {
+    uint64_t timestamp_us;
+    float center_freq_hz[3][3];
+    uint32_t max_step_cycles;
+};
+
+struct attitude_data {
+    uint64_t timestamp_us;
+    float q[4]; // Rotation from body to earth frame [w, x, y, z]
+    float rate_radps[3];
+};
+
+struct vertical_state_data {
+    uint64_t timestamp_us;
+    float altitude_m;   // Above mean sea level
+    float velocity_mps; // Positive up
+    float altitude_variance_m2;
+};
+
+struct battery_data {
+    uint64_t timestamp_us;
+    float voltage_v;         // Terminal voltage, averaged
+    float current_a;         // NaN when not measured
+    float resting_voltage_v; // Voltage with the load sag removed
+    float remaining;         // State of charge, 0 to 1
+    float consumed_mah;      // Stays 0 while the current is not measured
+    uint8_t cell_count;
+};
+
+#define RC_CHANNEL_COUNT 16
+
+// Link statistics, all zero when the protocol does not report them
+struct rc_link {
+    uint8_t link_quality; // Uplink packets received [%]
+    int16_t rssi_dbm;     // Uplink signal strength
+    int8_t snr_db;        // Uplink signal to noise ratio
+};
+
+// Newest receiver frame, channels in SBUS units starting with channel 1
+struct rc_frame {
+    uint64_t timestamp_us; // Reception of the frame
+    uint16_t channels[RC_CHANNEL_COUNT];
+    struct rc_link link;
+    uint32_t frames_lost; // Frames missed since boot
+    bool frame_lost;      // Frames were missed right before this one
+    bool failsafe;        // No frame for CONFIG_APP_RC_FAILSAFE_MS
+};
+
+struct rc_data {
+    uint64_t timestamp_us;
+    float roll;     // Stick right positive, -1 to 1
+    float pitch;    // Stick forward positive, -1 to 1
+    float yaw;      // Stick right positive, -1 to 1
+    float throttle; // 0 to 1
+};
+
+#define MOTOR_COUNT 4
+
+struct motor_data {
+    uint64_t timestamp_us;
+    float output[MOTOR_COUNT]; // Command, 0 to 1
+    float rpm[MOTOR_COUNT];    // NaN when the ESCs do not report it
+};
+
+#define RATE_CONTROL_HIST_BINS 16
+
+struct rate_control_data {
+    uint64_t timestamp_us;
+    float setpoint_radps[3];
+    float torque[3]; // One is full authority
+    uint32_t iterations;
+    uint32_t deadline_misses;
+    uint32_t samples_missed;
+    uint32_t exec_time_max_us;
+    uint32_t exec_time_hist[RATE_CONTROL_HIST_BINS];
+    uint32_t period_hist[RATE_CONTROL_HIST_BINS];
+};
+
+enum latency_stage {
+    LATENCY_STAGE_READ = 0, // Sample read and decimated
+    LATENCY_STAGE_FILTER,   // Gyro notch filtered
+    LATENCY_STAGE_ATTITUDE, // Attitude estimated
+    LATENCY_STAGE_CONTROL,  // Motor outputs computed
+    LATENCY_STAGE_OUTPUT,   // Motor outputs written to the ESCs
+    LATENCY_STAGE_COUNT,
+};
+
+// Time from the IMU data ready interrupt to the end of every stage
+struct latency_data {
+    uint64_t timestamp_us;
+    uint32_t count[LATENCY_STAGE_COUNT];
+    uint32_t p50_us[LATENCY_STAGE_COUNT];
+    uint32_t p99_us[LATENCY_STAGE_COUNT];
+    uint32_t max_us[LATENCY_STAGE_COUNT];
+};
@@ -0,0 +1,135 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+
+#include "altitude.h"
+
+#include "types.h"
+#include "vertical_estimator.h"
+
+LOG_MODULE_REGISTER(vertical_estimator);
+
+ZBUS_OBS_DECLARE(logger_sub);
+
+ZBUS_CHAN_DECLARE(imu_filtered_chan);
+ZBUS_CHAN_DECLARE(attitude_chan);
+ZBUS_CHAN_DECLARE(baro_chan);
+
+ZBUS_CHAN_DEFINE(vertical_state_chan, struct vertical_state_data, NULL, NULL,
+                 ZBUS_OBSERVERS(logger_sub), {0});
+
+ZBUS_SUBSCRIBER_DEFINE_WITH_ENABLE(vertical_estimator_sub, 16, false);
+
+// Samples further apart than this are treated as a gap in the IMU stream
+#define MAX_SAMPLE_INTERVAL_US (5 * 1000000 / CONFIG_APP_IMU_RATE_HZ)
+
+static ALTITUDE_Inst_Type altitude;
+
+static void handle_baro(const struct zbus_channel *chan) {
+    struct baro_data baro;
+    int ret = zbus_chan_read(chan, &baro, K_USEC(1));
+    if (ret < 0) {
+        LOG_ERR("Failed to read from vertical estimator subscriber!");
+        return;
+    }
+
+    ALTITUDE_Correct(&altitude, ALTITUDE_FromPressure(baro.pressure_kpa));
+}
+
+static void handle_imu(const struct zbus_channel *chan,
+                       uint64_t *prev_timestamp_us) {
+    struct imu_6dof_data imu;
+    int ret = zbus_chan_read(chan, &imu, K_USEC(1));
+    if (ret < 0) {
+        LOG_ERR("Failed to read from vertical estimator subscriber!");
+        return;
+    }
+
+    // The attitude estimator runs at a higher priority on the same samples, so
+    // the latest attitude matches this sample or lags it by one
+    struct attitude_data attitude;
+    ret = zbus_chan_read(&attitude_chan, &attitude, K_USEC(1));
+    if (ret < 0 || attitude.timestamp_us == 0) {
+        return;
+    }
+
+    uint64_t dt_us = imu.timestamp_us - *prev_timestamp_us;
+    if (*prev_timestamp_us == 0 || dt_us > MAX_SAMPLE_INTERVAL_US) {
+        dt_us = 1000000 / CONFIG_APP_IMU_RATE_HZ;
+    }
+    *prev_timestamp_us = imu.timestamp_us;
+
+    const float accel_up_mps2 =
+        ALTITUDE_VerticalAccel(attitude.q, imu.accel_mps2);
+
+    if (ALTITUDE_Predict(&altitude, accel_up_mps2, dt_us * 1e-6f) !=
+        ALTITUDE_SUCCESS) {
+        return; // No barometer measurement yet
+    }
+
+    const struct vertical_state_data msg = {
+        .timestamp_us = imu.timestamp_us,
+        .altitude_m = altitude.altitude_m,
+        .velocity_mps = altitude.velocity_mps,
+        .altitude_variance_m2 = altitude.covariance[0][0],
+    };
+
+    ret = zbus_chan_pub(&vertical_state_chan, &msg, K_NO_WAIT);
+    if (ret < 0 && ret != -EAGAIN && ret != -EBUSY) {
+        LOG_ERR("Failed to send vertical state message on zbus!");
+    }
+}
+
+void vertical_estimator(void *dummy1, void *dummy2, void *dummy3) {
+    ARG_UNUSED(dummy1);
+    ARG_UNUSED(dummy2);
+    ARG_UNUSED(dummy3);
+
+    const ALTITUDE_Config_Type altitude_cfg = {
+        .accel_noise_mps2 = CONFIG_APP_ALTITUDE_ACCEL_NOISE / 1000.0f,
+        .accel_bias_noise_mps3 = CONFIG_APP_ALTITUDE_ACCEL_BIAS_NOISE / 1000.0f,
+        .baro_noise_m = CONFIG_APP_ALTITUDE_BARO_NOISE / 1000.0f,
+    };
+
+    if (ALTITUDE_Init(&altitude, &altitude_cfg) != ALTITUDE_SUCCESS) {
+        LOG_ERR("Could not initialize the vertical estimator!");
+        return;
+    }
+
+    uint64_t prev_timestamp_us = 0;
+
+    zbus_obs_set_enable(&vertical_estimator_sub, true);
+
+    while (true) {
+        const struct zbus_channel *chan;
+        int ret = zbus_sub_wait(&vertical_estimator_sub, &chan, K_FOREVER);
+        if (ret < 0) {
+            LOG_ERR("Could not wait on the vertical estimator subscriber, "
+                    "aborting.");
+            return;
+        }
+
+        if (chan == &imu_filtered_chan) {
+            handle_imu(chan, &prev_timestamp_us);
+        } else if (chan == &baro_chan) {
+            handle_baro(chan);
+        }
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/usb/usb_device.h>
+
+#include "ahrs.h"
+
+#define BENCH_ITERATIONS 100000
+#define BENCH_SAMPLE_COUNT 256
+#define BENCH_SAMPLE_RATE_HZ 2000
+
+// Inputs are generated up front so only the estimator update is measured
+static float gyro_radps[BENCH_SAMPLE_COUNT][3];
+static float accel_mps2[BENCH_SAMPLE_COUNT][3];
+
+static AHRS_Inst_Type ahrs;
+
+static void generate_samples(void) {
+    for (int i = 0; i < BENCH_SAMPLE_COUNT; i++) {
+        const float phase = 2.0f * 3.14159265f * i / BENCH_SAMPLE_COUNT;
+
+        gyro_radps[i][0] = 0.5f * sinf(phase);
+        gyro_radps[i][1] = 0.3f * cosf(phase);
+        gyro_radps[i][2] = 0.1f;
+
+        accel_mps2[i][0] = 0.4f * sinf(3.0f * phase);
+        accel_mps2[i][1] = 0.4f * cosf(5.0f * phase);
+        accel_mps2[i][2] = 9.81f;
+    }
+}
+
+int main(void) {
+#if defined(CONFIG_USB_DEVICE_STACK)
+    if (DT_NODE_HAS_COMPAT(DT_CHOSEN(zephyr_console), zephyr_cdc_acm_uart)) {
+        if (usb_enable(NULL)) {
+            return 0;
+        }
+
+        // Give the host time to open the console before results are printed
+        k_msleep(3000);
+    }
+#endif
+
+    generate_samples();
+
+    const AHRS_Config_Type cfg = {
+        .kp = 0.5f,
+        .ki = 0.01f,
+    };
+
+    if (AHRS_Init(&ahrs, &cfg) != AHRS_SUCCESS) {
+        printk("Could not initialize the attitude estimator!\n");
+        return 0;
+    }
+
+    const float dt_s = 1.0f / BENCH_SAMPLE_RATE_HZ;
+    uint64_t total_cycles = 0;
+    uint32_t max_cycles = 0;
+
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        const int idx = i % BENCH_SAMPLE_COUNT;
+
+        const uint32_t start_cycles = k_cycle_get_32();
+        AHRS_Update(&ahrs, gyro_radps[idx], accel_mps2[idx], dt_s);
+        const uint32_t cycles = k_cycle_get_32() - start_cycles;
+
+        total_cycles += cycles;
+        if (cycles > max_cycles) {
+            max_cycles = cycles;
+        }
+    }
+
+    const uint32_t avg_cycles = total_cycles / BENCH_ITERATIONS;
+    const uint32_t cycles_per_sample =
+        sys_clock_hw_cycles_per_sec() / BENCH_SAMPLE_RATE_HZ;
+
+    printk("AHRS update: avg %u cycles (%u ns), max %u cycles (%u ns)\n",
+           avg_cycles, (uint32_t)k_cyc_to_ns_floor64(avg_cycles), max_cycles,
+           (uint32_t)k_cyc_to_ns_floor64(max_cycles));
+    printk("CPU load at %d Hz: %u.%02u %%\n", BENCH_SAMPLE_RATE_HZ,
+           avg_cycles * 100 / cycles_per_sample,
+           (avg_cycles * 10000 / cycles_per_sample) % 100);
+    printk("Final attitude: [%d, %d, %d, %d] x 1e-4\n",
+           (int)(ahrs.q[0] * 10000), (int)(ahrs.q[1] * 10000),
+           (int)(ahrs.q[2] * 10000), (int)(ahrs.q[3] * 10000));
+
+    return 0;
+}
@@ -27,11 +27,23 @@
 
 #include "esc.h"
 
+#ifdef CONFIG_ESC_DSHOT
+#include <stm32_ll_dma.h>
+#endif
+
 LOG_MODULE_REGISTER(main);
 
 #define ESC_SPEED_CHANGE_MS 1000
 #define ESC_ARMED_INDICATOR_MS 100
 
+#ifdef CONFIG_ESC_DSHOT
+// DShot frames have to be repeated, otherwise the ESC disarms
+#define ESC_DSHOT_REFRESH_MS 1
+
+// GPDMA1 channel streaming the frames into TIM3 CH1
+#define ESC_DSHOT_DMA_CHANNEL 1
+#endif
+
 // This LED simply blinks at an interval, indicating visually that the firmware
 // is running If anything causes the whole firmware to abort, it will be
 // apparent without looking at log output or hooking up a debugger.
@@ -58,6 +70,30 @@ static int enable_usb_device_next(void) {
 }
 #endif /* defined(CONFIG_USB_DEVICE_STACK_NEXT) */
 
+// Analog protocols keep repeating the pulse on their own, DShot frames are
+// sent one by one
+static void set_speed_for(ESC_Inst_Type *esc, float speed,
+                          uint32_t duration_ms) {
+#ifdef CONFIG_ESC_DSHOT
+    for (uint32_t t = 0; t < duration_ms; t += ESC_DSHOT_REFRESH_MS) {
+        ESC_SetSpeed(esc, speed);
+        k_msleep(ESC_DSHOT_REFRESH_MS);
+    }
+
+#ifdef CONFIG_ESC_DSHOT_BIDIR
+    ESC_Dshot_Telemetry_Type telemetry;
+    if (ESC_GetTelemetry(esc, &telemetry) == ESC_SUCCESS) {
+        printk("RPM: %u, errors: %u, timeouts: %u, decode: %u cycles\n",
+               telemetry.rpm, telemetry.errors, telemetry.timeouts,
+               telemetry.decode_cycles_max);
+    }
+#endif
+#else
+    ESC_SetSpeed(esc, speed);
+    k_msleep(duration_ms);
+#endif
+}
+
 int main(void) {
     if (DT_NODE_HAS_COMPAT(DT_CHOSEN(zephyr_console), zephyr_cdc_acm_uart)) {
 #if defined(CONFIG_USB_DEVICE_STACK_NEXT)
@@ -95,14 +131,32 @@ int main(void) {
     protocol = ESC_ONESHOT_42;
 #elif CONFIG_ESC_MULTISHOT
     protocol = ESC_MULTISHOT;
+#elif CONFIG_ESC_DSHOT150
+    protocol = ESC_DSHOT150;
+#elif CONFIG_ESC_DSHOT300
+    protocol = ESC_DSHOT300;
+#elif CONFIG_ESC_DSHOT600
+    protocol = ESC_DSHOT600;
 #endif
 
     const struct device *pwm_dev = DEVICE_DT_GET(DT_NODELABEL(pwm3));
 
     if (!device_is_ready(pwm_dev))
-        return;
+        return 0;
 
+#ifdef CONFIG_ESC_DSHOT
+    const ESC_Dshot_Config_Type dshot_cfg = {
+        .timer_base = ESC_DSHOT_TIMER_BASE(DT_NODELABEL(pwm3)),
+        .dma_dev = DEVICE_DT_GET(DT_NODELABEL(gpdma1)),
+        .dma_channel = ESC_DSHOT_DMA_CHANNEL,
+        .dma_slot = LL_GPDMA1_REQUEST_TIM3_CH1,
+        .bidirectional = IS_ENABLED(CONFIG_ESC_DSHOT_BIDIR),
+    };
+
+    status = ESC_InitDshot(&esc1, pwm_dev, 1, protocol, &dshot_cfg);
+#else
     status = ESC_Init(&esc1, pwm_dev, 1, protocol);
+#endif
     if (status != ESC_SUCCESS)
         return 0;
 
@@ -114,6 +168,9 @@ int main(void) {
         return 0;
     } else {
         printk("ESC Armed.\n");
+#ifdef CONFIG_ESC_DSHOT
+        ESC_SendCommand(&esc1, ESC_DSHOT_CMD_BEEP1);
+#endif
         for (int i = 0; i < 10; i++) {
             gpio_pin_toggle_dt(&fw_running_led);
             k_msleep(ESC_ARMED_INDICATOR_MS);
@@ -124,13 +181,11 @@ int main(void) {
 
         for (float i = 0.0f; i < 1.0f; i += 0.1f) {
             gpio_pin_toggle_dt(&fw_running_led);
-            ESC_SetSpeed(&esc1, i);
-            k_msleep(ESC_SPEED_CHANGE_MS);
+            set_speed_for(&esc1, i, ESC_SPEED_CHANGE_MS);
         }
         for (float i = 1.0f; i > 0.0f; i -= 0.1f) {
             gpio_pin_toggle_dt(&fw_running_led);
-            ESC_SetSpeed(&esc1, i);
-            k_msleep(ESC_SPEED_CHANGE_MS);
+            set_speed_for(&esc1, i, ESC_SPEED_CHANGE_MS);
         }
     }
 
@@ -0,0 +1,233 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/emul_sensor.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+
+#include "attitude_estimator.h"
+#include "imu_filter.h"
+#include "latency.h"
+#include "rate_controller.h"
+#include "types.h"
+
+LOG_MODULE_REGISTER(main);
+
+#define IMU_NODE DT_NODELABEL(imu_icm42688p)
+
+// Emulated motion, a roll oscillation on top of gravity
+#define SIM_ROLL_RATE_AMPLITUDE_RADPS 1.0f
+#define SIM_ROLL_RATE_FREQ_HZ 2.0f
+#define SIM_GRAVITY_MPS2 9.80665f
+
+// Emulated channels are set in Q31 with this many integer bits
+#define SIM_Q31_SHIFT 6
+
+#define SIM_PI 3.14159265f
+
+ZBUS_OBS_DECLARE(imu_filter_sub);
+ZBUS_OBS_DECLARE(logger_sub);
+
+ZBUS_CHAN_DEFINE(imu_chan, struct imu_6dof_data, NULL, NULL,
+                 ZBUS_OBSERVERS(imu_filter_sub), {0});
+
+ZBUS_CHAN_DECLARE(latency_chan);
+
+// Stands in for the logger of the application, only latency reports are
+// printed
+ZBUS_SUBSCRIBER_DEFINE_WITH_ENABLE(logger_sub, 16, false);
+
+// The vertical estimator needs the barometer, which is not emulated
+static void vertical_estimator_listener(const struct zbus_channel *chan) {
+    ARG_UNUSED(chan);
+}
+
+ZBUS_LISTENER_DEFINE(vertical_estimator_sub, vertical_estimator_listener);
+
+static const struct device *const imu = DEVICE_DT_GET(IMU_NODE);
+static const struct emul *const imu_emul = EMUL_DT_GET(IMU_NODE);
+static const struct gpio_dt_spec imu_drdy =
+    GPIO_DT_SPEC_GET(IMU_NODE, int_gpios);
+
+K_TIMER_DEFINE(sample_timer, NULL, NULL);
+
+K_THREAD_STACK_DEFINE(imu_filter_thread_stack, 2048);
+static struct k_thread imu_filter_thread;
+
+K_THREAD_STACK_DEFINE(attitude_estimator_thread_stack, 1024);
+static struct k_thread attitude_estimator_thread;
+
+K_THREAD_STACK_DEFINE(rate_controller_thread_stack, 2048);
+static struct k_thread rate_controller_thread;
+
+K_THREAD_STACK_DEFINE(logger_thread_stack, 1024);
+static struct k_thread logger_thread;
+
+// Same as the data ready handler of the application, without decimation
+static void handle_imu_drdy(const struct device *dev,
+                            const struct sensor_trigger *trig) {
+    const uint32_t origin_cycles = latency_sample_origin();
+
+    int ret = sensor_sample_fetch(dev);
+    if (ret < 0) {
+        LOG_ERR("Could not fetch data from IMU!");
+        return;
+    }
+
+    struct sensor_value accel[3];
+    struct sensor_value gyro[3];
+    if (sensor_channel_get(dev, SENSOR_CHAN_ACCEL_XYZ, accel) < 0 ||
+        sensor_channel_get(dev, SENSOR_CHAN_GYRO_XYZ, gyro) < 0) {
+        LOG_ERR("Could not get IMU data!");
+        return;
+    }
+
+    struct imu_6dof_data msg = {
+        .timestamp_us = k_ticks_to_us_floor64(k_uptime_ticks()),
+        .origin_cycles = origin_cycles,
+    };
+
+    for (int i = 0; i < 3; i++) {
+        msg.accel_mps2[i] = sensor_value_to_float(&accel[i]);
+        msg.gyro_radps[i] = sensor_value_to_float(&gyro[i]);
+    }
+
+    ret = zbus_chan_pub(&imu_chan, &msg, K_NO_WAIT);
+    if (ret < 0 && ret != -EAGAIN && ret != -EBUSY) {
+        LOG_ERR("Failed to send imu message on zbus!");
+    }
+
+    latency_record(LATENCY_STAGE_READ, origin_cycles);
+}
+
+static int set_emul_channel(enum sensor_channel chan, float value) {
+    const struct sensor_chan_spec spec = {.chan_type = chan, .chan_idx = 0};
+    const q31_t q = (q31_t)(value * (float)(1 << (31 - SIM_Q31_SHIFT)));
+
+    return emul_sensor_backend_set_channel(imu_emul, spec, &q, SIM_Q31_SHIFT);
+}
+
+static void logger(void *dummy1, void *dummy2, void *dummy3) {
+    ARG_UNUSED(dummy1);
+    ARG_UNUSED(dummy2);
+    ARG_UNUSED(dummy3);
+
+    static const char *const stage_names[LATENCY_STAGE_COUNT] = {
+        "read", "filter", "attitude", "control", "output",
+    };
+
+    zbus_obs_set_enable(&logger_sub, true);
+
+    while (true) {
+        const struct zbus_channel *chan;
+        int ret = zbus_sub_wait(&logger_sub, &chan, K_FOREVER);
+        if (ret < 0) {
+            LOG_ERR("Could not wait on the logger subscriber, aborting.");
+            return;
+        }
+
+        if (chan != &latency_chan) {
+            continue;
+        }
+
+        struct latency_data msg;
+        ret = zbus_chan_read(chan, &msg, K_MSEC(1));
+        if (ret < 0) {
+            continue;
+        }
+
+        for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+            LOG_INF("%-8s %8u samples, p50 %4u us, p99 %4u us, max %4u us",
+                    stage_names[stage], msg.count[stage], msg.p50_us[stage],
+                    msg.p99_us[stage], msg.max_us[stage]);
+        }
+    }
+}
+
+int main(void) {
+    if (!device_is_ready(imu)) {
+        LOG_ERR("Emulated IMU is not ready!");
+        return 0;
+    }
+
+    int ret = latency_init();
+    if (ret < 0) {
+        LOG_ERR("Could not initialize latency tracing!");
+        return 0;
+    }
+
+    struct sensor_trigger drdy_trigger = {.type = SENSOR_TRIG_DATA_READY,
+                                          .chan = SENSOR_CHAN_ALL};
+
+    ret = sensor_trigger_set(imu, &drdy_trigger, handle_imu_drdy);
+    if (ret < 0) {
+        LOG_ERR("Could not configure IMU trigger.");
+        return 0;
+    }
+
+    // Level, so only gravity is seen by the accelerometer
+    if (set_emul_channel(SENSOR_CHAN_ACCEL_X, 0.0f) < 0 ||
+        set_emul_channel(SENSOR_CHAN_ACCEL_Y, 0.0f) < 0 ||
+        set_emul_channel(SENSOR_CHAN_ACCEL_Z, SIM_GRAVITY_MPS2) < 0) {
+        LOG_ERR("Could not set the emulated accelerometer!");
+        return 0;
+    }
+
+    // Same priorities as in the application
+    k_thread_create(&rate_controller_thread, rate_controller_thread_stack,
+                    K_THREAD_STACK_SIZEOF(rate_controller_thread_stack),
+                    rate_controller, NULL, NULL, NULL, -1, 0, K_NO_WAIT);
+
+    k_thread_create(&imu_filter_thread, imu_filter_thread_stack,
+                    K_THREAD_STACK_SIZEOF(imu_filter_thread_stack), imu_filter,
+                    NULL, NULL, NULL, 0, 0, K_NO_WAIT);
+
+    k_thread_create(&attitude_estimator_thread,
+                    attitude_estimator_thread_stack,
+                    K_THREAD_STACK_SIZEOF(attitude_estimator_thread_stack),
+                    attitude_estimator, NULL, NULL, NULL, 1, 0, K_NO_WAIT);
+
+    k_thread_create(&logger_thread, logger_thread_stack,
+                    K_THREAD_STACK_SIZEOF(logger_thread_stack), logger, NULL,
+                    NULL, NULL, K_LOWEST_APPLICATION_THREAD_PRIO, 0, K_NO_WAIT);
+
+    k_timer_start(&sample_timer, K_USEC(USEC_PER_SEC / CONFIG_APP_IMU_RATE_HZ),
+                  K_USEC(USEC_PER_SEC / CONFIG_APP_IMU_RATE_HZ));
+
+    for (uint32_t sample = 0;; sample++) {
+        k_timer_status_sync(&sample_timer);
+
+        const float t = (float)sample / CONFIG_APP_IMU_RATE_HZ;
+        set_emul_channel(SENSOR_CHAN_GYRO_X,
+                         SIM_ROLL_RATE_AMPLITUDE_RADPS *
+                             sinf(2.0f * SIM_PI * SIM_ROLL_RATE_FREQ_HZ * t));
+
+        // The rising edge reaches both the sensor driver and the latency
+        // tracer, as the real data ready interrupt does
+        gpio_emul_input_set(imu_drdy.port, imu_drdy.pin, 1);
+        gpio_emul_input_set(imu_drdy.port, imu_drdy.pin, 0);
+    }
+
+    return 0;
+}
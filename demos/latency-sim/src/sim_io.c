@@ -0,0 +1,65 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <zephyr/kernel.h>
+
+#include "motor_output.h"
+#include "radio_receiver.h"
+#include "types.h"
+
+// Throttle of the emulated sticks, above the arming threshold so the rate
+// controller runs its full path on every sample
+#define SIM_THROTTLE 0.5f
+
+// There are no ESCs under native_sim, so the output stage ends with the write
+// call instead of the timer update
+
+int motor_output_init(void) { return 0; }
+
+bool motor_output_is_armed(void) { return true; }
+
+int motor_output_write(const float *output) {
+    ARG_UNUSED(output);
+
+    return 0;
+}
+
+int motor_output_stop(void) { return 0; }
+
+void motor_output_get_rpm(float *rpm) {
+    for (int i = 0; i < MOTOR_COUNT; i++) {
+        rpm[i] = NAN;
+    }
+}
+
+// A fresh frame with centered sticks is always available
+
+int radio_receiver_read(struct rc_frame *frame) {
+    *frame = (struct rc_frame){
+        .timestamp_us = k_ticks_to_us_floor64(k_uptime_ticks()),
+    };
+
+    return 0;
+}
+
+void radio_receiver_sticks(const struct rc_frame *frame, struct rc_data *rc) {
+    *rc = (struct rc_data){
+        .timestamp_us = frame->timestamp_us,
+        .throttle = SIM_THROTTLE,
+    };
+}
@@ -0,0 +1,97 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mixer.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+MIXER_Error_Type MIXER_Init(MIXER_Inst_Type *mixer,
+                            const MIXER_Config_Type *cfg) {
+    if (mixer == NULL || cfg == NULL) {
+        return MIXER_INVALID_PARAM;
+    }
+
+    if (cfg->motor_count == 0 || cfg->motor_count > MIXER_MAX_MOTORS) {
+        return MIXER_INVALID_PARAM;
+    }
+
+    if (cfg->idle_output < 0.0f || cfg->idle_output >= 1.0f) {
+        return MIXER_INVALID_PARAM;
+    }
+
+    memset(mixer, 0, sizeof(*mixer));
+    mixer->cfg = *cfg;
+
+    for (int axis = 0; axis < MIXER_AXIS_COUNT; axis++) {
+        float max_factor = 0.0f;
+        for (int i = 0; i < cfg->motor_count; i++) {
+            max_factor = fmaxf(max_factor, fabsf(cfg->matrix[i][axis]));
+        }
+
+        if (max_factor == 0.0f) {
+            return MIXER_INVALID_PARAM;
+        }
+
+        for (int i = 0; i < cfg->motor_count; i++) {
+            mixer->coef[i][axis] = cfg->matrix[i][axis] / max_factor;
+        }
+    }
+
+    mixer->output_scale = 1.0f - cfg->idle_output;
+    mixer->initialized = true;
+
+    return MIXER_SUCCESS;
+}
+
+bool MIXER_Mix(const MIXER_Inst_Type *mixer,
+               const float torque[MIXER_AXIS_COUNT], float throttle,
+               float *output) {
+    const int motor_count = mixer->cfg.motor_count;
+
+    float min_mix = INFINITY;
+    float max_mix = -INFINITY;
+    for (int i = 0; i < motor_count; i++) {
+        output[i] = mixer->coef[i][MIXER_ROLL] * torque[MIXER_ROLL] +
+                    mixer->coef[i][MIXER_PITCH] * torque[MIXER_PITCH] +
+                    mixer->coef[i][MIXER_YAW] * torque[MIXER_YAW];
+        min_mix = fminf(min_mix, output[i]);
+        max_mix = fmaxf(max_mix, output[i]);
+    }
+
+    float scale = 1.0f;
+    bool saturated = false;
+    const float range = max_mix - min_mix;
+    if (range > 1.0f) {
+        scale = 1.0f / range;
+        min_mix *= scale;
+        max_mix *= scale;
+        saturated = true;
+    }
+
+    // The range fits now, so both bounds can always be met
+    throttle = fminf(fmaxf(throttle, 0.0f), 1.0f);
+    throttle = fminf(fmaxf(throttle, -min_mix), 1.0f - max_mix);
+
+    for (int i = 0; i < motor_count; i++) {
+        const float mix = throttle + output[i] * scale;
+        output[i] = mixer->cfg.idle_output + mixer->output_scale * mix;
+    }
+
+    return saturated;
+}
@@ -0,0 +1,109 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIXER_H
+#define MIXER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MIXER_MAX_MOTORS 8
+
+typedef enum {
+    MIXER_ROLL = 0,
+    MIXER_PITCH,
+    MIXER_YAW,
+    MIXER_AXIS_COUNT,
+} MIXER_Axis_Type;
+
+// Quadcopter X, motors ordered rear right, front right, rear left, front
+// left, with the front right and rear left propellers spinning
+// counterclockwise seen from above. Positive roll, pitch and yaw follow the
+// body frame (forward, right, down).
+#define MIXER_QUAD_X_MATRIX                                                    \
+    {                                                                          \
+        {-1.0f, -1.0f, -1.0f},                                                 \
+        {-1.0f, 1.0f, 1.0f},                                                   \
+        {1.0f, -1.0f, 1.0f},                                                   \
+        {1.0f, 1.0f, -1.0f},                                                   \
+    }
+
+typedef enum {
+    MIXER_SUCCESS = 0,
+    MIXER_INVALID_PARAM,
+} MIXER_Error_Type;
+
+typedef struct {
+    uint8_t motor_count;
+    // Contribution of roll, pitch and yaw torque to every motor
+    float matrix[MIXER_MAX_MOTORS][MIXER_AXIS_COUNT];
+    float idle_output; // Lowest output of a running motor, 0 to 1
+} MIXER_Config_Type;
+
+typedef struct {
+    MIXER_Config_Type cfg;
+
+    // Matrix with every axis scaled to a largest factor of one, so a torque
+    // of one is full authority whatever the frame geometry is
+    float coef[MIXER_MAX_MOTORS][MIXER_AXIS_COUNT];
+    float output_scale; // Maps 0 to 1 into idle_output to 1
+
+    bool initialized;
+} MIXER_Inst_Type;
+
+/**
+ * @brief Initializes the mixer and precomputes its coefficients
+ *
+ * @param mixer A pointer to the mixer instance
+ * @param cfg   Configuration struct pointer
+ *
+ * @retval MIXER_SUCCESS - Operation finished successfully
+ * @retval MIXER_INVALID_PARAM - Pointers are not set, the motor count or the
+ * idle output is out of range, or an axis has no motor acting on it
+ */
+MIXER_Error_Type MIXER_Init(MIXER_Inst_Type *mixer,
+                            const MIXER_Config_Type *cfg);
+
+/**
+ * @brief Maps torque and throttle demands to motor outputs
+ *
+ * When the torques need a larger output range than the motors have, all of
+ * them are scaled down together, keeping the direction of the correction.
+ * The throttle is then shifted so that every output fits, which keeps full
+ * authority at zero and full throttle.
+ *
+ * @param mixer    A pointer to the initialized mixer instance
+ * @param torque   Roll, pitch and yaw demands, one is full authority
+ * @param throttle Collective thrust demand, 0 to 1
+ * @param output   Motor outputs, idle_output to 1
+ *
+ * @return true if the torques had to be scaled down, in which case integral
+ * terms of the controllers feeding the mixer should be held
+ */
+bool MIXER_Mix(const MIXER_Inst_Type *mixer,
+               const float torque[MIXER_AXIS_COUNT], float throttle,
+               float *output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MIXER_H
@@ -0,0 +1,112 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pid.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define PID_PI 3.14159265f
+
+static float Clamp(float x, float limit);
+
+PID_Error_Type PID_Init(PID_Inst_Type *pid, const PID_Config_Type *cfg) {
+    if (pid == NULL || cfg == NULL) {
+        return PID_INVALID_PARAM;
+    }
+
+    if (cfg->kp < 0.0f || cfg->ki < 0.0f || cfg->kd < 0.0f ||
+        cfg->integral_limit < 0.0f || cfg->sample_rate_hz <= 0.0f) {
+        return PID_INVALID_PARAM;
+    }
+
+    if (cfg->d_cutoff_hz < 0.0f ||
+        cfg->d_cutoff_hz >= cfg->sample_rate_hz / 2.0f) {
+        return PID_INVALID_PARAM;
+    }
+
+    memset(pid, 0, sizeof(*pid));
+    pid->cfg = *cfg;
+    pid->dt_s = 1.0f / cfg->sample_rate_hz;
+
+    // First order low-pass, computed once so the update has no division
+    if (cfg->d_cutoff_hz > 0.0f) {
+        const float rc_s = 1.0f / (2.0f * PID_PI * cfg->d_cutoff_hz);
+        pid->d_alpha = pid->dt_s / (rc_s + pid->dt_s);
+    } else {
+        pid->d_alpha = 1.0f;
+    }
+
+    pid->initialized = true;
+
+    return PID_SUCCESS;
+}
+
+PID_Error_Type PID_SetGains(PID_Inst_Type *pid, const float kp,
+                            const float ki, const float kd,
+                            const float integral_limit) {
+    if (kp < 0.0f || ki < 0.0f || kd < 0.0f || integral_limit < 0.0f) {
+        return PID_INVALID_PARAM;
+    }
+
+    pid->cfg.kp = kp;
+    pid->cfg.ki = ki;
+    pid->cfg.kd = kd;
+    pid->cfg.integral_limit = integral_limit;
+    pid->integral = Clamp(pid->integral, integral_limit);
+
+    return PID_SUCCESS;
+}
+
+float PID_Update(PID_Inst_Type *pid, const float setpoint,
+                 const float measurement, const bool integrate) {
+    const float error = setpoint - measurement;
+
+    if (integrate) {
+        pid->integral = Clamp(pid->integral + pid->cfg.ki * error * pid->dt_s,
+                              pid->cfg.integral_limit);
+    }
+
+    float d_raw = 0.0f;
+    if (pid->primed) {
+        d_raw = (pid->prev_measurement - measurement) * pid->cfg.sample_rate_hz;
+    }
+    pid->prev_measurement = measurement;
+    pid->primed = true;
+
+    pid->d_filtered += pid->d_alpha * (d_raw - pid->d_filtered);
+
+    return pid->cfg.kp * error + pid->integral + pid->cfg.kd * pid->d_filtered;
+}
+
+void PID_Reset(PID_Inst_Type *pid) {
+    pid->integral = 0.0f;
+    pid->d_filtered = 0.0f;
+    pid->primed = false;
+}
+
+static float Clamp(const float x, const float limit) {
+    if (x > limit) {
+        return limit;
+    }
+
+    if (x < -limit) {
+        return -limit;
+    }
+
+    return x;
+}
@@ -0,0 +1,112 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PID_H
+#define PID_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+typedef enum {
+    PID_SUCCESS = 0,
+    PID_INVALID_PARAM,
+} PID_Error_Type;
+
+typedef struct {
+    float kp;
+    float ki;
+    float kd;
+    float integral_limit; // Bound of the integral contribution to the output
+    float d_cutoff_hz;    // Derivative low-pass cutoff, zero disables it
+    float sample_rate_hz;
+} PID_Config_Type;
+
+typedef struct {
+    PID_Config_Type cfg;
+
+    float dt_s;
+    float d_alpha; // Derivative low-pass smoothing factor
+    float integral;
+    float d_filtered;
+    float prev_measurement;
+
+    bool primed; // The previous measurement is valid
+    bool initialized;
+} PID_Inst_Type;
+
+/**
+ * @brief Initializes a PID controller running at a fixed rate
+ *
+ * @param pid A pointer to the controller instance
+ * @param cfg Configuration struct pointer
+ *
+ * @retval PID_SUCCESS - Operation finished successfully
+ * @retval PID_INVALID_PARAM - Pointers are not set, gains or limits are
+ * negative, or the cutoff is not below the Nyquist frequency
+ */
+PID_Error_Type PID_Init(PID_Inst_Type *pid, const PID_Config_Type *cfg);
+
+/**
+ * @brief Changes the gains and the integral limit of a running controller
+ *
+ * The integral is kept, only clamped to the new limit, so the output does not
+ * jump when tuning in flight.
+ *
+ * @param pid            A pointer to the initialized controller instance
+ * @param kp             Proportional gain
+ * @param ki             Integral gain
+ * @param kd             Derivative gain
+ * @param integral_limit Bound of the integral contribution to the output
+ *
+ * @retval PID_SUCCESS - Operation finished successfully
+ * @retval PID_INVALID_PARAM - Gains or the limit are negative
+ */
+PID_Error_Type PID_SetGains(PID_Inst_Type *pid, float kp, float ki, float kd,
+                            float integral_limit);
+
+/**
+ * @brief Runs the controller for one sample
+ *
+ * The derivative acts on the measurement only, so setpoint steps do not kick
+ * the output. Integration can be held while the actuators are saturated,
+ * which prevents the integral from winding up.
+ *
+ * @param pid         A pointer to the initialized controller instance
+ * @param setpoint    Desired value of the controlled variable
+ * @param measurement Measured value of the controlled variable
+ * @param integrate   Accumulate the error into the integral
+ *
+ * @return Controller output
+ */
+float PID_Update(PID_Inst_Type *pid, float setpoint, float measurement,
+                 bool integrate);
+
+/**
+ * @brief Clears the integral and the derivative history
+ *
+ * @param pid A pointer to the initialized controller instance
+ */
+void PID_Reset(PID_Inst_Type *pid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PID_H
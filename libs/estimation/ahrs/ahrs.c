@@ -0,0 +1,171 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ahrs.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define AHRS_GRAVITY_MPS2 9.80665f
+
+// Accelerometer samples are only trusted within this band around 1 g
+#define AHRS_ACCEL_MIN_MPS2 (0.5f * AHRS_GRAVITY_MPS2)
+#define AHRS_ACCEL_MAX_MPS2 (1.5f * AHRS_GRAVITY_MPS2)
+
+static void AlignToGravity(AHRS_Inst_Type *ahrs, float ax, float ay, float az);
+
+AHRS_Error_Type AHRS_Init(AHRS_Inst_Type *ahrs, const AHRS_Config_Type *cfg) {
+    if (ahrs == NULL || cfg == NULL) {
+        return AHRS_INVALID_PARAM;
+    }
+
+    if (cfg->kp < 0.0f || cfg->ki < 0.0f) {
+        return AHRS_INVALID_PARAM;
+    }
+
+    memset(ahrs, 0, sizeof(*ahrs));
+    ahrs->cfg = *cfg;
+    ahrs->q[0] = 1.0f;
+    ahrs->initialized = true;
+
+    return AHRS_SUCCESS;
+}
+
+AHRS_Error_Type AHRS_Update(AHRS_Inst_Type *ahrs, const float gyro_radps[3],
+                            const float accel_mps2[3], const float dt_s) {
+    if (!ahrs->initialized) {
+        return AHRS_NOT_INITIALIZED;
+    }
+
+    float gx = gyro_radps[0];
+    float gy = gyro_radps[1];
+    float gz = gyro_radps[2];
+    float ax = accel_mps2[0];
+    float ay = accel_mps2[1];
+    float az = accel_mps2[2];
+
+    const float accel_norm_sq = ax * ax + ay * ay + az * az;
+    const bool accel_valid =
+        accel_norm_sq > AHRS_ACCEL_MIN_MPS2 * AHRS_ACCEL_MIN_MPS2 &&
+        accel_norm_sq < AHRS_ACCEL_MAX_MPS2 * AHRS_ACCEL_MAX_MPS2;
+
+    if (accel_valid) {
+        const float recip_norm = AHRS_InvSqrt(accel_norm_sq);
+        ax *= recip_norm;
+        ay *= recip_norm;
+        az *= recip_norm;
+
+        if (!ahrs->aligned) {
+            AlignToGravity(ahrs, ax, ay, az);
+            return AHRS_SUCCESS;
+        }
+    }
+
+    float q0 = ahrs->q[0];
+    float q1 = ahrs->q[1];
+    float q2 = ahrs->q[2];
+    float q3 = ahrs->q[3];
+
+    if (accel_valid) {
+        // Gravity direction in the body frame, as predicted by the attitude
+        const float vx = 2.0f * (q1 * q3 - q0 * q2);
+        const float vy = 2.0f * (q0 * q1 + q2 * q3);
+        const float vz = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+
+        // Rotation error between measured and predicted gravity
+        const float ex = ay * vz - az * vy;
+        const float ey = az * vx - ax * vz;
+        const float ez = ax * vy - ay * vx;
+
+        if (ahrs->cfg.ki > 0.0f) {
+            ahrs->gyro_bias_radps[0] += ahrs->cfg.ki * ex * dt_s;
+            ahrs->gyro_bias_radps[1] += ahrs->cfg.ki * ey * dt_s;
+            ahrs->gyro_bias_radps[2] += ahrs->cfg.ki * ez * dt_s;
+        }
+
+        gx += ahrs->cfg.kp * ex;
+        gy += ahrs->cfg.kp * ey;
+        gz += ahrs->cfg.kp * ez;
+    }
+
+    gx += ahrs->gyro_bias_radps[0];
+    gy += ahrs->gyro_bias_radps[1];
+    gz += ahrs->gyro_bias_radps[2];
+
+    // First order integration of q' = 0.5 * q * omega
+    const float half_dt_s = 0.5f * dt_s;
+    gx *= half_dt_s;
+    gy *= half_dt_s;
+    gz *= half_dt_s;
+
+    const float qa = q0;
+    const float qb = q1;
+    const float qc = q2;
+    q0 += -qb * gx - qc * gy - q3 * gz;
+    q1 += qa * gx + qc * gz - q3 * gy;
+    q2 += qa * gy - qb * gz + q3 * gx;
+    q3 += qa * gz + qb * gy - qc * gx;
+
+    const float recip_norm =
+        AHRS_InvSqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    ahrs->q[0] = q0 * recip_norm;
+    ahrs->q[1] = q1 * recip_norm;
+    ahrs->q[2] = q2 * recip_norm;
+    ahrs->q[3] = q3 * recip_norm;
+
+    return AHRS_SUCCESS;
+}
+
+float AHRS_InvSqrt(const float x) {
+    const float half_x = 0.5f * x;
+
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    bits = 0x5f375a86 - (bits >> 1);
+
+    float y;
+    memcpy(&y, &bits, sizeof(y));
+
+    // Two Newton-Raphson iterations
+    y = y * (1.5f - half_x * y * y);
+    y = y * (1.5f - half_x * y * y);
+
+    return y;
+}
+
+static void AlignToGravity(AHRS_Inst_Type *ahrs, const float ax,
+                           const float ay, const float az) {
+    // Shortest rotation taking the measured gravity direction onto the earth
+    // z axis, built from the dot and cross products so no trigonometry is
+    // needed
+    if (az < -0.9999f) {
+        ahrs->q[0] = 0.0f;
+        ahrs->q[1] = 1.0f;
+        ahrs->q[2] = 0.0f;
+        ahrs->q[3] = 0.0f;
+    } else {
+        const float w = 1.0f + az;
+        const float recip_norm = AHRS_InvSqrt(w * w + ay * ay + ax * ax);
+        ahrs->q[0] = w * recip_norm;
+        ahrs->q[1] = ay * recip_norm;
+        ahrs->q[2] = -ax * recip_norm;
+        ahrs->q[3] = 0.0f;
+    }
+
+    ahrs->aligned = true;
+}
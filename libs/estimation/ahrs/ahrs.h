@@ -0,0 +1,93 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AHRS_H
+#define AHRS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+typedef enum {
+    AHRS_SUCCESS = 0,
+    AHRS_INVALID_PARAM,
+    AHRS_NOT_INITIALIZED,
+} AHRS_Error_Type;
+
+typedef struct {
+    float kp; // Proportional gain of the accelerometer correction
+    float ki; // Integral gain, estimates the gyroscope bias
+} AHRS_Config_Type;
+
+typedef struct {
+    AHRS_Config_Type cfg;
+
+    // Rotation from the body frame to the earth frame, [w, x, y, z]
+    float q[4];
+    float gyro_bias_radps[3];
+
+    bool aligned;
+    bool initialized;
+} AHRS_Inst_Type;
+
+/**
+ * @brief Initializes the Mahony attitude estimator
+ *
+ * The attitude is aligned to gravity on the first update.
+ *
+ * @param ahrs A pointer to the estimator instance
+ * @param cfg  Configuration struct pointer
+ *
+ * @retval AHRS_SUCCESS - Operation finished successfully
+ * @retval AHRS_INVALID_PARAM - Pointers are not set or gains are negative
+ */
+AHRS_Error_Type AHRS_Init(AHRS_Inst_Type *ahrs, const AHRS_Config_Type *cfg);
+
+/**
+ * @brief Propagates the attitude by one IMU sample
+ *
+ * Uses only single-precision multiplications, additions and a fast inverse
+ * square root, so it can run for every IMU sample. Accelerometer samples
+ * which are far from 1 g are not used for correction.
+ *
+ * @param ahrs       A pointer to the estimator instance
+ * @param gyro_radps Angular velocity in the body frame [rad/s]
+ * @param accel_mps2 Specific force in the body frame [m/s2]
+ * @param dt_s       Time elapsed since the previous sample [s]
+ *
+ * @retval AHRS_SUCCESS - Operation finished successfully
+ * @retval AHRS_NOT_INITIALIZED - The estimator is not initialized
+ */
+AHRS_Error_Type AHRS_Update(AHRS_Inst_Type *ahrs, const float gyro_radps[3],
+                            const float accel_mps2[3], float dt_s);
+
+/**
+ * @brief Computes 1/sqrt(x) without a division or a square root
+ *
+ * @param x A positive number
+ *
+ * @return Approximation of 1/sqrt(x) with a relative error below 5e-6
+ */
+float AHRS_InvSqrt(float x);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AHRS_H
@@ -0,0 +1,193 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "altitude.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define ALTITUDE_GRAVITY_MPS2 9.80665f
+
+// Uncertainty of the velocity and bias states when the filter is aligned
+#define ALTITUDE_INITIAL_VELOCITY_VARIANCE 1.0f
+#define ALTITUDE_INITIAL_BIAS_VARIANCE 0.25f
+
+#define ALTITUDE_TABLE_MIN_KPA 30.0f
+#define ALTITUDE_TABLE_MAX_KPA 110.0f
+#define ALTITUDE_TABLE_STEP_KPA 1.0f
+
+// 44330 * (1 - (p / 101.325)^(1 / 5.255)) for p = 30, 31, ..., 110 kPa
+static const float altitude_table_m[] = {
+    9165.16f, 8945.05f, 8730.62f, 8521.55f, 8317.55f, 8118.35f, 7923.70f,
+    7733.39f, 7547.20f, 7364.93f, 7186.41f, 7011.46f, 6839.94f, 6671.69f,
+    6506.59f, 6344.49f, 6185.28f, 6028.85f, 5875.10f, 5723.91f, 5575.21f,
+    5428.89f, 5284.88f, 5143.09f, 5003.46f, 4865.90f, 4730.35f, 4596.75f,
+    4465.03f, 4335.14f, 4207.02f, 4080.62f, 3955.88f, 3832.76f, 3711.22f,
+    3591.20f, 3472.67f, 3355.58f, 3239.90f, 3125.59f, 3012.62f, 2900.94f,
+    2790.53f, 2681.35f, 2573.38f, 2466.58f, 2360.93f, 2256.40f, 2152.97f,
+    2050.60f, 1949.27f, 1848.97f, 1749.66f, 1651.33f, 1553.96f, 1457.51f,
+    1361.99f, 1267.35f, 1173.60f, 1080.70f, 988.65f,  897.42f,  806.99f,
+    717.36f,  628.51f,  540.42f,  453.07f,  366.46f,  280.57f,  195.39f,
+    110.90f,  27.09f,   -56.05f,  -138.53f, -220.36f, -301.56f, -382.14f,
+    -462.11f, -541.47f, -620.23f, -698.42f,
+};
+
+#define ALTITUDE_TABLE_SIZE                                                    \
+    (sizeof(altitude_table_m) / sizeof(altitude_table_m[0]))
+
+ALTITUDE_Error_Type ALTITUDE_Init(ALTITUDE_Inst_Type *inst,
+                                  const ALTITUDE_Config_Type *cfg) {
+    if (inst == NULL || cfg == NULL) {
+        return ALTITUDE_INVALID_PARAM;
+    }
+
+    if (cfg->accel_noise_mps2 <= 0.0f || cfg->accel_bias_noise_mps3 < 0.0f ||
+        cfg->baro_noise_m <= 0.0f) {
+        return ALTITUDE_INVALID_PARAM;
+    }
+
+    memset(inst, 0, sizeof(*inst));
+    inst->cfg = *cfg;
+    inst->baro_variance_m2 = cfg->baro_noise_m * cfg->baro_noise_m;
+    inst->initialized = true;
+
+    return ALTITUDE_SUCCESS;
+}
+
+ALTITUDE_Error_Type ALTITUDE_Predict(ALTITUDE_Inst_Type *inst,
+                                     const float accel_up_mps2,
+                                     const float dt_s) {
+    if (!inst->initialized || !inst->aligned) {
+        return ALTITUDE_NOT_INITIALIZED;
+    }
+
+    const float accel_mps2 = accel_up_mps2 - inst->accel_bias_mps2;
+    const float half_dt_sq = 0.5f * dt_s * dt_s;
+
+    inst->altitude_m += inst->velocity_mps * dt_s + accel_mps2 * half_dt_sq;
+    inst->velocity_mps += accel_mps2 * dt_s;
+
+    // P = F * P * F', with F = [1 dt -dt^2/2; 0 1 -dt; 0 0 1]. The structure
+    // of F is expanded by hand instead of doing two full matrix products.
+    float(*p)[ALTITUDE_STATE_COUNT] = inst->covariance;
+    float fp[ALTITUDE_STATE_COUNT][ALTITUDE_STATE_COUNT];
+
+    for (int j = 0; j < ALTITUDE_STATE_COUNT; j++) {
+        fp[0][j] = p[0][j] + dt_s * p[1][j] - half_dt_sq * p[2][j];
+        fp[1][j] = p[1][j] - dt_s * p[2][j];
+        fp[2][j] = p[2][j];
+    }
+
+    for (int i = 0; i < ALTITUDE_STATE_COUNT; i++) {
+        p[i][0] = fp[i][0] + dt_s * fp[i][1] - half_dt_sq * fp[i][2];
+        p[i][1] = fp[i][1] - dt_s * fp[i][2];
+        p[i][2] = fp[i][2];
+    }
+
+    // Acceleration noise enters through G = [dt^2/2, dt, 0], the bias is a
+    // random walk
+    const float accel_var =
+        inst->cfg.accel_noise_mps2 * inst->cfg.accel_noise_mps2;
+    const float bias_var =
+        inst->cfg.accel_bias_noise_mps3 * inst->cfg.accel_bias_noise_mps3;
+
+    p[0][0] += accel_var * half_dt_sq * half_dt_sq;
+    p[0][1] += accel_var * half_dt_sq * dt_s;
+    p[1][0] += accel_var * half_dt_sq * dt_s;
+    p[1][1] += accel_var * dt_s * dt_s;
+    p[2][2] += bias_var * dt_s;
+
+    return ALTITUDE_SUCCESS;
+}
+
+ALTITUDE_Error_Type ALTITUDE_Correct(ALTITUDE_Inst_Type *inst,
+                                     const float altitude_m) {
+    if (!inst->initialized) {
+        return ALTITUDE_NOT_INITIALIZED;
+    }
+
+    float(*p)[ALTITUDE_STATE_COUNT] = inst->covariance;
+
+    if (!inst->aligned) {
+        inst->altitude_m = altitude_m;
+        inst->velocity_mps = 0.0f;
+        inst->accel_bias_mps2 = 0.0f;
+
+        memset(inst->covariance, 0, sizeof(inst->covariance));
+        p[0][0] = inst->baro_variance_m2;
+        p[1][1] = ALTITUDE_INITIAL_VELOCITY_VARIANCE;
+        p[2][2] = ALTITUDE_INITIAL_BIAS_VARIANCE;
+
+        inst->aligned = true;
+        return ALTITUDE_SUCCESS;
+    }
+
+    // With H = [1 0 0] the innovation covariance is a scalar, so the update
+    // needs a single division
+    const float innovation = altitude_m - inst->altitude_m;
+    const float recip_innovation_var =
+        1.0f / (p[0][0] + inst->baro_variance_m2);
+
+    const float gain[ALTITUDE_STATE_COUNT] = {
+        p[0][0] * recip_innovation_var,
+        p[1][0] * recip_innovation_var,
+        p[2][0] * recip_innovation_var,
+    };
+
+    inst->altitude_m += gain[0] * innovation;
+    inst->velocity_mps += gain[1] * innovation;
+    inst->accel_bias_mps2 += gain[2] * innovation;
+
+    // P = (I - K * H) * P, only the first row of P is needed for K * H * P
+    const float p_row0[ALTITUDE_STATE_COUNT] = {p[0][0], p[0][1], p[0][2]};
+
+    for (int i = 0; i < ALTITUDE_STATE_COUNT; i++) {
+        for (int j = 0; j < ALTITUDE_STATE_COUNT; j++) {
+            p[i][j] -= gain[i] * p_row0[j];
+        }
+    }
+
+    return ALTITUDE_SUCCESS;
+}
+
+float ALTITUDE_FromPressure(const float pressure_kpa) {
+    if (!(pressure_kpa > ALTITUDE_TABLE_MIN_KPA)) {
+        return altitude_table_m[0];
+    }
+
+    if (pressure_kpa >= ALTITUDE_TABLE_MAX_KPA) {
+        return altitude_table_m[ALTITUDE_TABLE_SIZE - 1];
+    }
+
+    const float position =
+        (pressure_kpa - ALTITUDE_TABLE_MIN_KPA) / ALTITUDE_TABLE_STEP_KPA;
+    const int idx = (int)position;
+    const float frac = position - idx;
+
+    return altitude_table_m[idx] +
+           frac * (altitude_table_m[idx + 1] - altitude_table_m[idx]);
+}
+
+float ALTITUDE_VerticalAccel(const float q[4], const float accel_mps2[3]) {
+    // Last row of the body to earth rotation matrix
+    const float rx = 2.0f * (q[1] * q[3] - q[0] * q[2]);
+    const float ry = 2.0f * (q[0] * q[1] + q[2] * q[3]);
+    const float rz = q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3];
+
+    return rx * accel_mps2[0] + ry * accel_mps2[1] + rz * accel_mps2[2] -
+           ALTITUDE_GRAVITY_MPS2;
+}
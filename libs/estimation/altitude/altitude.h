@@ -0,0 +1,129 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ALTITUDE_H
+#define ALTITUDE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#define ALTITUDE_STATE_COUNT 3
+
+typedef enum {
+    ALTITUDE_SUCCESS = 0,
+    ALTITUDE_INVALID_PARAM,
+    ALTITUDE_NOT_INITIALIZED,
+} ALTITUDE_Error_Type;
+
+typedef struct {
+    float accel_noise_mps2;      // Standard deviation of vertical acceleration
+    float accel_bias_noise_mps3; // Random walk of the accelerometer bias
+    float baro_noise_m;          // Standard deviation of baro altitude
+} ALTITUDE_Config_Type;
+
+typedef struct {
+    ALTITUDE_Config_Type cfg;
+
+    // State vector is [altitude, vertical velocity, accelerometer bias], with
+    // the vertical axis pointing up
+    float altitude_m;
+    float velocity_mps;
+    float accel_bias_mps2;
+    float covariance[ALTITUDE_STATE_COUNT][ALTITUDE_STATE_COUNT];
+
+    float baro_variance_m2;
+
+    bool aligned;
+    bool initialized;
+} ALTITUDE_Inst_Type;
+
+/**
+ * @brief Initializes the vertical Kalman filter
+ *
+ * The state is aligned to the first barometer measurement, predictions before
+ * it are ignored.
+ *
+ * @param inst A pointer to the filter instance
+ * @param cfg  Configuration struct pointer
+ *
+ * @retval ALTITUDE_SUCCESS - Operation finished successfully
+ * @retval ALTITUDE_INVALID_PARAM - Pointers are not set or noise is not
+ * positive
+ */
+ALTITUDE_Error_Type ALTITUDE_Init(ALTITUDE_Inst_Type *inst,
+                                  const ALTITUDE_Config_Type *cfg);
+
+/**
+ * @brief Propagates the vertical state by one IMU sample
+ *
+ * @param inst          A pointer to the filter instance
+ * @param accel_up_mps2 Vertical acceleration in the earth frame, without
+ * gravity [m/s2]
+ * @param dt_s          Time elapsed since the previous sample [s]
+ *
+ * @retval ALTITUDE_SUCCESS - Operation finished successfully
+ * @retval ALTITUDE_NOT_INITIALIZED - The filter is not initialized or has not
+ * received a barometer measurement yet
+ */
+ALTITUDE_Error_Type ALTITUDE_Predict(ALTITUDE_Inst_Type *inst,
+                                     float accel_up_mps2, float dt_s);
+
+/**
+ * @brief Corrects the vertical state with a barometric altitude
+ *
+ * @param inst       A pointer to the filter instance
+ * @param altitude_m Altitude derived from the barometer [m]
+ *
+ * @retval ALTITUDE_SUCCESS - Operation finished successfully
+ * @retval ALTITUDE_NOT_INITIALIZED - The filter is not initialized
+ */
+ALTITUDE_Error_Type ALTITUDE_Correct(ALTITUDE_Inst_Type *inst,
+                                     float altitude_m);
+
+/**
+ * @brief Converts static pressure to altitude above mean sea level
+ *
+ * Interpolates a table of the international barometric formula, so no power
+ * function is evaluated at runtime. The table covers 30 kPa to 110 kPa with an
+ * interpolation error below 0.2 m under 3000 m of altitude, pressure outside
+ * of the table is clamped.
+ *
+ * @param pressure_kpa Static pressure [kPa]
+ *
+ * @return Altitude above mean sea level [m]
+ */
+float ALTITUDE_FromPressure(float pressure_kpa);
+
+/**
+ * @brief Projects a specific force measurement onto the earth vertical axis
+ *
+ * @param q          Rotation from the body frame to the earth frame,
+ * [w, x, y, z]
+ * @param accel_mps2 Specific force in the body frame [m/s2]
+ *
+ * @return Vertical acceleration with gravity removed, positive up [m/s2]
+ */
+float ALTITUDE_VerticalAccel(const float q[4], const float accel_mps2[3]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ALTITUDE_H
@@ -0,0 +1,113 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "battery.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+// Highest per cell voltage assumed when detecting the cell count, slightly
+// above a fully charged LiPo
+#define BATTERY_DETECT_CELL_MAX_V 4.35f
+
+static uint8_t DetectCellCount(float voltage_v);
+
+BATTERY_Error_Type BATTERY_Init(BATTERY_Inst_Type *battery,
+                                const BATTERY_Config_Type *cfg) {
+    if (battery == NULL || cfg == NULL) {
+        return BATTERY_INVALID_PARAM;
+    }
+
+    if (cfg->cell_count > BATTERY_MAX_CELL_COUNT ||
+        cfg->cell_empty_v <= 0.0f || cfg->cell_full_v <= cfg->cell_empty_v ||
+        cfg->internal_resistance_ohm < 0.0f ||
+        cfg->sag_recovery_tau_s <= 0.0f) {
+        return BATTERY_INVALID_PARAM;
+    }
+
+    memset(battery, 0, sizeof(*battery));
+    battery->cfg = *cfg;
+    battery->cell_count = cfg->cell_count;
+    battery->current_a = NAN;
+    battery->initialized = true;
+
+    return BATTERY_SUCCESS;
+}
+
+BATTERY_Error_Type BATTERY_Update(BATTERY_Inst_Type *battery,
+                                  const float voltage_v, const float current_a,
+                                  const float dt_s) {
+    if (!battery->initialized) {
+        return BATTERY_NOT_INITIALIZED;
+    }
+
+    battery->voltage_v = voltage_v;
+    battery->current_a = current_a;
+
+    if (!battery->has_sample) {
+        if (battery->cell_count == 0) {
+            battery->cell_count = DetectCellCount(voltage_v);
+        }
+
+        battery->resting_voltage_v = voltage_v;
+        battery->has_sample = true;
+    }
+
+    if (!isnan(current_a)) {
+        battery->consumed_mah += current_a * dt_s * (1000.0f / 3600.0f);
+        battery->resting_voltage_v =
+            voltage_v + current_a * battery->cfg.internal_resistance_ohm;
+    } else if (voltage_v > battery->resting_voltage_v) {
+        battery->resting_voltage_v = voltage_v;
+    } else {
+        float alpha = dt_s / battery->cfg.sag_recovery_tau_s;
+        if (alpha > 1.0f) {
+            alpha = 1.0f;
+        }
+
+        battery->resting_voltage_v +=
+            alpha * (voltage_v - battery->resting_voltage_v);
+    }
+
+    // Linear between the empty and full cell voltage, which is coarse but
+    // monotonic and good enough for warnings
+    const float cell_v = battery->resting_voltage_v / battery->cell_count;
+    float remaining = (cell_v - battery->cfg.cell_empty_v) /
+                      (battery->cfg.cell_full_v - battery->cfg.cell_empty_v);
+
+    if (remaining < 0.0f) {
+        remaining = 0.0f;
+    } else if (remaining > 1.0f) {
+        remaining = 1.0f;
+    }
+
+    battery->remaining = remaining;
+
+    return BATTERY_SUCCESS;
+}
+
+static uint8_t DetectCellCount(const float voltage_v) {
+    uint8_t cell_count = 1;
+
+    while (cell_count < BATTERY_MAX_CELL_COUNT &&
+           voltage_v > cell_count * BATTERY_DETECT_CELL_MAX_V) {
+        cell_count++;
+    }
+
+    return cell_count;
+}
@@ -0,0 +1,98 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BATTERY_H
+#define BATTERY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BATTERY_MAX_CELL_COUNT 12
+
+typedef enum {
+    BATTERY_SUCCESS = 0,
+    BATTERY_INVALID_PARAM,
+    BATTERY_NOT_INITIALIZED,
+} BATTERY_Error_Type;
+
+typedef struct {
+    uint8_t cell_count; // Zero detects the cell count from the first sample
+    float cell_full_v;
+    float cell_empty_v;
+    float internal_resistance_ohm;
+    // Time constant with which the resting voltage follows a sagging terminal
+    // voltage when the current is not measured
+    float sag_recovery_tau_s;
+} BATTERY_Config_Type;
+
+typedef struct {
+    BATTERY_Config_Type cfg;
+
+    uint8_t cell_count;
+    float voltage_v;         // Terminal voltage, under load
+    float current_a;         // NaN when the current is not measured
+    float resting_voltage_v; // Estimated voltage without load
+    float remaining;         // State of charge, 0 to 1
+    float consumed_mah;      // Integrated from the measured current
+
+    bool has_sample;
+    bool initialized;
+} BATTERY_Inst_Type;
+
+/**
+ * @brief Initializes the battery model
+ *
+ * @param battery A pointer to the battery instance
+ * @param cfg     Configuration struct pointer
+ *
+ * @retval BATTERY_SUCCESS - Operation finished successfully
+ * @retval BATTERY_INVALID_PARAM - Pointers are not set or the cell voltage
+ * range is invalid
+ */
+BATTERY_Error_Type BATTERY_Init(BATTERY_Inst_Type *battery,
+                                const BATTERY_Config_Type *cfg);
+
+/**
+ * @brief Updates the battery state with a new measurement
+ *
+ * The voltage sag under load is removed before estimating the state of
+ * charge. With a measured current the sag is modeled by the internal
+ * resistance. Without it, the resting voltage follows the terminal voltage
+ * up immediately and down with the configured time constant, so short load
+ * peaks are not mistaken for discharge. The consumed capacity is only
+ * integrated while the current is measured.
+ *
+ * @param battery   A pointer to the battery instance
+ * @param voltage_v Terminal voltage [V]
+ * @param current_a Discharge current [A], NaN if not measured
+ * @param dt_s      Time elapsed since the previous update [s]
+ *
+ * @retval BATTERY_SUCCESS - Operation finished successfully
+ * @retval BATTERY_NOT_INITIALIZED - The battery model is not initialized
+ */
+BATTERY_Error_Type BATTERY_Update(BATTERY_Inst_Type *battery, float voltage_v,
+                                  float current_a, float dt_s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BATTERY_H
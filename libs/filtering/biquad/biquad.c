@@ -0,0 +1,63 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "biquad.h"
+
+#include <math.h>
+#include <stddef.h>
+
+#define BIQUAD_PI 3.14159265358979f
+
+BIQUAD_Error_Type BIQUAD_InitNotch(BIQUAD_Inst_Type *filter,
+                                   const float center_freq_hz, const float q,
+                                   const float sample_rate_hz) {
+    if (filter == NULL) {
+        return BIQUAD_INVALID_PARAM;
+    }
+
+    BIQUAD_Reset(filter);
+
+    return BIQUAD_SetNotch(filter, center_freq_hz, q, sample_rate_hz);
+}
+
+BIQUAD_Error_Type BIQUAD_SetNotch(BIQUAD_Inst_Type *filter,
+                                  const float center_freq_hz, const float q,
+                                  const float sample_rate_hz) {
+    if (filter == NULL || q <= 0.0f || center_freq_hz <= 0.0f ||
+        center_freq_hz >= sample_rate_hz / 2.0f) {
+        return BIQUAD_INVALID_PARAM;
+    }
+
+    // RBJ audio EQ cookbook notch
+    const float omega = 2.0f * BIQUAD_PI * center_freq_hz / sample_rate_hz;
+    const float cos_omega = cosf(omega);
+    const float alpha = sinf(omega) / (2.0f * q);
+    const float a0_inv = 1.0f / (1.0f + alpha);
+
+    filter->b0 = a0_inv;
+    filter->b1 = -2.0f * cos_omega * a0_inv;
+    filter->b2 = a0_inv;
+    filter->a1 = filter->b1;
+    filter->a2 = (1.0f - alpha) * a0_inv;
+
+    return BIQUAD_SUCCESS;
+}
+
+void BIQUAD_Reset(BIQUAD_Inst_Type *filter) {
+    filter->s1 = 0.0f;
+    filter->s2 = 0.0f;
+}
@@ -0,0 +1,108 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BIQUAD_H
+#define BIQUAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+typedef enum {
+    BIQUAD_SUCCESS = 0,
+    BIQUAD_INVALID_PARAM,
+} BIQUAD_Error_Type;
+
+typedef struct {
+    // Coefficients, normalized by a0
+    float b0;
+    float b1;
+    float b2;
+    float a1;
+    float a2;
+
+    // Direct form II transposed state
+    float s1;
+    float s2;
+} BIQUAD_Inst_Type;
+
+/**
+ * @brief Initializes a notch (band-stop) filter and clears its state
+ *
+ * @param filter         A pointer to the filter instance
+ * @param center_freq_hz Notch center frequency in Hz
+ * @param q              Notch quality factor, higher is narrower
+ * @param sample_rate_hz Rate at which BIQUAD_Apply is called in Hz
+ *
+ * @retval BIQUAD_SUCCESS - Operation finished successfully
+ * @retval BIQUAD_INVALID_PARAM - Filter pointer is not set or the center
+ * frequency is not below the Nyquist frequency
+ */
+BIQUAD_Error_Type BIQUAD_InitNotch(BIQUAD_Inst_Type *filter,
+                                   float center_freq_hz, float q,
+                                   float sample_rate_hz);
+
+/**
+ * @brief Moves the notch to a new center frequency, keeping the filter state
+ *
+ * Keeping the state avoids output transients when the notch is retuned while
+ * the filter is running.
+ *
+ * @param filter         A pointer to the filter instance
+ * @param center_freq_hz Notch center frequency in Hz
+ * @param q              Notch quality factor, higher is narrower
+ * @param sample_rate_hz Rate at which BIQUAD_Apply is called in Hz
+ *
+ * @retval BIQUAD_SUCCESS - Operation finished successfully
+ * @retval BIQUAD_INVALID_PARAM - Filter pointer is not set or the center
+ * frequency is not below the Nyquist frequency
+ */
+BIQUAD_Error_Type BIQUAD_SetNotch(BIQUAD_Inst_Type *filter,
+                                  float center_freq_hz, float q,
+                                  float sample_rate_hz);
+
+/**
+ * @brief Clears the filter state
+ *
+ * @param filter A pointer to the filter instance
+ */
+void BIQUAD_Reset(BIQUAD_Inst_Type *filter);
+
+/**
+ * @brief Filters a single sample
+ *
+ * @param filter A pointer to the filter instance
+ * @param input  Input sample
+ *
+ * @return Filtered sample
+ */
+static inline float BIQUAD_Apply(BIQUAD_Inst_Type *filter, const float input) {
+    const float output = filter->b0 * input + filter->s1;
+
+    filter->s1 = filter->b1 * input - filter->a1 * output + filter->s2;
+    filter->s2 = filter->b2 * input - filter->a2 * output;
+
+    return output;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BIQUAD_H
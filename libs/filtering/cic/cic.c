@@ -0,0 +1,94 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cic.h"
+
+#include <stddef.h>
+#include <string.h>
+
+CIC_Error_Type CIC_Init(CIC_Inst_Type *inst, const CIC_Config_Type *cfg) {
+    if (inst == NULL || cfg == NULL) {
+        return CIC_INVALID_PARAM;
+    }
+
+    if (cfg->order == 0 || cfg->order > CIC_MAX_ORDER || cfg->ratio == 0 ||
+        cfg->input_rate_hz <= 0.0f) {
+        return CIC_INVALID_PARAM;
+    }
+
+    inst->cfg = *cfg;
+
+    // The DC gain of the filter is ratio^order
+    float gain = 1.0f;
+    for (int stage = 0; stage < cfg->order; stage++) {
+        gain *= cfg->ratio;
+    }
+    inst->scale = cfg->output_scale / gain;
+
+    // Linear phase, delayed by half of the impulse response length
+    inst->group_delay_us = (uint32_t)(cfg->order * (cfg->ratio - 1) *
+                                      1000000.0f / (2.0f * cfg->input_rate_hz));
+
+    CIC_Reset(inst);
+    inst->initialized = true;
+
+    return CIC_SUCCESS;
+}
+
+void CIC_Reset(CIC_Inst_Type *inst) {
+    memset(inst->integrator, 0, sizeof(inst->integrator));
+    memset(inst->comb_delay, 0, sizeof(inst->comb_delay));
+    inst->phase = 0;
+}
+
+bool CIC_Push(CIC_Inst_Type *inst, const int32_t input[CIC_AXIS_COUNT],
+              const uint64_t timestamp_us, CIC_Output_Type *output) {
+    const uint8_t order = inst->cfg.order;
+
+    for (int axis = 0; axis < CIC_AXIS_COUNT; axis++) {
+        uint64_t *integrator = inst->integrator[axis];
+        uint64_t acc = (uint64_t)(int64_t)input[axis];
+
+        for (int stage = 0; stage < order; stage++) {
+            integrator[stage] += acc;
+            acc = integrator[stage];
+        }
+    }
+
+    inst->phase++;
+    if (inst->phase < inst->cfg.ratio) {
+        return false;
+    }
+    inst->phase = 0;
+
+    for (int axis = 0; axis < CIC_AXIS_COUNT; axis++) {
+        uint64_t *comb_delay = inst->comb_delay[axis];
+        uint64_t acc = inst->integrator[axis][order - 1];
+
+        for (int stage = 0; stage < order; stage++) {
+            const uint64_t diff = acc - comb_delay[stage];
+            comb_delay[stage] = acc;
+            acc = diff;
+        }
+
+        output->value[axis] = (float)(int64_t)acc * inst->scale;
+    }
+
+    output->timestamp_us = timestamp_us - inst->group_delay_us;
+
+    return true;
+}
@@ -0,0 +1,102 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CIC_H
+#define CIC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CIC_AXIS_COUNT 3
+#define CIC_MAX_ORDER 4
+
+typedef enum {
+    CIC_SUCCESS = 0,
+    CIC_INVALID_PARAM,
+} CIC_Error_Type;
+
+typedef struct {
+    uint8_t order;       // Number of integrator and comb stages
+    uint16_t ratio;      // Number of input samples per output sample
+    float input_rate_hz; // Input sample rate, used for the group delay
+    float output_scale;  // Unit conversion applied to decimated samples
+} CIC_Config_Type;
+
+typedef struct {
+    uint64_t timestamp_us; // Time the decimated sample is centered at
+    float value[CIC_AXIS_COUNT];
+} CIC_Output_Type;
+
+typedef struct {
+    CIC_Config_Type cfg;
+
+    // Unsigned to get well defined wrap-around, which the comb stages undo
+    uint64_t integrator[CIC_AXIS_COUNT][CIC_MAX_ORDER];
+    uint64_t comb_delay[CIC_AXIS_COUNT][CIC_MAX_ORDER];
+    uint16_t phase;
+
+    float scale;
+    uint32_t group_delay_us;
+    bool initialized;
+} CIC_Inst_Type;
+
+/**
+ * @brief Initializes a three axis CIC decimator
+ *
+ * @param inst A pointer to the decimator instance
+ * @param cfg  Configuration struct pointer
+ *
+ * @retval CIC_SUCCESS - Operation finished successfully
+ * @retval CIC_INVALID_PARAM - Pointers are not set, or order or ratio are out
+ * of range
+ */
+CIC_Error_Type CIC_Init(CIC_Inst_Type *inst, const CIC_Config_Type *cfg);
+
+/**
+ * @brief Clears the decimator state
+ *
+ * @param inst A pointer to the decimator instance
+ */
+void CIC_Reset(CIC_Inst_Type *inst);
+
+/**
+ * @brief Feeds one input sample to the decimator
+ *
+ * The integrators run on every input sample with integer additions only.
+ * Every ratio-th call the comb stages produce a decimated sample, normalized
+ * by the filter gain and scaled by output_scale.
+ *
+ * @param inst         A pointer to the decimator instance
+ * @param input        One integer sample per axis
+ * @param timestamp_us Time the input sample was taken at in microseconds
+ * @param output       Filled with the decimated sample when one is produced
+ *
+ * @retval true - A decimated sample has been written to output
+ * @retval false - More input samples are needed
+ */
+bool CIC_Push(CIC_Inst_Type *inst, const int32_t input[CIC_AXIS_COUNT],
+              uint64_t timestamp_us, CIC_Output_Type *output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CIC_H
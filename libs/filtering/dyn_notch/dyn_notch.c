@@ -0,0 +1,270 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dyn_notch.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+
+#define DYN_NOTCH_PI 3.14159265358979f
+
+// Weight of a new peak measurement, the rest is kept from the previous one
+#define DYN_NOTCH_PEAK_SMOOTHING 0.3f
+
+// A peak has to exceed the mean power of the searched range by this factor,
+// otherwise window side lobes and broadband noise would steer the notches
+#define DYN_NOTCH_PEAK_THRESHOLD 2.0f
+
+static void WindowStep(DYN_NOTCH_Inst_Type *inst);
+static void PeaksStep(DYN_NOTCH_Inst_Type *inst);
+static void RetuneStep(DYN_NOTCH_Inst_Type *inst);
+
+DYN_NOTCH_Error_Type DYN_NOTCH_Init(DYN_NOTCH_Inst_Type *inst,
+                                    const DYN_NOTCH_Config_Type *cfg) {
+    if (inst == NULL || cfg == NULL) {
+        return DYN_NOTCH_INVALID_PARAM;
+    }
+
+    if (cfg->notch_count == 0 || cfg->notch_count > DYN_NOTCH_MAX_PEAKS ||
+        cfg->min_freq_hz >= cfg->max_freq_hz ||
+        cfg->max_freq_hz >= cfg->sample_rate_hz / 2.0f) {
+        return DYN_NOTCH_INVALID_PARAM;
+    }
+
+    memset(inst, 0, sizeof(*inst));
+    inst->cfg = *cfg;
+
+    if (arm_rfft_fast_init_f32(&inst->rfft, DYN_NOTCH_FFT_SIZE) !=
+        ARM_MATH_SUCCESS) {
+        return DYN_NOTCH_FFT_ERROR;
+    }
+
+    // Hann window, computed once so the hot path has no trigonometry
+    for (int i = 0; i < DYN_NOTCH_FFT_SIZE; i++) {
+        inst->window[i] =
+            0.5f - 0.5f * cosf(2.0f * DYN_NOTCH_PI * i /
+                               (float)(DYN_NOTCH_FFT_SIZE - 1));
+    }
+
+    // Peak interpolation needs a neighbour on each side of every bin
+    inst->bin_width_hz = cfg->sample_rate_hz / DYN_NOTCH_FFT_SIZE;
+    inst->min_bin = (uint16_t)(cfg->min_freq_hz / inst->bin_width_hz);
+    if (inst->min_bin < 1) {
+        inst->min_bin = 1;
+    }
+    inst->max_bin = (uint16_t)ceilf(cfg->max_freq_hz / inst->bin_width_hz);
+    if (inst->max_bin > DYN_NOTCH_BIN_COUNT - 2) {
+        inst->max_bin = DYN_NOTCH_BIN_COUNT - 2;
+    }
+
+    for (int axis = 0; axis < DYN_NOTCH_AXIS_COUNT; axis++) {
+        for (int i = 0; i < cfg->notch_count; i++) {
+            inst->peak_freq_hz[axis][i] = cfg->max_freq_hz;
+            BIQUAD_InitNotch(&inst->notch[axis][i], cfg->max_freq_hz, cfg->q,
+                             cfg->sample_rate_hz);
+        }
+    }
+
+    inst->step = DYN_NOTCH_STEP_WINDOW;
+    inst->initialized = true;
+
+    return DYN_NOTCH_SUCCESS;
+}
+
+void DYN_NOTCH_Push(DYN_NOTCH_Inst_Type *inst,
+                    const float sample[DYN_NOTCH_AXIS_COUNT]) {
+    for (int axis = 0; axis < DYN_NOTCH_AXIS_COUNT; axis++) {
+        inst->samples[axis][inst->sample_idx] = sample[axis];
+    }
+
+    inst->sample_idx = (inst->sample_idx + 1) & (DYN_NOTCH_FFT_SIZE - 1);
+}
+
+bool DYN_NOTCH_Update(DYN_NOTCH_Inst_Type *inst) {
+    if (!inst->initialized) {
+        return false;
+    }
+
+    const uint32_t start_cycles = k_cycle_get_32();
+    const DYN_NOTCH_Step_Type step = inst->step;
+    bool pass_done = false;
+
+    switch (step) {
+    case DYN_NOTCH_STEP_WINDOW:
+        WindowStep(inst);
+        inst->step = DYN_NOTCH_STEP_FFT;
+        break;
+
+    case DYN_NOTCH_STEP_FFT:
+        arm_rfft_fast_f32(&inst->rfft, inst->fft_in, inst->fft_out, 0);
+        inst->step = DYN_NOTCH_STEP_MAGNITUDE;
+        break;
+
+    case DYN_NOTCH_STEP_MAGNITUDE:
+        // Bin 0 holds the packed DC and Nyquist terms, it is never searched
+        arm_cmplx_mag_squared_f32(inst->fft_out, inst->magnitude,
+                                  DYN_NOTCH_BIN_COUNT);
+        inst->step = DYN_NOTCH_STEP_PEAKS;
+        break;
+
+    case DYN_NOTCH_STEP_PEAKS:
+        PeaksStep(inst);
+        inst->step = DYN_NOTCH_STEP_RETUNE;
+        break;
+
+    case DYN_NOTCH_STEP_RETUNE:
+        RetuneStep(inst);
+        inst->step = DYN_NOTCH_STEP_WINDOW;
+
+        inst->axis++;
+        if (inst->axis >= DYN_NOTCH_AXIS_COUNT) {
+            inst->axis = 0;
+            pass_done = true;
+        }
+        break;
+
+    default:
+        inst->step = DYN_NOTCH_STEP_WINDOW;
+        break;
+    }
+
+    const uint32_t elapsed_cycles = k_cycle_get_32() - start_cycles;
+    if (step < DYN_NOTCH_STEP_COUNT &&
+        elapsed_cycles > inst->step_cycles_max[step]) {
+        inst->step_cycles_max[step] = elapsed_cycles;
+    }
+
+    return pass_done;
+}
+
+void DYN_NOTCH_Apply(DYN_NOTCH_Inst_Type *inst,
+                     float sample[DYN_NOTCH_AXIS_COUNT]) {
+    for (int axis = 0; axis < DYN_NOTCH_AXIS_COUNT; axis++) {
+        for (int i = 0; i < inst->cfg.notch_count; i++) {
+            sample[axis] = BIQUAD_Apply(&inst->notch[axis][i], sample[axis]);
+        }
+    }
+}
+
+uint32_t DYN_NOTCH_GetMaxStepCycles(const DYN_NOTCH_Inst_Type *inst) {
+    uint32_t max_cycles = 0;
+
+    for (int step = 0; step < DYN_NOTCH_STEP_COUNT; step++) {
+        if (inst->step_cycles_max[step] > max_cycles) {
+            max_cycles = inst->step_cycles_max[step];
+        }
+    }
+
+    return max_cycles;
+}
+
+static void WindowStep(DYN_NOTCH_Inst_Type *inst) {
+    // The oldest sample is the one about to be overwritten
+    const float *samples = inst->samples[inst->axis];
+    uint16_t idx = inst->sample_idx;
+
+    for (int i = 0; i < DYN_NOTCH_FFT_SIZE; i++) {
+        inst->fft_in[i] = samples[idx] * inst->window[i];
+        idx = (idx + 1) & (DYN_NOTCH_FFT_SIZE - 1);
+    }
+}
+
+static void PeaksStep(DYN_NOTCH_Inst_Type *inst) {
+    const float *mag = inst->magnitude;
+    const uint8_t notch_count = inst->cfg.notch_count;
+
+    uint16_t peak_bins[DYN_NOTCH_MAX_PEAKS] = {0};
+    int found = 0;
+
+    float mean = 0.0f;
+    for (uint16_t bin = inst->min_bin; bin <= inst->max_bin; bin++) {
+        mean += mag[bin];
+    }
+    mean /= (float)(inst->max_bin - inst->min_bin + 1);
+    const float threshold = DYN_NOTCH_PEAK_THRESHOLD * mean;
+
+    // Keep the strongest local maxima, sorted by descending magnitude
+    for (uint16_t bin = inst->min_bin; bin <= inst->max_bin; bin++) {
+        if (mag[bin] <= threshold ||
+            !(mag[bin] > mag[bin - 1] && mag[bin] >= mag[bin + 1])) {
+            continue;
+        }
+
+        int pos = found < notch_count ? found : notch_count;
+        while (pos > 0 && mag[bin] > mag[peak_bins[pos - 1]]) {
+            if (pos < notch_count) {
+                peak_bins[pos] = peak_bins[pos - 1];
+            }
+            pos--;
+        }
+
+        if (pos < notch_count) {
+            peak_bins[pos] = bin;
+            if (found < notch_count) {
+                found++;
+            }
+        }
+    }
+
+    // Order by frequency so each notch follows the same peak between updates
+    for (int i = 1; i < found; i++) {
+        const uint16_t bin = peak_bins[i];
+        int j = i;
+        while (j > 0 && peak_bins[j - 1] > bin) {
+            peak_bins[j] = peak_bins[j - 1];
+            j--;
+        }
+        peak_bins[j] = bin;
+    }
+
+    float *peak_freq_hz = inst->peak_freq_hz[inst->axis];
+
+    for (int i = 0; i < found; i++) {
+        const uint16_t bin = peak_bins[i];
+        const float y0 = mag[bin - 1];
+        const float y1 = mag[bin];
+        const float y2 = mag[bin + 1];
+
+        // Parabolic interpolation between neighbouring bins
+        const float denominator = y0 - 2.0f * y1 + y2;
+        float offset = 0.0f;
+        if (denominator != 0.0f) {
+            offset = 0.5f * (y0 - y2) / denominator;
+        }
+
+        float freq_hz = (bin + offset) * inst->bin_width_hz;
+        if (freq_hz < inst->cfg.min_freq_hz) {
+            freq_hz = inst->cfg.min_freq_hz;
+        } else if (freq_hz > inst->cfg.max_freq_hz) {
+            freq_hz = inst->cfg.max_freq_hz;
+        }
+
+        peak_freq_hz[i] +=
+            DYN_NOTCH_PEAK_SMOOTHING * (freq_hz - peak_freq_hz[i]);
+    }
+}
+
+static void RetuneStep(DYN_NOTCH_Inst_Type *inst) {
+    const uint8_t axis = inst->axis;
+
+    for (int i = 0; i < inst->cfg.notch_count; i++) {
+        BIQUAD_SetNotch(&inst->notch[axis][i], inst->peak_freq_hz[axis][i],
+                        inst->cfg.q, inst->cfg.sample_rate_hz);
+    }
+}
@@ -0,0 +1,151 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYN_NOTCH_H
+#define DYN_NOTCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <arm_math.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "biquad.h"
+
+// Has to be a power of two supported by arm_rfft_fast_init_f32
+#define DYN_NOTCH_FFT_SIZE 64
+#define DYN_NOTCH_BIN_COUNT (DYN_NOTCH_FFT_SIZE / 2)
+#define DYN_NOTCH_AXIS_COUNT 3
+#define DYN_NOTCH_MAX_PEAKS 3
+
+typedef enum {
+    DYN_NOTCH_SUCCESS = 0,
+    DYN_NOTCH_INVALID_PARAM,
+    DYN_NOTCH_FFT_ERROR,
+} DYN_NOTCH_Error_Type;
+
+/*
+ * The spectrum analysis of one axis is split into these steps, and only one
+ * step is executed per DYN_NOTCH_Update call, which bounds the time spent in
+ * a single control cycle to the cost of the most expensive step.
+ */
+typedef enum {
+    DYN_NOTCH_STEP_WINDOW = 0,
+    DYN_NOTCH_STEP_FFT,
+    DYN_NOTCH_STEP_MAGNITUDE,
+    DYN_NOTCH_STEP_PEAKS,
+    DYN_NOTCH_STEP_RETUNE,
+    DYN_NOTCH_STEP_COUNT,
+} DYN_NOTCH_Step_Type;
+
+typedef struct {
+    float sample_rate_hz; // Rate of the filtered sample stream
+    float min_freq_hz;    // Lowest frequency a notch can be placed at
+    float max_freq_hz;    // Highest frequency a notch can be placed at
+    float q;              // Quality factor of every notch
+    uint8_t notch_count;  // Notches per axis, up to DYN_NOTCH_MAX_PEAKS
+} DYN_NOTCH_Config_Type;
+
+typedef struct {
+    DYN_NOTCH_Config_Type cfg;
+    arm_rfft_fast_instance_f32 rfft;
+
+    float window[DYN_NOTCH_FFT_SIZE];
+    float samples[DYN_NOTCH_AXIS_COUNT][DYN_NOTCH_FFT_SIZE];
+    uint16_t sample_idx;
+
+    float fft_in[DYN_NOTCH_FFT_SIZE];
+    float fft_out[DYN_NOTCH_FFT_SIZE];
+    float magnitude[DYN_NOTCH_BIN_COUNT];
+    float bin_width_hz;
+    uint16_t min_bin;
+    uint16_t max_bin;
+
+    DYN_NOTCH_Step_Type step;
+    uint8_t axis;
+
+    float peak_freq_hz[DYN_NOTCH_AXIS_COUNT][DYN_NOTCH_MAX_PEAKS];
+    BIQUAD_Inst_Type notch[DYN_NOTCH_AXIS_COUNT][DYN_NOTCH_MAX_PEAKS];
+
+    uint32_t step_cycles_max[DYN_NOTCH_STEP_COUNT];
+    bool initialized;
+} DYN_NOTCH_Inst_Type;
+
+/**
+ * @brief Initializes the dynamic notch filter
+ *
+ * All notches start at the maximum frequency and are moved to the detected
+ * peaks as the analysis progresses.
+ *
+ * @param inst A pointer to the dynamic notch instance
+ * @param cfg  Configuration struct pointer
+ *
+ * @retval DYN_NOTCH_SUCCESS - Operation finished successfully
+ * @retval DYN_NOTCH_INVALID_PARAM - Pointers are not set or the configured
+ * frequency range does not fit into the spectrum
+ * @retval DYN_NOTCH_FFT_ERROR - The FFT could not be initialized
+ */
+DYN_NOTCH_Error_Type DYN_NOTCH_Init(DYN_NOTCH_Inst_Type *inst,
+                                    const DYN_NOTCH_Config_Type *cfg);
+
+/**
+ * @brief Adds an unfiltered sample to the analysis window
+ *
+ * @param inst   A pointer to the dynamic notch instance
+ * @param sample One sample per axis
+ */
+void DYN_NOTCH_Push(DYN_NOTCH_Inst_Type *inst,
+                    const float sample[DYN_NOTCH_AXIS_COUNT]);
+
+/**
+ * @brief Executes a single step of the spectrum analysis
+ *
+ * Meant to be called once per control cycle. A full analysis of all axes
+ * takes DYN_NOTCH_STEP_COUNT * DYN_NOTCH_AXIS_COUNT calls.
+ *
+ * @param inst A pointer to the dynamic notch instance
+ *
+ * @retval true - All axes have been analysed and their notches retuned
+ * @retval false - The analysis is still in progress
+ */
+bool DYN_NOTCH_Update(DYN_NOTCH_Inst_Type *inst);
+
+/**
+ * @brief Filters a sample with the notches of all axes, in place
+ *
+ * @param inst   A pointer to the dynamic notch instance
+ * @param sample One sample per axis
+ */
+void DYN_NOTCH_Apply(DYN_NOTCH_Inst_Type *inst,
+                     float sample[DYN_NOTCH_AXIS_COUNT]);
+
+/**
+ * @brief Gets the worst case cost of a single DYN_NOTCH_Update call
+ *
+ * @param inst A pointer to the dynamic notch instance
+ *
+ * @return Maximum number of hardware cycles spent in one step so far
+ */
+uint32_t DYN_NOTCH_GetMaxStepCycles(const DYN_NOTCH_Inst_Type *inst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DYN_NOTCH_H
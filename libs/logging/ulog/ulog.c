@@ -18,6 +18,7 @@
 #include "ulog.h"
 
 #include <stdint.h>
+#include <string.h>
 #include <zephyr/fs/fs.h>
 #include <zephyr/kernel.h>
 
@@ -26,85 +27,118 @@ typedef struct __attribute__((packed)) {
     uint8_t msg_type;
 } Message_Header_Type;
 
-static int WriteHeader(struct fs_file_t *file_h) {
-    const uint8_t magic[] = {0x55, 0x4c, 0x6f, 0x67, 0x01, 0x12, 0x35};
+static int FileWrite(void *ctx, const void *data, size_t len, bool reliable) {
+    const ssize_t ret = fs_write(ctx, data, len);
 
-    int ret = fs_write(file_h, magic, sizeof(magic));
-    if (ret < 0) {
-        return ret;
+    return ret < 0 ? ret : 0;
+}
+
+static int FileSync(void *ctx) { return fs_sync(ctx); }
+
+static int FileClose(void *ctx) { return fs_close(ctx); }
+
+// Writes to every output, an output failing does not stop the others
+static int OutputWrite(ULOG_Inst_Type *log, const void *data, size_t len,
+                       bool reliable) {
+    int status = 0;
+
+    for (uint8_t i = 0; i < log->output_count; i++) {
+        const ULOG_Output_Type *output = &log->outputs[i];
+
+        int ret = output->write(output->ctx, data, len, reliable);
+        if (ret < 0) {
+            status = ret;
+        }
     }
 
-    const uint8_t protocol_version = ULOG_PROTOCOL_VERSION;
-    ret = fs_write(file_h, &protocol_version, sizeof(protocol_version));
-    if (ret < 0) {
-        return ret;
+    return status;
+}
+
+static int OutputSync(ULOG_Inst_Type *log) {
+    int status = 0;
+
+    for (uint8_t i = 0; i < log->output_count; i++) {
+        const ULOG_Output_Type *output = &log->outputs[i];
+
+        if (output->sync != NULL) {
+            int ret = output->sync(output->ctx);
+            if (ret < 0) {
+                status = ret;
+            }
+        }
     }
 
-    const uint64_t uptime_us = k_uptime_get() * 1000;
-    ret = fs_write(file_h, &uptime_us, sizeof(uptime_us));
-    if (ret < 0) {
-        return ret;
+    return status;
+}
+
+static int OutputClose(ULOG_Inst_Type *log) {
+    int status = 0;
+
+    for (uint8_t i = 0; i < log->output_count; i++) {
+        const ULOG_Output_Type *output = &log->outputs[i];
+
+        if (output->close != NULL) {
+            int ret = output->close(output->ctx);
+            if (ret < 0) {
+                status = ret;
+            }
+        }
     }
 
-    return 0;
+    log->output_count = 0;
+
+    return status;
 }
 
-static int WriteFlagBits(struct fs_file_t *file_h, bool has_default_params,
-                         bool has_appended_data, uint64_t *appended_offsets) {
+static int WriteHeader(ULOG_Inst_Type *log) {
+    uint8_t header[16] = {0x55, 0x4c, 0x6f, 0x67, 0x01, 0x12, 0x35};
+
+    header[7] = ULOG_PROTOCOL_VERSION;
+
+    const uint64_t uptime_us = k_uptime_get() * 1000;
+    memcpy(&header[8], &uptime_us, sizeof(uptime_us));
+
+    return OutputWrite(log, header, sizeof(header), true);
+}
+
+static ULOG_Error_Type WriteFlagBits(ULOG_Inst_Type *log,
+                                     bool has_default_params,
+                                     bool has_appended_data,
+                                     uint64_t *appended_offsets) {
     uint8_t compat_flags[8] = {0};
     uint8_t incompat_flags[8] = {0};
 
-    Message_Header_Type header = {
-        .msg_type = 'B',
-        .msg_size = sizeof(compat_flags) + sizeof(incompat_flags) +
-                    sizeof(uint64_t) * 3,
-    };
-
-    int ret = fs_write(file_h, &header, sizeof(header));
-    if (ret < 0) {
-        return ret;
+    ULOG_Error_Type status =
+        ULOG_MessageBegin(log, 'B',
+                          sizeof(compat_flags) + sizeof(incompat_flags) +
+                              sizeof(uint64_t) * 3);
+    if (status != ULOG_SUCCESS) {
+        return status;
     }
 
     compat_flags[0] |= has_default_params << 0;
-    ret = fs_write(file_h, compat_flags, sizeof(compat_flags));
-    if (ret < 0) {
-        return ret;
-    }
+    ULOG_MessageAppend(log, compat_flags, sizeof(compat_flags));
 
     incompat_flags[0] |= has_appended_data << 0;
-    ret = fs_write(file_h, incompat_flags, sizeof(incompat_flags));
-    if (ret < 0) {
-        return ret;
-    }
+    ULOG_MessageAppend(log, incompat_flags, sizeof(incompat_flags));
 
-    ret = fs_write(file_h, appended_offsets, sizeof(uint64_t) * 3);
-    if (ret < 0) {
-        return ret;
-    }
+    ULOG_MessageAppend(log, appended_offsets, sizeof(uint64_t) * 3);
 
-    return 0;
+    return ULOG_MessageEnd(log);
 }
 
-static int WriteSync(struct fs_file_t *file_h) {
+static ULOG_Error_Type WriteSync(ULOG_Inst_Type *log) {
     const uint8_t sync_magic[] = {0x2f, 0x73, 0x13, 0x20,
                                   0x25, 0x0c, 0xbb, 0x12};
 
-    Message_Header_Type header = {
-        .msg_type = 'S',
-        .msg_size = sizeof(sync_magic),
-    };
-
-    int ret = fs_write(file_h, &header, sizeof(header));
-    if (ret < 0) {
-        return ret;
+    ULOG_Error_Type status = ULOG_MessageBegin(log, 'S', sizeof(sync_magic));
+    if (status != ULOG_SUCCESS) {
+        return status;
     }
 
-    ret = fs_write(file_h, sync_magic, sizeof(sync_magic));
-    if (ret < 0) {
-        return ret;
-    }
+    ULOG_MessageAppend(log, sync_magic, sizeof(sync_magic));
 
-    return 0;
+    return ULOG_MessageEnd(log);
 }
 
 ULOG_Error_Type ULOG_Init(ULOG_Inst_Type *log, const ULOG_Config_Type *cfg) {
@@ -112,30 +146,48 @@ ULOG_Error_Type ULOG_Init(ULOG_Inst_Type *log, const ULOG_Config_Type *cfg) {
         return ULOG_INVALID_PARAM;
     }
 
-    fs_file_t_init(&log->file);
-
-    const fs_mode_t flags = FS_O_CREATE | FS_O_WRITE;
-    int ret = fs_open(&log->file, cfg->filename, flags);
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
+    if (cfg->filename == NULL && cfg->output == NULL) {
+        return ULOG_INVALID_PARAM;
     }
 
-    ret = WriteHeader(&log->file);
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
+    log->output_count = 0;
+    log->message_len = 0;
+    log->message_end = 0;
+
+    if (cfg->filename != NULL) {
+        fs_file_t_init(&log->file);
+
+        const fs_mode_t flags = FS_O_CREATE | FS_O_WRITE;
+        int ret = fs_open(&log->file, cfg->filename, flags);
+        if (ret < 0) {
+            return ULOG_FILESYSTEM_ERROR;
+        }
+
+        log->outputs[log->output_count++] = (ULOG_Output_Type){
+            .write = FileWrite,
+            .sync = FileSync,
+            .close = FileClose,
+            .ctx = &log->file,
+        };
     }
 
-    // Currently, default parameters and appended offsets are unsupported
-    uint64_t appended_offsets[3] = {0};
-    ret = WriteFlagBits(&log->file, false, false, appended_offsets);
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
+    if (cfg->output != NULL) {
+        log->outputs[log->output_count++] = *cfg->output;
     }
 
+    // The definitions phase is entered first, so everything up to the data is
+    // written reliably
     log->phase = ULOG_PHASE_DEFINITIONS;
     log->next_msg_id = 0;
 
-    return ULOG_SUCCESS;
+    int ret = WriteHeader(log);
+    if (ret < 0) {
+        return ULOG_FILESYSTEM_ERROR;
+    }
+
+    // Currently, default parameters and appended offsets are unsupported
+    uint64_t appended_offsets[3] = {0};
+    return WriteFlagBits(log, false, false, appended_offsets);
 }
 
 ULOG_Error_Type ULOG_AddInfo(ULOG_Inst_Type *log, const char *key,
@@ -149,30 +201,17 @@ ULOG_Error_Type ULOG_AddInfo(ULOG_Inst_Type *log, const char *key,
         return ULOG_WRONG_PHASE;
     }
 
-    Message_Header_Type header = {
-        .msg_type = 'I', .msg_size = sizeof(uint8_t) + key_len + val_len};
-
-    int ret = fs_write(&log->file, &header, sizeof(header));
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
-    }
-
-    ret = fs_write(&log->file, &key_len, sizeof(key_len));
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
-    }
-
-    ret = fs_write(&log->file, key, key_len);
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
+    ULOG_Error_Type status =
+        ULOG_MessageBegin(log, 'I', sizeof(uint8_t) + key_len + val_len);
+    if (status != ULOG_SUCCESS) {
+        return status;
     }
 
-    ret = fs_write(&log->file, val, val_len);
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
-    }
+    ULOG_MessageAppend(log, &key_len, sizeof(key_len));
+    ULOG_MessageAppend(log, key, key_len);
+    ULOG_MessageAppend(log, val, val_len);
 
-    return ULOG_SUCCESS;
+    return ULOG_MessageEnd(log);
 }
 
 ULOG_Error_Type ULOG_AddParameter(ULOG_Inst_Type *log, const char *key,
@@ -181,33 +220,19 @@ ULOG_Error_Type ULOG_AddParameter(ULOG_Inst_Type *log, const char *key,
         return ULOG_INVALID_PARAM;
     }
 
-    Message_Header_Type header = {
-        .msg_type = 'P',
-        .msg_size =
-            sizeof(uint8_t) + key_len + 4 // Size of either int32_t or float
-    };
-
-    int ret = fs_write(&log->file, &header, sizeof(header));
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
-    }
-
-    ret = fs_write(&log->file, &key_len, sizeof(key_len));
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
-    }
-
-    ret = fs_write(&log->file, key, key_len);
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
+    ULOG_Error_Type status = ULOG_MessageBegin(
+        log, 'P',
+        sizeof(uint8_t) + key_len + 4 // Size of either int32_t or float
+    );
+    if (status != ULOG_SUCCESS) {
+        return status;
     }
 
-    ret = fs_write(&log->file, val, 4);
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
-    }
+    ULOG_MessageAppend(log, &key_len, sizeof(key_len));
+    ULOG_MessageAppend(log, key, key_len);
+    ULOG_MessageAppend(log, val, 4);
 
-    return ULOG_SUCCESS;
+    return ULOG_MessageEnd(log);
 }
 
 ULOG_Error_Type ULOG_StartDataPhase(ULOG_Inst_Type *log) {
@@ -231,34 +256,21 @@ ULOG_Error_Type ULOG_LogString(ULOG_Inst_Type *log, const char *string,
         return ULOG_WRONG_PHASE;
     }
 
-    Message_Header_Type header = {
-        .msg_type = 'L',
-        .msg_size = sizeof(uint8_t) + sizeof(uint64_t) + len,
-    };
-
-    int ret = fs_write(&log->file, &header, sizeof(header));
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
+    ULOG_Error_Type status = ULOG_MessageBegin(
+        log, 'L', sizeof(uint8_t) + sizeof(uint64_t) + len);
+    if (status != ULOG_SUCCESS) {
+        return status;
     }
 
     const uint8_t log_level = level;
-    ret = fs_write(&log->file, &log_level, sizeof(log_level));
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
-    }
+    ULOG_MessageAppend(log, &log_level, sizeof(log_level));
 
     const uint64_t uptime_us = k_uptime_get() * 1000;
-    ret = fs_write(&log->file, &uptime_us, sizeof(uptime_us));
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
-    }
+    ULOG_MessageAppend(log, &uptime_us, sizeof(uptime_us));
 
-    ret = fs_write(&log->file, string, len);
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
-    }
+    ULOG_MessageAppend(log, string, len);
 
-    return ULOG_SUCCESS;
+    return ULOG_MessageEnd(log);
 }
 
 ULOG_Error_Type ULOG_LogTaggedString(ULOG_Inst_Type *log, const char *string,
@@ -273,39 +285,23 @@ ULOG_Error_Type ULOG_LogTaggedString(ULOG_Inst_Type *log, const char *string,
         return ULOG_WRONG_PHASE;
     }
 
-    Message_Header_Type header = {
-        .msg_type = 'C',
-        .msg_size = sizeof(uint8_t) + sizeof(uint16_t) + sizeof(uint64_t) + len,
-    };
-
-    int ret = fs_write(&log->file, &header, sizeof(header));
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
+    ULOG_Error_Type status = ULOG_MessageBegin(
+        log, 'C', sizeof(uint8_t) + sizeof(uint16_t) + sizeof(uint64_t) + len);
+    if (status != ULOG_SUCCESS) {
+        return status;
     }
 
     const uint8_t log_level = level;
-    ret = fs_write(&log->file, &log_level, sizeof(log_level));
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
-    }
+    ULOG_MessageAppend(log, &log_level, sizeof(log_level));
 
-    ret = fs_write(&log->file, &tag, sizeof(tag));
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
-    }
+    ULOG_MessageAppend(log, &tag, sizeof(tag));
 
     const uint64_t uptime_us = k_uptime_get() * 1000;
-    ret = fs_write(&log->file, &uptime_us, sizeof(uptime_us));
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
-    }
+    ULOG_MessageAppend(log, &uptime_us, sizeof(uptime_us));
 
-    ret = fs_write(&log->file, string, len);
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
-    }
+    ULOG_MessageAppend(log, string, len);
 
-    return ULOG_SUCCESS;
+    return ULOG_MessageEnd(log);
 }
 
 ULOG_Error_Type ULOG_LogDropout(ULOG_Inst_Type *log,
@@ -318,22 +314,14 @@ ULOG_Error_Type ULOG_LogDropout(ULOG_Inst_Type *log,
         return ULOG_WRONG_PHASE;
     }
 
-    Message_Header_Type header = {
-        .msg_type = 'O',
-        .msg_size = sizeof(uint16_t),
-    };
-
-    int ret = fs_write(&log->file, &header, sizeof(header));
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
+    ULOG_Error_Type status = ULOG_MessageBegin(log, 'O', sizeof(uint16_t));
+    if (status != ULOG_SUCCESS) {
+        return status;
     }
 
-    ret = fs_write(&log->file, &duration_ms, sizeof(duration_ms));
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
-    }
+    ULOG_MessageAppend(log, &duration_ms, sizeof(duration_ms));
 
-    return ULOG_SUCCESS;
+    return ULOG_MessageEnd(log);
 }
 
 ULOG_Error_Type ULOG_Sync(ULOG_Inst_Type *log) {
@@ -345,12 +333,12 @@ ULOG_Error_Type ULOG_Sync(ULOG_Inst_Type *log) {
         return ULOG_WRONG_PHASE;
     }
 
-    int ret = WriteSync(&log->file);
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
+    ULOG_Error_Type status = WriteSync(log);
+    if (status != ULOG_SUCCESS) {
+        return status;
     }
 
-    ret = fs_sync(&log->file);
+    int ret = OutputSync(log);
     return ret == 0 ? ULOG_SUCCESS : ULOG_FILESYSTEM_ERROR;
 }
 
@@ -359,12 +347,12 @@ ULOG_Error_Type ULOG_Close(ULOG_Inst_Type *log) {
         return ULOG_INVALID_PARAM;
     }
 
-    int ret = WriteSync(&log->file);
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
+    ULOG_Error_Type status = WriteSync(log);
+    if (status != ULOG_SUCCESS) {
+        return status;
     }
 
-    ret = fs_close(&log->file);
+    int ret = OutputClose(log);
     if (ret < 0) {
         return ULOG_FILESYSTEM_ERROR;
     }
@@ -375,3 +363,57 @@ ULOG_Error_Type ULOG_Close(ULOG_Inst_Type *log) {
 }
 
 ULOG_Phase_Type ULOG_GetPhase(ULOG_Inst_Type *log) { return log->phase; }
+
+ULOG_Error_Type ULOG_MessageBegin(ULOG_Inst_Type *log, const uint8_t type,
+                                  const size_t size) {
+    if (log == NULL) {
+        return ULOG_INVALID_PARAM;
+    }
+
+    if (size > ULOG_MESSAGE_MAX_LEN - sizeof(Message_Header_Type)) {
+        return ULOG_INVALID_PARAM;
+    }
+
+    const Message_Header_Type header = {
+        .msg_type = type,
+        .msg_size = size,
+    };
+
+    memcpy(log->message, &header, sizeof(header));
+    log->message_len = sizeof(header);
+    log->message_end = sizeof(header) + size;
+
+    return ULOG_SUCCESS;
+}
+
+void ULOG_MessageAppend(ULOG_Inst_Type *log, const void *data,
+                        const size_t len) {
+    if (log->message_len + len > log->message_end) {
+        // Fails the message, its length no longer matches the header
+        log->message_len = log->message_end + 1;
+        return;
+    }
+
+    memcpy(&log->message[log->message_len], data, len);
+    log->message_len += len;
+}
+
+ULOG_Error_Type ULOG_MessageEnd(ULOG_Inst_Type *log) {
+    if (log == NULL) {
+        return ULOG_INVALID_PARAM;
+    }
+
+    if (log->message_len != log->message_end) {
+        return ULOG_INVALID_PARAM;
+    }
+
+    const Message_Header_Type *header = (Message_Header_Type *)log->message;
+
+    // Subscriptions are needed to parse the data which follows them
+    const bool reliable =
+        log->phase == ULOG_PHASE_DEFINITIONS || header->msg_type == 'A';
+
+    int ret = OutputWrite(log, log->message, log->message_len, reliable);
+
+    return ret < 0 ? ULOG_FILESYSTEM_ERROR : ULOG_SUCCESS;
+}
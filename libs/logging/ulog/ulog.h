@@ -22,11 +22,22 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <zephyr/fs/fs_interface.h>
 
 #define ULOG_PROTOCOL_VERSION 1
 
+// Longest message including its header, messages are assembled in the log
+// instance and handed to the outputs at once
+#ifndef ULOG_MESSAGE_MAX_LEN
+#define ULOG_MESSAGE_MAX_LEN 512
+#endif
+
+// The log file and one additional output
+#define ULOG_MAX_OUTPUTS 2
+
 typedef enum {
     ULOG_SUCCESS = 0,
     ULOG_INVALID_PARAM,
@@ -51,14 +62,37 @@ typedef enum {
     ULOG_PHASE_DATA,
 } ULOG_Phase_Type;
 
+/**
+ * @brief Destination the log is written to, e.g. a file or a telemetry link
+ *
+ * Every write holds either the file header or one whole message. Reliable
+ * writes hold the header, definitions and subscriptions, without which the
+ * rest of the log can not be parsed, so the output must not lose them.
+ * Negative return values are reported as ULOG_FILESYSTEM_ERROR.
+ */
+typedef struct {
+    int (*write)(void *ctx, const void *data, size_t len, bool reliable);
+    int (*sync)(void *ctx);  // Can be NULL
+    int (*close)(void *ctx); // Can be NULL
+    void *ctx;
+} ULOG_Output_Type;
+
 typedef struct {
-    char *filename;
+    char *filename;                 // Can be NULL if the output is set
+    const ULOG_Output_Type *output; // Written along with the file, can be NULL
 } ULOG_Config_Type;
 
 typedef struct {
     ULOG_Phase_Type phase;
     struct fs_file_t file;
+    ULOG_Output_Type outputs[ULOG_MAX_OUTPUTS];
+    uint8_t output_count;
     uint16_t next_msg_id;
+
+    // Message being assembled
+    uint8_t message[ULOG_MESSAGE_MAX_LEN];
+    uint16_t message_len;
+    uint16_t message_end;
 } ULOG_Inst_Type;
 
 /**
@@ -69,7 +103,8 @@ typedef struct {
  * @param cfg Configuration struct pointer
  *
  * @retval ULOG_SUCCESS - Operation finished successfully
- * @retval ULOG_INVALID_PARAM - Log or configuration struct pointers are not set
+ * @retval ULOG_INVALID_PARAM - Log or configuration struct pointers are not
+ * set, or neither a file nor an output is
  * @retval ULOG_FILESYSTEM_ERROR - An error occurred either while opening the
  * file or while writing to it
  */
@@ -209,6 +244,44 @@ ULOG_Error_Type ULOG_Close(ULOG_Inst_Type *log);
  */
 ULOG_Phase_Type ULOG_GetPhase(ULOG_Inst_Type *log);
 
+/**
+ * @brief Starts assembling a message, used by the generated message writers
+ *
+ * @param log  A pointer to the log instance
+ * @param type ULOG message type
+ * @param size Size of the message without the header
+ *
+ * @retval ULOG_SUCCESS - Operation finished successfully
+ * @retval ULOG_INVALID_PARAM - Log pointer is not set or the message is longer
+ * than ULOG_MESSAGE_MAX_LEN
+ */
+ULOG_Error_Type ULOG_MessageBegin(ULOG_Inst_Type *log, uint8_t type,
+                                  size_t size);
+
+/**
+ * @brief Appends a field to the message being assembled
+ *
+ * @note Data past the size given to ULOG_MessageBegin is not appended and
+ * fails the message in ULOG_MessageEnd.
+ *
+ * @param log  A pointer to the log instance
+ * @param data A pointer to the field
+ * @param len  Size of the field in bytes
+ */
+void ULOG_MessageAppend(ULOG_Inst_Type *log, const void *data, size_t len);
+
+/**
+ * @brief Writes the assembled message to all outputs
+ *
+ * @param log A pointer to the log instance
+ *
+ * @retval ULOG_SUCCESS - Operation finished successfully
+ * @retval ULOG_INVALID_PARAM - Log pointer is not set or the appended data does
+ * not match the message size
+ * @retval ULOG_FILESYSTEM_ERROR - An error occurred while writing to an output
+ */
+ULOG_Error_Type ULOG_MessageEnd(ULOG_Inst_Type *log);
+
 #ifdef __cplusplus
 }
 #endif
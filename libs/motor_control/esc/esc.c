@@ -16,6 +16,7 @@
  */
 
 #include "esc.h"
+#include "esc_dshot.h"
 #include <stdint.h>
 #include <stdlib.h>
 #include <zephyr/devicetree.h>
@@ -46,7 +47,12 @@
 #define ESC_ARM_PULSE_ONESHOT_125_US 125
 #define ESC_ARM_PULSE_ONESHOT_42_US 42
 #define ESC_ARM_PULSE_MULTISHOT_US 5
-#define ESC_ARM_DURATION 3000 // NOTE: Arm duration is around 2000-5000 ms
+
+// DShot frame refresh period while arming or sending commands [ms]
+#define ESC_DSHOT_REFRESH_MS 1
+
+// Settings commands are only applied after being received this many times
+#define ESC_DSHOT_SETTINGS_CMD_REPEAT 10
 
 static float ApplyMinOffset(float min_pulse_val_us, float max_pulse_val_us,
                             uint8_t offset);
@@ -78,6 +84,7 @@ ESC_Error_Type ESC_Init(ESC_Inst_Type *esc_out, const struct device *pwm_dev,
 #else
         esc_out->max_pulse_duration_us = ESC_MAX_PULSE_PWM_US;
 #endif
+        esc_out->arm_pulse_duration_us = ESC_ARM_PULSE_PWM_US;
         esc_out->protocol = ESC_PWM;
         break;
 
@@ -98,6 +105,7 @@ ESC_Error_Type ESC_Init(ESC_Inst_Type *esc_out, const struct device *pwm_dev,
 #else
         esc_out->max_pulse_duration_us = ESC_MAX_PULSE_ONESHOT_125_US;
 #endif
+        esc_out->arm_pulse_duration_us = ESC_ARM_PULSE_ONESHOT_125_US;
         esc_out->protocol = ESC_ONESHOT_125;
         break;
 
@@ -118,6 +126,7 @@ ESC_Error_Type ESC_Init(ESC_Inst_Type *esc_out, const struct device *pwm_dev,
 #else
         esc_out->max_pulse_duration_us = ESC_MAX_PULSE_ONESHOT_42_US;
 #endif
+        esc_out->arm_pulse_duration_us = ESC_ARM_PULSE_ONESHOT_42_US;
         esc_out->protocol = ESC_ONESHOT_42;
         break;
 
@@ -138,9 +147,17 @@ ESC_Error_Type ESC_Init(ESC_Inst_Type *esc_out, const struct device *pwm_dev,
 #else
         esc_out->max_pulse_duration_us = ESC_MAX_PULSE_MULTISHOT_US;
 #endif
+        esc_out->arm_pulse_duration_us = ESC_ARM_PULSE_MULTISHOT_US;
         esc_out->protocol = ESC_MULTISHOT;
         break;
 
+    // DShot needs a DMA channel, see ESC_InitDshot
+    case ESC_DSHOT150:
+    case ESC_DSHOT300:
+    case ESC_DSHOT600:
+        esc_out->initialized = false;
+        return ESC_INVALID_PROTOCOL;
+
     default:
         esc_out->initialized = false;
         return ESC_NOT_INITIALIZED;
@@ -152,7 +169,41 @@ ESC_Error_Type ESC_Init(ESC_Inst_Type *esc_out, const struct device *pwm_dev,
     return ESC_SUCCESS;
 }
 
-ESC_Error_Type ESC_SetSpeed(const ESC_Inst_Type *esc, const float speed) {
+ESC_Error_Type ESC_InitDshot(ESC_Inst_Type *esc_out,
+                             const struct device *pwm_dev,
+                             const uint32_t pwm_channel,
+                             const ESC_Protocol_Type protocol,
+                             const ESC_Dshot_Config_Type *dshot_cfg) {
+    esc_out->initialized = false;
+
+#ifdef CONFIG_ESC_DSHOT
+    if (!device_is_ready(pwm_dev))
+        return ESC_DEVICE_PWM_NOT_READY;
+
+    if (!ESC_IsDshot(protocol))
+        return ESC_INVALID_PROTOCOL;
+
+    esc_out->pwm_dev = pwm_dev;
+    esc_out->pwm_channel = pwm_channel;
+    esc_out->protocol = protocol;
+    esc_out->period_us = 0;
+    esc_out->min_pulse_duration_us = 0;
+    esc_out->max_pulse_duration_us = 0;
+    esc_out->arm_pulse_duration_us = 0;
+
+    ESC_Error_Type status = ESC_DshotInit(esc_out, dshot_cfg);
+    if (status != ESC_SUCCESS)
+        return status;
+
+    esc_out->initialized = true;
+
+    return ESC_SUCCESS;
+#else
+    return ESC_INVALID_PROTOCOL;
+#endif
+}
+
+ESC_Error_Type ESC_SetSpeed(ESC_Inst_Type *esc, const float speed) {
     if (!esc->initialized) {
         return ESC_NOT_INITIALIZED;
     }
@@ -160,6 +211,21 @@ ESC_Error_Type ESC_SetSpeed(const ESC_Inst_Type *esc, const float speed) {
     if (speed > 1.0f || speed < 0.0f)
         return ESC_INVALID_SPEED_SET;
 
+#ifdef CONFIG_ESC_DSHOT
+    if (ESC_IsDshot(esc->protocol)) {
+        // Zero stops the motor, the lowest throttle step may still spin it
+        if (speed == 0.0f)
+            return ESC_DshotWrite(esc, ESC_DSHOT_CMD_MOTOR_STOP, false);
+
+        const uint16_t throttle =
+            ESC_DSHOT_THROTTLE_MIN +
+            (uint16_t)(speed *
+                       (ESC_DSHOT_THROTTLE_MAX - ESC_DSHOT_THROTTLE_MIN));
+
+        return ESC_DshotWrite(esc, throttle, false);
+    }
+#endif
+
     uint32_t pulse_duration_us =
         (uint32_t)(((esc->max_pulse_duration_us - esc->min_pulse_duration_us) *
                     speed) +
@@ -175,11 +241,71 @@ ESC_Error_Type ESC_SetSpeed(const ESC_Inst_Type *esc, const float speed) {
     return ESC_SUCCESS;
 }
 
-ESC_Error_Type ESC_Stop(const ESC_Inst_Type *esc) {
+ESC_Error_Type ESC_SendCommand(ESC_Inst_Type *esc,
+                               const ESC_Dshot_Command_Type command) {
+    if (!esc->initialized) {
+        return ESC_NOT_INITIALIZED;
+    }
+
+#ifdef CONFIG_ESC_DSHOT
+    if (!ESC_IsDshot(esc->protocol))
+        return ESC_INVALID_PROTOCOL;
+
+    if (command > ESC_DSHOT_CMD_MAX)
+        return ESC_INVALID_COMMAND;
+
+    // Everything from the spin direction commands on changes ESC settings
+    const int repeat = command >= ESC_DSHOT_CMD_SPIN_DIRECTION_1
+                           ? ESC_DSHOT_SETTINGS_CMD_REPEAT
+                           : 1;
+
+    for (int i = 0; i < repeat; i++) {
+        // Commands are only valid with the telemetry bit set
+        ESC_Error_Type status = ESC_DshotWrite(esc, command, true);
+        if (status != ESC_SUCCESS)
+            return status;
+
+        // Single commands return at once, so they can be sent from a loop
+        if (i + 1 < repeat)
+            k_msleep(ESC_DSHOT_REFRESH_MS);
+    }
+
+    return ESC_SUCCESS;
+#else
+    return ESC_INVALID_PROTOCOL;
+#endif
+}
+
+ESC_Error_Type ESC_GetTelemetry(const ESC_Inst_Type *esc,
+                                ESC_Dshot_Telemetry_Type *telemetry) {
     if (!esc->initialized) {
         return ESC_NOT_INITIALIZED;
     }
 
+#ifdef CONFIG_ESC_DSHOT_BIDIR
+    if (!ESC_IsDshot(esc->protocol) || !esc->dshot.bidirectional)
+        return ESC_INVALID_PROTOCOL;
+
+    *telemetry = esc->dshot_telemetry;
+
+    return ESC_SUCCESS;
+#else
+    return ESC_INVALID_PROTOCOL;
+#endif
+}
+
+ESC_Error_Type ESC_Stop(ESC_Inst_Type *esc) {
+    if (!esc->initialized) {
+        return ESC_NOT_INITIALIZED;
+    }
+
+#ifdef CONFIG_ESC_DSHOT
+    // The timer keeps running so the next frame can be sent right away
+    if (ESC_IsDshot(esc->protocol)) {
+        return ESC_DshotStop(esc);
+    }
+#endif
+
     int ret = pwm_set(esc->pwm_dev, esc->pwm_channel, 0, 0, 0);
     if (ret) {
         return ESC_INVALID_STOP;
@@ -199,36 +325,31 @@ ESC_Error_Type ESC_DeInit(ESC_Inst_Type *esc) {
     return ESC_SUCCESS;
 }
 
-ESC_Error_Type ESC_Arm(const ESC_Inst_Type *esc) {
-    uint32_t arm_duty_cycle;
-
+ESC_Error_Type ESC_Arm(ESC_Inst_Type *esc) {
     if (!esc->initialized) {
         return ESC_NOT_INITIALIZED;
     }
 
-    switch (esc->protocol) {
-    case ESC_PWM:
-        arm_duty_cycle = ESC_ARM_PULSE_PWM_US;
-        break;
-
-    case ESC_ONESHOT_125:
-        arm_duty_cycle = ESC_ARM_PULSE_ONESHOT_125_US;
-        break;
-
-    case ESC_ONESHOT_42:
-        arm_duty_cycle = ESC_ARM_PULSE_ONESHOT_42_US;
-        break;
-
-    case ESC_MULTISHOT:
-        arm_duty_cycle = ESC_ARM_PULSE_MULTISHOT_US;
-        break;
-
-    default:
-        return ESC_INVALID_PROTOCOL;
+#ifdef CONFIG_ESC_DSHOT
+    // DShot ESCs arm after receiving zero throttle frames for a while
+    if (ESC_IsDshot(esc->protocol)) {
+        for (int t = 0; t < ESC_ARM_DURATION; t += ESC_DSHOT_REFRESH_MS) {
+            ESC_Error_Type status =
+                ESC_DshotWrite(esc, ESC_DSHOT_CMD_MOTOR_STOP, false);
+            if (status != ESC_SUCCESS && status != ESC_DSHOT_BUSY) {
+                ESC_Stop(esc);
+                return ESC_INVALID_ARMING;
+            }
+
+            k_msleep(ESC_DSHOT_REFRESH_MS);
+        }
+
+        return ESC_SUCCESS;
     }
+#endif
 
     int ret = pwm_set(esc->pwm_dev, esc->pwm_channel, PWM_USEC(esc->period_us),
-                      PWM_USEC(arm_duty_cycle), 0);
+                      PWM_USEC(esc->arm_pulse_duration_us), 0);
 
     if (ret) {
         ESC_Stop(esc);
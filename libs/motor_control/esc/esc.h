@@ -19,9 +19,27 @@
 #define ESC_H
 
 #include <stdio.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/dma.h>
 #include <zephyr/drivers/pwm.h>
 #include <zephyr/kernel.h>
 
+// DShot frame length in timer periods, 16 bits followed by two low periods
+// which keep the line idle between frames
+#define ESC_DSHOT_FRAME_BITS 16
+#define ESC_DSHOT_BUFFER_LEN (ESC_DSHOT_FRAME_BITS + 2)
+
+// Bidirectional DShot reply, 21 GCR bits give at most 21 edges, plus the one
+// where the line is released to idle
+#define ESC_DSHOT_REPLY_BITS 21
+#define ESC_DSHOT_CAPTURE_LEN (ESC_DSHOT_REPLY_BITS + 1)
+
+// Time for which ESCs have to see the arming signal [ms]
+#define ESC_ARM_DURATION 3000 // NOTE: Arm duration is around 2000-5000 ms
+
+// Register base of the timer which drives the given PWM devicetree node
+#define ESC_DSHOT_TIMER_BASE(pwm_node) DT_REG_ADDR(DT_PARENT(pwm_node))
+
 typedef enum {
     ESC_SUCCESS = 0,
     ESC_DEVICE_PWM_NOT_READY,
@@ -31,23 +49,95 @@ typedef enum {
     ESC_NOT_INITIALIZED,
     ESC_INVALID_STOP,
     ESC_INVALID_ARMING,
+    ESC_DEVICE_DMA_NOT_READY,
+    ESC_INVALID_TIMER_CLOCK,
+    ESC_INVALID_COMMAND,
+    ESC_DSHOT_BUSY,
+    ESC_INVALID_CHANNELS,
+    ESC_ARMING_IN_PROGRESS,
+    ESC_PULSE_BUSY,
 } ESC_Error_Type;
 
 typedef enum {
     ESC_PWM = 0,
     ESC_ONESHOT_125,
     ESC_ONESHOT_42,
-    ESC_MULTISHOT
+    ESC_MULTISHOT,
+    ESC_DSHOT150,
+    ESC_DSHOT300,
+    ESC_DSHOT600,
 } ESC_Protocol_Type;
 
+// DShot command values, sent in place of throttle while motors are stopped
+typedef enum {
+    ESC_DSHOT_CMD_MOTOR_STOP = 0,
+    ESC_DSHOT_CMD_BEEP1 = 1,
+    ESC_DSHOT_CMD_BEEP2 = 2,
+    ESC_DSHOT_CMD_BEEP3 = 3,
+    ESC_DSHOT_CMD_BEEP4 = 4,
+    ESC_DSHOT_CMD_BEEP5 = 5,
+    ESC_DSHOT_CMD_ESC_INFO = 6,
+    ESC_DSHOT_CMD_SPIN_DIRECTION_1 = 7,
+    ESC_DSHOT_CMD_SPIN_DIRECTION_2 = 8,
+    ESC_DSHOT_CMD_3D_MODE_OFF = 9,
+    ESC_DSHOT_CMD_3D_MODE_ON = 10,
+    ESC_DSHOT_CMD_SETTINGS_REQUEST = 11,
+    ESC_DSHOT_CMD_SAVE_SETTINGS = 12,
+    ESC_DSHOT_CMD_EXTENDED_TELEMETRY_ENABLE = 13,
+    ESC_DSHOT_CMD_EXTENDED_TELEMETRY_DISABLE = 14,
+    ESC_DSHOT_CMD_SPIN_DIRECTION_NORMAL = 20,
+    ESC_DSHOT_CMD_SPIN_DIRECTION_REVERSED = 21,
+    ESC_DSHOT_CMD_MAX = 47,
+} ESC_Dshot_Command_Type;
+
+// Hardware used to stream DShot frames into one timer channel. The timer is
+// the parent of the PWM device, the DMA request is the one of the timer
+// channel.
+typedef struct {
+    uintptr_t timer_base;
+    const struct device *dma_dev;
+    uint32_t dma_channel;
+    uint32_t dma_slot;
+    // Inverted signal, the ESC replies with its eRPM after every frame. Needs
+    // CONFIG_ESC_DSHOT_BIDIR and has to be the same for all channels of the
+    // timer.
+    bool bidirectional;
+} ESC_Dshot_Config_Type;
+
+// Bidirectional DShot telemetry, counters only ever increase
+typedef struct {
+    uint32_t erpm;              // Electrical RPM of the last valid reply
+    uint32_t rpm;               // Mechanical RPM, see ESC_MOTOR_POLE_COUNT
+    uint32_t replies;           // Replies decoded successfully
+    uint32_t errors;            // Replies with invalid GCR symbols or checksum
+    uint32_t timeouts;          // Replies missing or cut short
+    uint32_t decode_cycles;     // CPU cycles spent decoding the last reply
+    uint32_t decode_cycles_max; // Highest decode cost seen
+} ESC_Dshot_Telemetry_Type;
+
 typedef struct {
     const struct device *pwm_dev;
     uint32_t pwm_channel;
     uint32_t period_us;
     float min_pulse_duration_us;
     float max_pulse_duration_us;
+    uint32_t arm_pulse_duration_us;
     ESC_Protocol_Type protocol;
     bool initialized;
+
+    // DShot only, compare values of the frame being sent
+    ESC_Dshot_Config_Type dshot;
+    uintptr_t dshot_ccr_addr;
+    uint16_t dshot_bit0_ticks;
+    uint16_t dshot_bit1_ticks;
+    uint16_t dshot_buffer[ESC_DSHOT_BUFFER_LEN];
+
+    // Bidirectional DShot only, edge timestamps of the last reply
+    uint16_t dshot_capture[ESC_DSHOT_CAPTURE_LEN];
+    uint16_t dshot_reply_bit_ticks_q4;
+    uint8_t dshot_capture_count;
+    bool dshot_capture_pending;
+    ESC_Dshot_Telemetry_Type dshot_telemetry;
 } ESC_Inst_Type;
 
 /**
@@ -66,17 +156,85 @@ ESC_Error_Type ESC_Init(ESC_Inst_Type *esc_out, const struct device *pwm_dev,
                         const uint32_t pwm_channel,
                         const ESC_Protocol_Type protocol);
 
+/**
+ * @brief ESC Initialization function for the DShot protocols
+ * @param[in] pwm_dev     Pointer to the device struct - pwm device
+ * @param[in] pwm_channel PWM channel which will be used by ESC device
+ * @param[in] protocol    ESC Protocol, one of the DShot protocols
+ * @param[in] dshot_cfg   Timer and DMA used to stream the frames
+ * @param[out] esc_out    Pointer to the ESC out struct, it needs to be passed
+ *                        to the ESC_SetSpeed function
+ *
+ * @note The timer period is set to one DShot bit, so every other channel of
+ * the same timer has to use the same DShot protocol. The timer has to run at
+ * least at 8 times the DShot bitrate. With bidirectional DShot the channels
+ * of a timer switch to input capture together, once all of their frames are
+ * sent.
+ *
+ * @retval ESC_SUCCESS - Operation finished successfully
+ * @retval ESC_DEVICE_PWM_NOT_READY - PWM device is not initialized correctly
+ * @retval ESC_DEVICE_DMA_NOT_READY - DMA device is not initialized correctly
+ * @retval ESC_INVALID_PROTOCOL - Protocol is not DShot or DShot is disabled
+ * @retval ESC_INVALID_TIMER_CLOCK - Timer clock is too slow for the bitrate
+ * @retval ESC_NOT_INITIALIZED - Timer or DMA configuration failed
+ */
+ESC_Error_Type ESC_InitDshot(ESC_Inst_Type *esc_out,
+                             const struct device *pwm_dev,
+                             const uint32_t pwm_channel,
+                             const ESC_Protocol_Type protocol,
+                             const ESC_Dshot_Config_Type *dshot_cfg);
+
 /**
  * @brief ESC Set Speed by percentage from 0 to 1
  * @param[in] esc   Pointer to the preinitialized ESC out struct from ESC_Init
  * @param[in] speed ESC speed value [0.0f,1.0f]
  *
+ * @note With DShot every call sends a single frame, so it has to be called
+ * periodically or the ESC will disarm. A speed of zero sends the motor stop
+ * command.
+ *
  * @retval ESC_SUCCESS - Operation finished successfully
  * @retval ESC_INVALID_SPEED_SET - Speed is out of valid range [0-100]
  * @retval ESC_TIMER_OVERFLOW_ERROR - Timer value is overflowed, check prescaler
+ * @retval ESC_DSHOT_BUSY - Previous DShot frame is still being sent
+ * @retval ESC_NOT_INITIALIZED - Specified esc is not initialized correctly
+ */
+ESC_Error_Type ESC_SetSpeed(ESC_Inst_Type *esc, const float speed);
+
+/**
+ * @brief ESC Send DShot command
+ * @param[in] esc     Pointer to the preinitialized ESC out struct from
+ *                    ESC_InitDshot
+ * @param[in] command DShot command
+ *
+ * @note Commands are only accepted by the ESC while the motor is stopped.
+ * Commands which change settings are repeated as the ESC requires, so this
+ * function blocks for up to a few milliseconds.
+ *
+ * @retval ESC_SUCCESS - Operation finished successfully
+ * @retval ESC_INVALID_PROTOCOL - ESC does not use a DShot protocol
+ * @retval ESC_INVALID_COMMAND - Command value is out of range
+ * @retval ESC_DSHOT_BUSY - Previous frame is still being sent
+ * @retval ESC_NOT_INITIALIZED - Specified esc is not initialized correctly
+ */
+ESC_Error_Type ESC_SendCommand(ESC_Inst_Type *esc,
+                               const ESC_Dshot_Command_Type command);
+
+/**
+ * @brief ESC Get bidirectional DShot telemetry
+ * @param[in] esc        Pointer to the preinitialized ESC out struct from
+ *                       ESC_InitDshot, with bidirectional DShot enabled
+ * @param[out] telemetry Latest RPM and reply counters
+ *
+ * @note The reply to a frame is decoded when the next frame is sent, so the
+ * RPM lags one ESC_SetSpeed call behind.
+ *
+ * @retval ESC_SUCCESS - Operation finished successfully
+ * @retval ESC_INVALID_PROTOCOL - ESC does not use bidirectional DShot
  * @retval ESC_NOT_INITIALIZED - Specified esc is not initialized correctly
  */
-ESC_Error_Type ESC_SetSpeed(const ESC_Inst_Type *esc, const float speed);
+ESC_Error_Type ESC_GetTelemetry(const ESC_Inst_Type *esc,
+                                ESC_Dshot_Telemetry_Type *telemetry);
 
 /**
  * @brief ESC Stop - Stop ESC signal
@@ -86,7 +244,7 @@ ESC_Error_Type ESC_SetSpeed(const ESC_Inst_Type *esc, const float speed);
  * @retval ESC_NOT_INITIALIZED - Specified esc is not initialized correctly
  * @retval ESC_INVALID_STOP - Error in ESC stop command
  */
-ESC_Error_Type ESC_Stop(const ESC_Inst_Type *esc);
+ESC_Error_Type ESC_Stop(ESC_Inst_Type *esc);
 
 /**
  * @brief ESC Deinitialize device
@@ -102,13 +260,13 @@ ESC_Error_Type ESC_DeInit(ESC_Inst_Type *esc);
  * @param[in] esc Pointer to the preinitialized ESC out struct from ESC_Init
  *
  * @note This function blocks the thread it is called in because of use of
- * k_msleep!
+ * k_msleep! ESC_GroupArmStart arms all ESCs of a group in the background.
  *
  * @retval ESC_SUCCESS - Operation finished successfully
  * @retval ESC_INVALID_PROTOCOL - Specified ESC protocol is not valid
  * @retval ESC_NOT_INITIALIZED - Specified esc is not initialized correctly
  * @retval ESC_INVALID_ARMING - Error in arming procedure
  */
-ESC_Error_Type ESC_Arm(const ESC_Inst_Type *esc);
+ESC_Error_Type ESC_Arm(ESC_Inst_Type *esc);
 
 #endif
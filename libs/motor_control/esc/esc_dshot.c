@@ -0,0 +1,612 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "esc_dshot.h"
+
+#include <stm32_ll_tim.h>
+#include <zephyr/drivers/dma.h>
+#include <zephyr/drivers/pwm.h>
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+
+// DShot bitrates [bit/s]
+#define ESC_DSHOT150_BITRATE 150000
+#define ESC_DSHOT300_BITRATE 300000
+#define ESC_DSHOT600_BITRATE 600000
+
+// Below this many timer ticks per bit, the high times can not be told apart
+// reliably by the ESC
+#define ESC_DSHOT_MIN_BIT_TICKS 8
+
+#define ESC_DSHOT_TIMER_CHANNEL_COUNT 4
+
+#ifdef CONFIG_ESC_DSHOT_BIDIR
+// Timers with bidirectional channels that can be in use at once
+#define ESC_DSHOT_MAX_TIMERS 4
+
+// Timer period while capturing, so the edge timestamps do not wrap within a
+// reply. The timers are 16 bit or wider.
+#define ESC_DSHOT_CAPTURE_PERIOD 0xFFFF
+
+// Replies are sent at 5/4 of the frame bitrate
+#define ESC_DSHOT_REPLY_RATE_NUM 5
+#define ESC_DSHOT_REPLY_RATE_DEN 4
+
+// GCR runs are at most three bits long, as no symbol holds more than two
+// zeros in a row
+#define ESC_DSHOT_MAX_RUN_BITS 3
+
+#define ESC_DSHOT_GCR_INVALID 0xFF
+
+#define ESC_DSHOT_ERPM_ZERO 0x0FFF
+#define ESC_DSHOT_US_PER_MINUTE 60000000
+
+typedef enum {
+    ESC_DSHOT_REPLY_VALID = 0,
+    ESC_DSHOT_REPLY_MISSING,
+    ESC_DSHOT_REPLY_INVALID,
+} ESC_Dshot_Reply_Type;
+
+// Channels of one timer switch between output and input capture together,
+// since the timer period changes for both
+typedef struct {
+    TIM_TypeDef *timer;
+    uint32_t period_ticks;
+    ESC_Inst_Type *escs[ESC_DSHOT_TIMER_CHANNEL_COUNT];
+    uint8_t sending_mask;
+    bool capturing;
+} ESC_Dshot_Timer_Type;
+
+static ESC_Dshot_Timer_Type dshot_timers[ESC_DSHOT_MAX_TIMERS];
+static struct k_spinlock dshot_lock;
+
+// 5 bit GCR symbol to nibble
+static const uint8_t gcr_decode[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x09, 0x0A,
+    0x0B, 0xFF, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0x02, 0x03, 0xFF, 0x05,
+    0x06, 0x07, 0xFF, 0x00, 0x08, 0x01, 0xFF, 0x04, 0x0C, 0xFF,
+};
+
+static ESC_Dshot_Timer_Type *RegisterChannel(ESC_Inst_Type *esc,
+                                             uint32_t period_ticks);
+static ESC_Dshot_Timer_Type *GetTimer(const ESC_Inst_Type *esc);
+static void StartCapture(ESC_Dshot_Timer_Type *t);
+static void StartOutput(ESC_Dshot_Timer_Type *t);
+static void DecodeReply(ESC_Inst_Type *esc);
+static ESC_Dshot_Reply_Type DecodeGcr(const ESC_Inst_Type *esc,
+                                      uint32_t *erpm);
+static void TxDoneCallback(const struct device *dev, void *user_data,
+                           uint32_t channel, int status);
+#endif
+
+static uint32_t GetBitrate(ESC_Protocol_Type protocol);
+static int ConfigureTxDma(ESC_Inst_Type *esc);
+
+ESC_Error_Type ESC_DshotInit(ESC_Inst_Type *esc,
+                             const ESC_Dshot_Config_Type *cfg) {
+    if (!device_is_ready(cfg->dma_dev)) {
+        return ESC_DEVICE_DMA_NOT_READY;
+    }
+
+    if (esc->pwm_channel == 0 ||
+        esc->pwm_channel > ESC_DSHOT_TIMER_CHANNEL_COUNT) {
+        return ESC_NOT_INITIALIZED;
+    }
+
+#ifndef CONFIG_ESC_DSHOT_BIDIR
+    if (cfg->bidirectional) {
+        return ESC_INVALID_PROTOCOL;
+    }
+#endif
+
+    const uint32_t bit_ticks =
+        ESC_DshotGetBitTicks(esc->pwm_dev, esc->pwm_channel, esc->protocol);
+    if (bit_ticks == 0) {
+        return ESC_INVALID_TIMER_CLOCK;
+    }
+
+    esc->dshot = *cfg;
+    esc->dshot_bit1_ticks = bit_ticks * ESC_DSHOT_BIT1_HIGH_EIGHTHS / 8;
+    esc->dshot_bit0_ticks = bit_ticks * ESC_DSHOT_BIT0_HIGH_EIGHTHS / 8;
+
+    // Trailing entries are never written again and return the line to idle
+    for (int i = 0; i < ESC_DSHOT_BUFFER_LEN; i++) {
+        esc->dshot_buffer[i] = 0;
+    }
+
+    // One timer period is one bit, the bits are shaped by streaming compare
+    // values into the channel. Bidirectional DShot idles high.
+    const pwm_flags_t flags = cfg->bidirectional ? PWM_POLARITY_INVERTED : 0;
+    if (pwm_set_cycles(esc->pwm_dev, esc->pwm_channel, bit_ticks, 0, flags)) {
+        return ESC_NOT_INITIALIZED;
+    }
+
+    TIM_TypeDef *timer = (TIM_TypeDef *)cfg->timer_base;
+    const uint32_t channel_idx = esc->pwm_channel - 1;
+
+    esc->dshot_ccr_addr = (uintptr_t)(&timer->CCR1 + channel_idx);
+
+#ifdef CONFIG_ESC_DSHOT_BIDIR
+    if (cfg->bidirectional) {
+        esc->dshot_reply_bit_ticks_q4 = bit_ticks * 16 *
+                                        ESC_DSHOT_REPLY_RATE_DEN /
+                                        ESC_DSHOT_REPLY_RATE_NUM;
+        esc->dshot_capture_count = 0;
+        esc->dshot_capture_pending = false;
+        esc->dshot_telemetry = (ESC_Dshot_Telemetry_Type){0};
+
+        if (RegisterChannel(esc, bit_ticks) == NULL) {
+            return ESC_NOT_INITIALIZED;
+        }
+
+        // Compare values are requested on the compare event, the only DMA
+        // request that input capture also raises. They are latched through
+        // the compare preload on the next update, so the value has to arrive
+        // within the low part of the bit.
+        LL_TIM_CC_SetDMAReqTrigger(timer, LL_TIM_CCDMAREQUEST_CC);
+    } else
+#endif
+    {
+        // Compare values are requested on the update event and latched
+        // through the compare preload on the following one, so every bit gets
+        // exactly one full period regardless of DMA latency
+        LL_TIM_CC_SetDMAReqTrigger(timer, LL_TIM_CCDMAREQUEST_UPDATE);
+    }
+
+    SET_BIT(timer->DIER, TIM_DIER_CC1DE << channel_idx);
+
+    if (ConfigureTxDma(esc)) {
+        return ESC_NOT_INITIALIZED;
+    }
+
+    return ESC_SUCCESS;
+}
+
+ESC_Error_Type ESC_DshotWrite(ESC_Inst_Type *esc, const uint16_t value,
+                              const bool telemetry) {
+#ifdef CONFIG_ESC_DSHOT_BIDIR
+    if (esc->dshot.bidirectional) {
+        ESC_Dshot_Timer_Type *t = GetTimer(esc);
+        const uint8_t channel_bit = BIT(esc->pwm_channel - 1);
+
+        k_spinlock_key_t key = k_spin_lock(&dshot_lock);
+
+        if (t->sending_mask & channel_bit) {
+            k_spin_unlock(&dshot_lock, key);
+            return ESC_DSHOT_BUSY;
+        }
+
+        // Whichever channel is written first ends the capture of the whole
+        // timer, replies still on the way are counted as timeouts
+        if (t->capturing) {
+            StartOutput(t);
+        }
+
+        k_spin_unlock(&dshot_lock, key);
+
+        if (esc->dshot_capture_pending) {
+            DecodeReply(esc);
+        }
+    } else
+#endif
+    {
+        struct dma_status status;
+        if (dma_get_status(esc->dshot.dma_dev, esc->dshot.dma_channel,
+                           &status) == 0 &&
+            status.busy) {
+            return ESC_DSHOT_BUSY;
+        }
+    }
+
+    uint16_t packet =
+        ESC_DshotEncode(value, telemetry, esc->dshot.bidirectional);
+
+    // Most significant bit is sent first
+    for (int bit = 0; bit < ESC_DSHOT_FRAME_BITS; bit++) {
+        esc->dshot_buffer[bit] = (packet & 0x8000) ? esc->dshot_bit1_ticks
+                                                   : esc->dshot_bit0_ticks;
+        packet <<= 1;
+    }
+
+#ifdef CONFIG_ESC_DSHOT_BIDIR
+    if (esc->dshot.bidirectional) {
+        ESC_Dshot_Timer_Type *t = GetTimer(esc);
+
+        k_spinlock_key_t key = k_spin_lock(&dshot_lock);
+        t->sending_mask |= BIT(esc->pwm_channel - 1);
+        k_spin_unlock(&dshot_lock, key);
+    }
+#endif
+
+    if (dma_reload(esc->dshot.dma_dev, esc->dshot.dma_channel,
+                   (uint32_t)(uintptr_t)esc->dshot_buffer, esc->dshot_ccr_addr,
+                   sizeof(esc->dshot_buffer))) {
+        return ESC_NOT_INITIALIZED;
+    }
+
+    if (dma_start(esc->dshot.dma_dev, esc->dshot.dma_channel)) {
+        return ESC_NOT_INITIALIZED;
+    }
+
+    return ESC_SUCCESS;
+}
+
+ESC_Error_Type ESC_DshotStop(ESC_Inst_Type *esc) {
+    const int ret = dma_stop(esc->dshot.dma_dev, esc->dshot.dma_channel);
+
+#ifdef CONFIG_ESC_DSHOT_BIDIR
+    if (esc->dshot.bidirectional) {
+        ESC_Dshot_Timer_Type *t = GetTimer(esc);
+
+        k_spinlock_key_t key = k_spin_lock(&dshot_lock);
+
+        if (t->capturing) {
+            StartOutput(t);
+        }
+
+        t->sending_mask &= ~BIT(esc->pwm_channel - 1);
+
+        k_spin_unlock(&dshot_lock, key);
+    }
+#endif
+
+    // The output is held low either way, but the DMA may still be streaming
+    // the rest of the frame into it
+    *(volatile uint32_t *)esc->dshot_ccr_addr = 0;
+
+    if (ret) {
+        return ESC_INVALID_STOP;
+    }
+
+    return ESC_SUCCESS;
+}
+
+uint32_t ESC_DshotGetBitTicks(const struct device *pwm_dev,
+                              const uint32_t pwm_channel,
+                              const ESC_Protocol_Type protocol) {
+    uint64_t cycles_per_sec;
+    if (pwm_get_cycles_per_sec(pwm_dev, pwm_channel, &cycles_per_sec)) {
+        return 0;
+    }
+
+    const uint64_t bit_ticks = cycles_per_sec / GetBitrate(protocol);
+    if (bit_ticks < ESC_DSHOT_MIN_BIT_TICKS || bit_ticks > UINT16_MAX) {
+        return 0;
+    }
+
+    return bit_ticks;
+}
+
+uint16_t ESC_DshotEncode(const uint16_t value, const bool telemetry,
+                         const bool inverted) {
+    const uint16_t data = (value << 1) | (telemetry ? 1 : 0);
+
+    // Checksum is the XOR of the three data nibbles, inverted to tell the ESC
+    // that a reply is expected
+    uint16_t crc = data ^ (data >> 4) ^ (data >> 8);
+    if (inverted) {
+        crc = ~crc;
+    }
+
+    return (data << 4) | (crc & 0x0F);
+}
+
+static int ConfigureTxDma(ESC_Inst_Type *esc) {
+    struct dma_block_config block = {
+        .source_address = (uint32_t)(uintptr_t)esc->dshot_buffer,
+        .dest_address = esc->dshot_ccr_addr,
+        .block_size = sizeof(esc->dshot_buffer),
+        .source_addr_adj = DMA_ADDR_ADJ_INCREMENT,
+        .dest_addr_adj = DMA_ADDR_ADJ_NO_CHANGE,
+    };
+
+    struct dma_config dma_cfg = {
+        .dma_slot = esc->dshot.dma_slot,
+        .channel_direction = MEMORY_TO_PERIPHERAL,
+        .source_data_size = sizeof(esc->dshot_buffer[0]),
+        .dest_data_size = sizeof(esc->dshot_buffer[0]),
+        .source_burst_length = 1,
+        .dest_burst_length = 1,
+        .block_count = 1,
+        .head_block = &block,
+    };
+
+#ifdef CONFIG_ESC_DSHOT_BIDIR
+    if (esc->dshot.bidirectional) {
+        dma_cfg.dma_callback = TxDoneCallback;
+        dma_cfg.user_data = esc;
+    }
+#endif
+
+    return dma_config(esc->dshot.dma_dev, esc->dshot.dma_channel, &dma_cfg);
+}
+
+static uint32_t GetBitrate(const ESC_Protocol_Type protocol) {
+    switch (protocol) {
+    case ESC_DSHOT150:
+        return ESC_DSHOT150_BITRATE;
+    case ESC_DSHOT300:
+        return ESC_DSHOT300_BITRATE;
+    case ESC_DSHOT600:
+    default:
+        return ESC_DSHOT600_BITRATE;
+    }
+}
+
+#ifdef CONFIG_ESC_DSHOT_BIDIR
+static ESC_Dshot_Timer_Type *RegisterChannel(ESC_Inst_Type *esc,
+                                             const uint32_t period_ticks) {
+    TIM_TypeDef *timer = (TIM_TypeDef *)esc->dshot.timer_base;
+    ESC_Dshot_Timer_Type *free_slot = NULL;
+
+    for (int i = 0; i < ESC_DSHOT_MAX_TIMERS; i++) {
+        if (dshot_timers[i].timer == timer) {
+            dshot_timers[i].escs[esc->pwm_channel - 1] = esc;
+            return &dshot_timers[i];
+        }
+
+        if (dshot_timers[i].timer == NULL && free_slot == NULL) {
+            free_slot = &dshot_timers[i];
+        }
+    }
+
+    if (free_slot != NULL) {
+        free_slot->timer = timer;
+        free_slot->period_ticks = period_ticks;
+        free_slot->escs[esc->pwm_channel - 1] = esc;
+    }
+
+    return free_slot;
+}
+
+static ESC_Dshot_Timer_Type *GetTimer(const ESC_Inst_Type *esc) {
+    TIM_TypeDef *timer = (TIM_TypeDef *)esc->dshot.timer_base;
+
+    for (int i = 0; i < ESC_DSHOT_MAX_TIMERS; i++) {
+        if (dshot_timers[i].timer == timer) {
+            return &dshot_timers[i];
+        }
+    }
+
+    // Registered on init, so this is never reached
+    return &dshot_timers[0];
+}
+
+static void StartCapture(ESC_Dshot_Timer_Type *t) {
+    // Takes effect on the next update, by which the last frame has ended
+    LL_TIM_SetAutoReload(t->timer, ESC_DSHOT_CAPTURE_PERIOD);
+
+    for (int i = 0; i < ESC_DSHOT_TIMER_CHANNEL_COUNT; i++) {
+        ESC_Inst_Type *esc = t->escs[i];
+        if (esc == NULL) {
+            continue;
+        }
+
+        const uint32_t channel = LL_TIM_CHANNEL_CH1 << (4 * i);
+
+        // No request may reach the DMA before it is set up for the capture
+        CLEAR_BIT(t->timer->DIER, TIM_DIER_CC1DE << i);
+        LL_TIM_CC_DisableChannel(t->timer, channel);
+
+        LL_TIM_IC_SetActiveInput(t->timer, channel,
+                                 LL_TIM_ACTIVEINPUT_DIRECTTI);
+        LL_TIM_IC_SetPrescaler(t->timer, channel, LL_TIM_ICPSC_DIV1);
+        LL_TIM_IC_SetPolarity(t->timer, channel, LL_TIM_IC_POLARITY_BOTHEDGE);
+
+        struct dma_block_config block = {
+            .source_address = esc->dshot_ccr_addr,
+            .dest_address = (uint32_t)(uintptr_t)esc->dshot_capture,
+            .block_size = sizeof(esc->dshot_capture),
+            .source_addr_adj = DMA_ADDR_ADJ_NO_CHANGE,
+            .dest_addr_adj = DMA_ADDR_ADJ_INCREMENT,
+        };
+
+        struct dma_config dma_cfg = {
+            .dma_slot = esc->dshot.dma_slot,
+            .channel_direction = PERIPHERAL_TO_MEMORY,
+            .source_data_size = sizeof(esc->dshot_capture[0]),
+            .dest_data_size = sizeof(esc->dshot_capture[0]),
+            .source_burst_length = 1,
+            .dest_burst_length = 1,
+            .block_count = 1,
+            .head_block = &block,
+        };
+
+        if (dma_config(esc->dshot.dma_dev, esc->dshot.dma_channel,
+                       &dma_cfg) == 0) {
+            dma_start(esc->dshot.dma_dev, esc->dshot.dma_channel);
+        }
+
+        CLEAR_BIT(t->timer->SR, TIM_SR_CC1IF << i);
+        SET_BIT(t->timer->DIER, TIM_DIER_CC1DE << i);
+        LL_TIM_CC_EnableChannel(t->timer, channel);
+    }
+
+    t->capturing = true;
+}
+
+static void StartOutput(ESC_Dshot_Timer_Type *t) {
+    for (int i = 0; i < ESC_DSHOT_TIMER_CHANNEL_COUNT; i++) {
+        ESC_Inst_Type *esc = t->escs[i];
+        if (esc == NULL) {
+            continue;
+        }
+
+        const uint32_t channel = LL_TIM_CHANNEL_CH1 << (4 * i);
+
+        // The GPDMA reports the remaining length in bytes
+        struct dma_status status;
+        uint32_t captured = 0;
+        if (dma_get_status(esc->dshot.dma_dev, esc->dshot.dma_channel,
+                           &status) == 0) {
+            captured = (sizeof(esc->dshot_capture) - status.pending_length) /
+                       sizeof(esc->dshot_capture[0]);
+        }
+
+        dma_stop(esc->dshot.dma_dev, esc->dshot.dma_channel);
+
+        esc->dshot_capture_count = captured;
+        esc->dshot_capture_pending = true;
+
+        CLEAR_BIT(t->timer->DIER, TIM_DIER_CC1DE << i);
+        LL_TIM_CC_DisableChannel(t->timer, channel);
+
+        // Setting the output mode also selects the channel as output
+        LL_TIM_OC_SetMode(t->timer, channel, LL_TIM_OCMODE_PWM1);
+        LL_TIM_OC_EnablePreload(t->timer, channel);
+        LL_TIM_OC_SetPolarity(t->timer, channel, LL_TIM_OCPOLARITY_LOW);
+        *(volatile uint32_t *)esc->dshot_ccr_addr = 0;
+
+        ConfigureTxDma(esc);
+
+        SET_BIT(t->timer->DIER, TIM_DIER_CC1DE << i);
+        LL_TIM_CC_EnableChannel(t->timer, channel);
+    }
+
+    // Restarts the period right away, instead of after the long capture one
+    LL_TIM_SetAutoReload(t->timer, t->period_ticks);
+    LL_TIM_GenerateEvent_UPDATE(t->timer);
+
+    t->capturing = false;
+}
+
+static void TxDoneCallback(const struct device *dev, void *user_data,
+                           uint32_t channel, int status) {
+    ESC_Inst_Type *esc = user_data;
+    ESC_Dshot_Timer_Type *t = GetTimer(esc);
+
+    k_spinlock_key_t key = k_spin_lock(&dshot_lock);
+
+    t->sending_mask &= ~BIT(esc->pwm_channel - 1);
+
+    if (t->sending_mask == 0 && !t->capturing) {
+        StartCapture(t);
+    }
+
+    k_spin_unlock(&dshot_lock, key);
+}
+
+static void DecodeReply(ESC_Inst_Type *esc) {
+    ESC_Dshot_Telemetry_Type *telemetry = &esc->dshot_telemetry;
+    const uint32_t start_cycles = k_cycle_get_32();
+
+    uint32_t erpm;
+    switch (DecodeGcr(esc, &erpm)) {
+    case ESC_DSHOT_REPLY_VALID:
+        telemetry->erpm = erpm;
+        telemetry->rpm = erpm * 2 / CONFIG_ESC_MOTOR_POLE_COUNT;
+        telemetry->replies++;
+        break;
+
+    case ESC_DSHOT_REPLY_MISSING:
+        telemetry->timeouts++;
+        break;
+
+    case ESC_DSHOT_REPLY_INVALID:
+    default:
+        telemetry->errors++;
+        break;
+    }
+
+    esc->dshot_capture_pending = false;
+
+    telemetry->decode_cycles = k_cycle_get_32() - start_cycles;
+    if (telemetry->decode_cycles > telemetry->decode_cycles_max) {
+        telemetry->decode_cycles_max = telemetry->decode_cycles;
+    }
+}
+
+static ESC_Dshot_Reply_Type DecodeGcr(const ESC_Inst_Type *esc,
+                                      uint32_t *erpm) {
+    // The first edge is the start bit, without a second one nothing was sent
+    if (esc->dshot_capture_count < 2) {
+        return ESC_DSHOT_REPLY_MISSING;
+    }
+
+    // Every edge starts a run of equal bits, which after the NRZI decoding
+    // is a one followed by zeros
+    const uint32_t bit_ticks_q4 = esc->dshot_reply_bit_ticks_q4;
+    uint32_t gcr = 0;
+    uint32_t bits = 0;
+
+    for (int i = 1; i < esc->dshot_capture_count; i++) {
+        const uint16_t diff = esc->dshot_capture[i] - esc->dshot_capture[i - 1];
+        const uint32_t len = (diff * 16U + bit_ticks_q4 / 2) / bit_ticks_q4;
+
+        if (len == 0 || len > ESC_DSHOT_MAX_RUN_BITS) {
+            return ESC_DSHOT_REPLY_INVALID;
+        }
+
+        gcr = (gcr << len) | (1U << (len - 1));
+        bits += len;
+
+        // Remaining edges come from the line returning to idle
+        if (bits >= ESC_DSHOT_REPLY_BITS) {
+            break;
+        }
+    }
+
+    if (bits > ESC_DSHOT_REPLY_BITS) {
+        return ESC_DSHOT_REPLY_INVALID;
+    }
+
+    // The last run ends without an edge, when the reply is over. Anything
+    // longer than a run means the capture was cut short.
+    if (bits < ESC_DSHOT_REPLY_BITS) {
+        const uint32_t len = ESC_DSHOT_REPLY_BITS - bits;
+        if (len > ESC_DSHOT_MAX_RUN_BITS) {
+            return ESC_DSHOT_REPLY_MISSING;
+        }
+
+        gcr = (gcr << len) | (1U << (len - 1));
+    }
+
+    uint32_t value = 0;
+    for (int nibble = 3; nibble >= 0; nibble--) {
+        const uint8_t decoded = gcr_decode[(gcr >> (5 * nibble)) & 0x1F];
+        if (decoded == ESC_DSHOT_GCR_INVALID) {
+            return ESC_DSHOT_REPLY_INVALID;
+        }
+
+        value = (value << 4) | decoded;
+    }
+
+    // All four nibbles XOR to 0xF
+    uint32_t crc = value ^ (value >> 8);
+    crc ^= crc >> 4;
+    if ((crc & 0x0F) != 0x0F) {
+        return ESC_DSHOT_REPLY_INVALID;
+    }
+
+    // Period of one electrical revolution [us], as a 9 bit mantissa shifted
+    // by a 3 bit exponent
+    const uint32_t data = value >> 4;
+    if (data == ESC_DSHOT_ERPM_ZERO) {
+        *erpm = 0;
+        return ESC_DSHOT_REPLY_VALID;
+    }
+
+    const uint32_t period_us = (data & 0x1FF) << (data >> 9);
+    if (period_us == 0) {
+        return ESC_DSHOT_REPLY_INVALID;
+    }
+
+    *erpm = ESC_DSHOT_US_PER_MINUTE / period_us;
+
+    return ESC_DSHOT_REPLY_VALID;
+}
+#endif
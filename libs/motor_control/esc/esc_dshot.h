@@ -0,0 +1,93 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ESC_DSHOT_H
+#define ESC_DSHOT_H
+
+#include "esc.h"
+
+// Lowest and highest DShot throttle values, lower values are commands
+#define ESC_DSHOT_THROTTLE_MIN 48
+#define ESC_DSHOT_THROTTLE_MAX 2047
+
+// High time of a one and a zero bit, in eighths of the bit period
+#define ESC_DSHOT_BIT1_HIGH_EIGHTHS 6
+#define ESC_DSHOT_BIT0_HIGH_EIGHTHS 3
+
+static inline bool ESC_IsDshot(const ESC_Protocol_Type protocol) {
+    return protocol == ESC_DSHOT150 || protocol == ESC_DSHOT300 ||
+           protocol == ESC_DSHOT600;
+}
+
+/**
+ * @brief Configures the timer channel and DMA of a DShot output
+ * @param[in] esc ESC struct with the PWM device, channel and protocol set
+ * @param[in] cfg Timer and DMA used to stream the frames
+ *
+ * @retval ESC_SUCCESS - Operation finished successfully
+ * @retval ESC_DEVICE_DMA_NOT_READY - DMA device is not initialized correctly
+ * @retval ESC_INVALID_TIMER_CLOCK - Timer clock is too slow for the bitrate
+ * @retval ESC_NOT_INITIALIZED - Timer or DMA configuration failed
+ */
+ESC_Error_Type ESC_DshotInit(ESC_Inst_Type *esc,
+                             const ESC_Dshot_Config_Type *cfg);
+
+/**
+ * @brief Encodes and starts sending one DShot frame
+ * @param[in] esc       Pointer to the initialized ESC struct
+ * @param[in] value     Throttle or command value, 11 bits
+ * @param[in] telemetry Telemetry request bit
+ *
+ * @retval ESC_SUCCESS - Operation finished successfully
+ * @retval ESC_DSHOT_BUSY - Previous frame is still being sent
+ * @retval ESC_NOT_INITIALIZED - DMA could not be started
+ */
+ESC_Error_Type ESC_DshotWrite(ESC_Inst_Type *esc, uint16_t value,
+                              bool telemetry);
+
+/**
+ * @brief Computes the timer period of one DShot bit
+ * @param[in] pwm_dev     PWM device of the timer
+ * @param[in] pwm_channel Any channel of the timer
+ * @param[in] protocol    One of the DShot protocols
+ *
+ * @return Timer ticks per bit, zero if the timer clock is unsuitable
+ */
+uint32_t ESC_DshotGetBitTicks(const struct device *pwm_dev,
+                              uint32_t pwm_channel,
+                              ESC_Protocol_Type protocol);
+
+/**
+ * @brief Builds a DShot frame
+ * @param[in] value     Throttle or command value, 11 bits
+ * @param[in] telemetry Telemetry request bit
+ * @param[in] inverted  Inverted checksum, for bidirectional DShot
+ *
+ * @return 16 bit frame, sent most significant bit first
+ */
+uint16_t ESC_DshotEncode(uint16_t value, bool telemetry, bool inverted);
+
+/**
+ * @brief Aborts the frame in flight and holds the output low
+ * @param[in] esc Pointer to the initialized ESC struct
+ *
+ * @retval ESC_SUCCESS - Operation finished successfully
+ * @retval ESC_INVALID_STOP - DMA could not be stopped
+ */
+ESC_Error_Type ESC_DshotStop(ESC_Inst_Type *esc);
+
+#endif // ESC_DSHOT_H
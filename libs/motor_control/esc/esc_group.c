@@ -0,0 +1,646 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "esc_group.h"
+
+#include <stm32_ll_tim.h>
+#include <zephyr/drivers/dma.h>
+#include <zephyr/drivers/pwm.h>
+
+#ifdef CONFIG_ESC_DSHOT
+#include "esc_dshot.h"
+
+// Throttle steps of DShot, between ESC_DSHOT_THROTTLE_MIN and _MAX
+#define ESC_GROUP_DSHOT_STEPS                                                  \
+    (ESC_DSHOT_THROTTLE_MAX - ESC_DSHOT_THROTTLE_MIN + 1)
+#endif
+
+#define ESC_GROUP_THROTTLE_SHIFT 16
+#define ESC_GROUP_US_PER_SEC 1000000
+
+// Frame or pulse period while arming outputs which do not repeat on their
+// own [ms]
+#define ESC_GROUP_ARM_REFRESH_MS 1
+
+static ESC_Error_Type InitAnalog(ESC_Group_Type *group, TIM_TypeDef *timer);
+static ESC_Error_Type WriteAnalog(ESC_Group_Type *group,
+                                  const uint16_t *throttle);
+static ESC_Error_Type InitOnePulse(ESC_Group_Type *group, TIM_TypeDef *timer);
+static ESC_Error_Type WriteOnePulse(ESC_Group_Type *group,
+                                    const uint16_t *throttle);
+static void LoadOnePulse(ESC_Group_Type *group, const uint32_t *width_ticks);
+static ESC_Error_Type StartOnePulse(ESC_Group_Type *group,
+                                    const uint32_t *width_ticks);
+static ESC_Error_Type WriteArming(ESC_Group_Type *group,
+                                  const uint16_t *throttle);
+static void ArmTimerHandler(struct k_timer *timer);
+static void FinishArming(ESC_Group_Type *group, ESC_Arm_State_Type state);
+
+#ifdef CONFIG_ESC_DSHOT
+static ESC_Error_Type InitDshot(ESC_Group_Type *group, TIM_TypeDef *timer);
+static ESC_Error_Type WriteDshot(ESC_Group_Type *group,
+                                 const uint16_t *throttle);
+static ESC_Error_Type SendDshotStop(ESC_Group_Type *group);
+static bool IsDshotBusy(const ESC_Group_Type *group);
+static void EncodeDshot(ESC_Group_Type *group, uint8_t index, uint16_t value);
+static ESC_Error_Type StartDshot(ESC_Group_Type *group);
+#endif
+
+ESC_Error_Type ESC_GroupInit(ESC_Group_Type *group,
+                             const ESC_Group_Config_Type *cfg) {
+    group->initialized = false;
+
+    if (!device_is_ready(cfg->pwm_dev))
+        return ESC_DEVICE_PWM_NOT_READY;
+
+    if (cfg->channel_count == 0 || cfg->channel_count > ESC_GROUP_MAX_CHANNELS)
+        return ESC_INVALID_CHANNELS;
+
+    // The DMA burst writes consecutive compare registers
+    for (int i = 0; i < cfg->channel_count; i++) {
+        if (cfg->channels[i] != cfg->channels[0] + i || cfg->channels[i] == 0 ||
+            cfg->channels[i] > ESC_GROUP_MAX_CHANNELS)
+            return ESC_INVALID_CHANNELS;
+    }
+
+    group->pwm_dev = cfg->pwm_dev;
+    group->channel_count = cfg->channel_count;
+    group->protocol = cfg->protocol;
+    group->timer = cfg->timer;
+    group->one_pulse = cfg->one_pulse;
+
+    for (int i = 0; i < cfg->channel_count; i++) {
+        group->channels[i] = cfg->channels[i];
+    }
+
+    TIM_TypeDef *timer = (TIM_TypeDef *)cfg->timer.timer_base;
+    ESC_Error_Type status;
+
+    switch (cfg->protocol) {
+    case ESC_PWM:
+        // Standard PWM pulses are too long to be sent on every update
+        if (cfg->one_pulse)
+            return ESC_INVALID_PROTOCOL;
+
+        status = InitAnalog(group, timer);
+        group->output_write = WriteAnalog;
+        break;
+
+    case ESC_ONESHOT_125:
+    case ESC_ONESHOT_42:
+    case ESC_MULTISHOT:
+        if (cfg->one_pulse) {
+            status = InitOnePulse(group, timer);
+            group->output_write = WriteOnePulse;
+        } else {
+            status = InitAnalog(group, timer);
+            group->output_write = WriteAnalog;
+        }
+        break;
+
+#ifdef CONFIG_ESC_DSHOT
+    case ESC_DSHOT150:
+    case ESC_DSHOT300:
+    case ESC_DSHOT600:
+        if (cfg->one_pulse)
+            return ESC_INVALID_PROTOCOL;
+
+        status = InitDshot(group, timer);
+        group->output_write = WriteDshot;
+        break;
+#endif
+
+    default:
+        return ESC_INVALID_PROTOCOL;
+    }
+
+    if (status != ESC_SUCCESS)
+        return status;
+
+    group->write = group->output_write;
+    group->arm_state = ESC_ARM_IDLE;
+    k_timer_init(&group->arm_timer, ArmTimerHandler, NULL);
+
+    group->initialized = true;
+
+    return ESC_SUCCESS;
+}
+
+ESC_Error_Type ESC_GroupWriteSync(ESC_Group_Type *const *groups,
+                                  const uint16_t *const *throttle,
+                                  const uint8_t count) {
+    for (int g = 0; g < count; g++) {
+        const ESC_Group_Type *group = groups[g];
+
+        if (!group->initialized)
+            return ESC_NOT_INITIALIZED;
+
+        if (group->output_write != WriteOnePulse)
+            return ESC_INVALID_PROTOCOL;
+
+        if (group->write == WriteArming)
+            return ESC_ARMING_IN_PROGRESS;
+
+        if (LL_TIM_IsEnabledCounter((TIM_TypeDef *)group->timer.timer_base))
+            return ESC_PULSE_BUSY;
+    }
+
+    for (int g = 0; g < count; g++) {
+        ESC_Group_Type *group = groups[g];
+        uint32_t width_ticks[ESC_GROUP_MAX_CHANNELS];
+
+        for (int i = 0; i < group->channel_count; i++) {
+            width_ticks[i] = group->min_ticks[i] +
+                             ((throttle[g][i] * group->range_ticks[i]) >>
+                              ESC_GROUP_THROTTLE_SHIFT);
+        }
+
+        LoadOnePulse(group, width_ticks);
+    }
+
+    const unsigned int key = irq_lock();
+
+    for (int g = 0; g < count; g++) {
+        LL_TIM_EnableCounter((TIM_TypeDef *)groups[g]->timer.timer_base);
+    }
+
+    irq_unlock(key);
+
+    return ESC_SUCCESS;
+}
+
+ESC_Error_Type ESC_GroupArmStart(ESC_Group_Type *group,
+                                 ESC_Arm_Callback_Type callback,
+                                 void *user_data) {
+    if (!group->initialized) {
+        return ESC_NOT_INITIALIZED;
+    }
+
+    if (group->arm_state == ESC_ARM_ARMING) {
+        return ESC_ARMING_IN_PROGRESS;
+    }
+
+    group->arm_callback = callback;
+    group->arm_user_data = user_data;
+    group->arm_elapsed_ms = 0;
+    group->arm_state = ESC_ARM_ARMING;
+    group->write = WriteArming;
+
+#ifdef CONFIG_ESC_DSHOT
+    // DShot ESCs arm after receiving zero throttle frames for a while
+    if (group->output_write == WriteDshot) {
+        // A frame still in flight is fine, the arm timer sends the next one
+        const ESC_Error_Type status = SendDshotStop(group);
+        if (status != ESC_SUCCESS && status != ESC_DSHOT_BUSY) {
+            FinishArming(group, ESC_ARM_FAILED);
+            return ESC_INVALID_ARMING;
+        }
+
+        group->arm_period_ms = ESC_GROUP_ARM_REFRESH_MS;
+        k_timer_start(&group->arm_timer, K_MSEC(group->arm_period_ms),
+                      K_MSEC(group->arm_period_ms));
+
+        return ESC_SUCCESS;
+    }
+#endif
+
+    if (group->output_write == WriteOnePulse) {
+        // Pulses are only sent when triggered, so they are repeated by the
+        // arming timer
+        StartOnePulse(group, group->arm_ticks);
+
+        group->arm_period_ms = ESC_GROUP_ARM_REFRESH_MS;
+        k_timer_start(&group->arm_timer, K_MSEC(group->arm_period_ms),
+                      K_MSEC(group->arm_period_ms));
+
+        return ESC_SUCCESS;
+    }
+
+    // Analog ESCs only need the arming pulse held, which the timer repeats
+    // on its own
+    TIM_TypeDef *timer = (TIM_TypeDef *)group->timer.timer_base;
+
+    SET_BIT(timer->CR1, TIM_CR1_UDIS);
+
+    for (int i = 0; i < group->channel_count; i++) {
+        *group->ccr[i] = group->arm_ticks[i];
+    }
+
+    CLEAR_BIT(timer->CR1, TIM_CR1_UDIS);
+
+    group->arm_period_ms = ESC_GROUP_ARM_PROGRESS_MS;
+    k_timer_start(&group->arm_timer, K_MSEC(group->arm_period_ms),
+                  K_MSEC(group->arm_period_ms));
+
+    return ESC_SUCCESS;
+}
+
+ESC_Error_Type ESC_GroupArmCancel(ESC_Group_Type *group) {
+    if (!group->initialized) {
+        return ESC_NOT_INITIALIZED;
+    }
+
+    k_timer_stop(&group->arm_timer);
+
+    // Arming may have finished just before the timer was stopped
+    if (group->arm_state != ESC_ARM_ARMING) {
+        return ESC_SUCCESS;
+    }
+
+    FinishArming(group, ESC_ARM_CANCELLED);
+
+    return ESC_GroupStop(group);
+}
+
+ESC_Error_Type ESC_GroupStop(ESC_Group_Type *group) {
+    if (!group->initialized) {
+        return ESC_NOT_INITIALIZED;
+    }
+
+    if (group->output_write == WriteAnalog) {
+        TIM_TypeDef *timer = (TIM_TypeDef *)group->timer.timer_base;
+
+        // A zero pulse keeps the channels enabled, so arming again or the
+        // next write only have to set the compare values
+        SET_BIT(timer->CR1, TIM_CR1_UDIS);
+
+        for (int i = 0; i < group->channel_count; i++) {
+            *group->ccr[i] = 0;
+        }
+
+        CLEAR_BIT(timer->CR1, TIM_CR1_UDIS);
+
+        return ESC_SUCCESS;
+    }
+
+    if (group->output_write == WriteOnePulse) {
+        TIM_TypeDef *timer = (TIM_TypeDef *)group->timer.timer_base;
+
+        // Compare values past the end of the pulse keep the outputs inactive,
+        // the update event clears a counter stopped in the middle of a pulse
+        LL_TIM_DisableCounter(timer);
+
+        for (int i = 0; i < group->channel_count; i++) {
+            *group->ccr[i] = group->pulse_end_ticks + 1;
+        }
+
+        LL_TIM_GenerateEvent_UPDATE(timer);
+
+        return ESC_SUCCESS;
+    }
+
+#ifdef CONFIG_ESC_DSHOT
+    TIM_TypeDef *timer = (TIM_TypeDef *)group->timer.timer_base;
+
+    dma_stop(group->timer.dma_dev, group->timer.dma_channel);
+
+    // The timer keeps running so the next frame can be sent right away
+    for (int i = 0; i < group->channel_count; i++) {
+        *(&timer->CCR1 + group->channels[i] - 1) = 0;
+    }
+#endif
+
+    return ESC_SUCCESS;
+}
+
+static ESC_Error_Type InitAnalog(ESC_Group_Type *group, TIM_TypeDef *timer) {
+    uint64_t cycles_per_sec;
+    if (pwm_get_cycles_per_sec(group->pwm_dev, group->channels[0],
+                               &cycles_per_sec)) {
+        return ESC_INVALID_TIMER_CLOCK;
+    }
+
+    for (int i = 0; i < group->channel_count; i++) {
+        // Pulse limits come from the single channel setup, including the
+        // configured offsets
+        ESC_Inst_Type esc;
+        ESC_Error_Type status = ESC_Init(&esc, group->pwm_dev,
+                                         group->channels[i], group->protocol);
+        if (status != ESC_SUCCESS)
+            return status;
+
+        const uint64_t min_ticks =
+            (uint64_t)(esc.min_pulse_duration_us * cycles_per_sec) /
+            ESC_GROUP_US_PER_SEC;
+        const uint64_t max_ticks =
+            (uint64_t)(esc.max_pulse_duration_us * cycles_per_sec) /
+            ESC_GROUP_US_PER_SEC;
+
+        // Compare registers are 16 bit on most timers
+        if (max_ticks > UINT16_MAX)
+            return ESC_TIMER_OVERFLOW_ERROR;
+
+        group->arm_ticks[i] = (uint64_t)esc.arm_pulse_duration_us *
+                              cycles_per_sec / ESC_GROUP_US_PER_SEC;
+        group->min_ticks[i] = min_ticks;
+        group->range_ticks[i] = max_ticks - min_ticks;
+        group->ccr[i] = &timer->CCR1 + group->channels[i] - 1;
+
+        // Sets the period and enables the channel and its compare preload,
+        // starting from the minimum pulse
+        if (pwm_set(group->pwm_dev, group->channels[i],
+                    PWM_USEC(esc.period_us),
+                    PWM_USEC((uint32_t)esc.min_pulse_duration_us), 0))
+            return ESC_TIMER_OVERFLOW_ERROR;
+    }
+
+    return ESC_SUCCESS;
+}
+
+static ESC_Error_Type WriteAnalog(ESC_Group_Type *group,
+                                  const uint16_t *throttle) {
+    TIM_TypeDef *timer = (TIM_TypeDef *)group->timer.timer_base;
+
+    // Holding back the update event keeps the new compare values in preload
+    // until all of them are written, so they are latched together
+    SET_BIT(timer->CR1, TIM_CR1_UDIS);
+
+    for (int i = 0; i < group->channel_count; i++) {
+        *group->ccr[i] =
+            group->min_ticks[i] +
+            ((throttle[i] * group->range_ticks[i]) >> ESC_GROUP_THROTTLE_SHIFT);
+    }
+
+    CLEAR_BIT(timer->CR1, TIM_CR1_UDIS);
+
+    return ESC_SUCCESS;
+}
+
+static ESC_Error_Type InitOnePulse(ESC_Group_Type *group, TIM_TypeDef *timer) {
+    ESC_Error_Type status = InitAnalog(group, timer);
+    if (status != ESC_SUCCESS)
+        return status;
+
+    group->pulse_end_ticks = 0;
+    for (int i = 0; i < group->channel_count; i++) {
+        group->pulse_end_ticks =
+            MAX(group->pulse_end_ticks,
+                group->min_ticks[i] + group->range_ticks[i]);
+    }
+
+    // The counter runs once from zero to the end of the longest pulse and
+    // stops at the update event. In PWM mode 2 a channel is active from its
+    // compare value on, so the pulses start at different times and all end
+    // together, which is when the ESCs latch the throttle.
+    LL_TIM_DisableCounter(timer);
+    LL_TIM_SetOnePulseMode(timer, LL_TIM_ONEPULSEMODE_SINGLE);
+    LL_TIM_SetAutoReload(timer, group->pulse_end_ticks);
+
+    for (int i = 0; i < group->channel_count; i++) {
+        const uint32_t channel = LL_TIM_CHANNEL_CH1
+                                 << (4 * (group->channels[i] - 1));
+
+        LL_TIM_OC_SetMode(timer, channel, LL_TIM_OCMODE_PWM2);
+        LL_TIM_OC_DisablePreload(timer, channel);
+        *group->ccr[i] = group->pulse_end_ticks + 1;
+    }
+
+    // Loads the period and clears the counter, the outputs stay inactive
+    LL_TIM_GenerateEvent_UPDATE(timer);
+
+    return ESC_SUCCESS;
+}
+
+static ESC_Error_Type WriteOnePulse(ESC_Group_Type *group,
+                                    const uint16_t *throttle) {
+    uint32_t width_ticks[ESC_GROUP_MAX_CHANNELS];
+
+    for (int i = 0; i < group->channel_count; i++) {
+        width_ticks[i] =
+            group->min_ticks[i] +
+            ((throttle[i] * group->range_ticks[i]) >> ESC_GROUP_THROTTLE_SHIFT);
+    }
+
+    return StartOnePulse(group, width_ticks);
+}
+
+static void LoadOnePulse(ESC_Group_Type *group, const uint32_t *width_ticks) {
+    // Compare preload is off, the counter is stopped at zero
+    for (int i = 0; i < group->channel_count; i++) {
+        *group->ccr[i] = group->pulse_end_ticks - width_ticks[i] + 1;
+    }
+}
+
+static ESC_Error_Type StartOnePulse(ESC_Group_Type *group,
+                                    const uint32_t *width_ticks) {
+    TIM_TypeDef *timer = (TIM_TypeDef *)group->timer.timer_base;
+
+    // The counter stops on its own at the end of the pulse
+    if (LL_TIM_IsEnabledCounter(timer))
+        return ESC_PULSE_BUSY;
+
+    LoadOnePulse(group, width_ticks);
+    LL_TIM_EnableCounter(timer);
+
+    return ESC_SUCCESS;
+}
+
+static ESC_Error_Type WriteArming(ESC_Group_Type *group,
+                                  const uint16_t *throttle) {
+    return ESC_ARMING_IN_PROGRESS;
+}
+
+static void ArmTimerHandler(struct k_timer *timer) {
+    ESC_Group_Type *group = CONTAINER_OF(timer, ESC_Group_Type, arm_timer);
+    group->arm_elapsed_ms += group->arm_period_ms;
+
+    if (group->arm_elapsed_ms >= ESC_ARM_DURATION) {
+        k_timer_stop(timer);
+        FinishArming(group, ESC_ARM_ARMED);
+        return;
+    }
+
+    // A pulse still in progress only means this refresh is skipped
+    if (group->output_write == WriteOnePulse) {
+        StartOnePulse(group, group->arm_ticks);
+    }
+
+#ifdef CONFIG_ESC_DSHOT
+    if (group->output_write == WriteDshot) {
+        // A frame still in flight only means this refresh is skipped
+        const ESC_Error_Type status = SendDshotStop(group);
+        if (status != ESC_SUCCESS && status != ESC_DSHOT_BUSY) {
+            k_timer_stop(timer);
+            FinishArming(group, ESC_ARM_FAILED);
+            ESC_GroupStop(group);
+            return;
+        }
+    }
+#endif
+
+    if (group->arm_callback != NULL &&
+        group->arm_elapsed_ms % ESC_GROUP_ARM_PROGRESS_MS == 0) {
+        group->arm_callback(group, ESC_ARM_ARMING,
+                            group->arm_elapsed_ms * 100 / ESC_ARM_DURATION,
+                            group->arm_user_data);
+    }
+}
+
+static void FinishArming(ESC_Group_Type *group,
+                         const ESC_Arm_State_Type state) {
+    group->arm_state = state;
+    group->write = group->output_write;
+
+    if (group->arm_callback != NULL) {
+        const uint8_t progress = group->arm_elapsed_ms * 100 / ESC_ARM_DURATION;
+        group->arm_callback(group, state, progress, group->arm_user_data);
+    }
+}
+
+#ifdef CONFIG_ESC_DSHOT
+static ESC_Error_Type InitDshot(ESC_Group_Type *group, TIM_TypeDef *timer) {
+    if (group->timer.bidirectional)
+        return ESC_INVALID_PROTOCOL;
+
+    if (!device_is_ready(group->timer.dma_dev))
+        return ESC_DEVICE_DMA_NOT_READY;
+
+    const uint32_t bit_ticks = ESC_DshotGetBitTicks(
+        group->pwm_dev, group->channels[0], group->protocol);
+    if (bit_ticks == 0)
+        return ESC_INVALID_TIMER_CLOCK;
+
+    group->dshot_bit1_ticks = bit_ticks * ESC_DSHOT_BIT1_HIGH_EIGHTHS / 8;
+    group->dshot_bit0_ticks = bit_ticks * ESC_DSHOT_BIT0_HIGH_EIGHTHS / 8;
+
+    // Trailing entries are never written again and return the lines to idle
+    for (int i = 0; i < ESC_DSHOT_BUFFER_LEN * ESC_GROUP_MAX_CHANNELS; i++) {
+        group->dshot_buffer[i] = 0;
+    }
+
+    for (int i = 0; i < group->channel_count; i++) {
+        if (pwm_set_cycles(group->pwm_dev, group->channels[i], bit_ticks, 0,
+                           0))
+            return ESC_NOT_INITIALIZED;
+
+        CLEAR_BIT(timer->DIER, TIM_DIER_CC1DE << (group->channels[i] - 1));
+    }
+
+    // Every update event makes the timer request one transfer per channel,
+    // each one going through DMAR to the next compare register. The values
+    // are latched together on the following update.
+    const uint32_t base = LL_TIM_DMABURST_BASEADDR_CCR1 +
+                          ((group->channels[0] - 1) << TIM_DCR_DBA_Pos);
+    const uint32_t length = (group->channel_count - 1) << TIM_DCR_DBL_Pos;
+#if defined(TIM_DCR_DBSS)
+    LL_TIM_ConfigDMABurst(timer, base, length, LL_TIM_DMABURST_SOURCE_UPDATE);
+#else
+    LL_TIM_ConfigDMABurst(timer, base, length);
+#endif
+    LL_TIM_EnableDMAReq_UPDATE(timer);
+
+    struct dma_block_config block = {
+        .source_address = (uint32_t)(uintptr_t)group->dshot_buffer,
+        .dest_address = (uint32_t)(uintptr_t)&timer->DMAR,
+        .block_size = ESC_DSHOT_BUFFER_LEN * group->channel_count *
+                      sizeof(group->dshot_buffer[0]),
+        .source_addr_adj = DMA_ADDR_ADJ_INCREMENT,
+        .dest_addr_adj = DMA_ADDR_ADJ_NO_CHANGE,
+    };
+
+    struct dma_config dma_cfg = {
+        .dma_slot = group->timer.dma_slot,
+        .channel_direction = MEMORY_TO_PERIPHERAL,
+        .source_data_size = sizeof(group->dshot_buffer[0]),
+        .dest_data_size = sizeof(group->dshot_buffer[0]),
+        .source_burst_length = 1,
+        .dest_burst_length = 1,
+        .block_count = 1,
+        .head_block = &block,
+    };
+
+    if (dma_config(group->timer.dma_dev, group->timer.dma_channel, &dma_cfg))
+        return ESC_NOT_INITIALIZED;
+
+    return ESC_SUCCESS;
+}
+
+static ESC_Error_Type WriteDshot(ESC_Group_Type *group,
+                                 const uint16_t *throttle) {
+    if (IsDshotBusy(group)) {
+        return ESC_DSHOT_BUSY;
+    }
+
+    for (int i = 0; i < group->channel_count; i++) {
+        // Zero stops the motor, the lowest throttle step may still spin it
+        if (throttle[i] == 0) {
+            EncodeDshot(group, i, ESC_DSHOT_CMD_MOTOR_STOP);
+            continue;
+        }
+
+        EncodeDshot(group, i,
+                    ESC_DSHOT_THROTTLE_MIN +
+                        ((throttle[i] * ESC_GROUP_DSHOT_STEPS) >>
+                         ESC_GROUP_THROTTLE_SHIFT));
+    }
+
+    return StartDshot(group);
+}
+
+static ESC_Error_Type SendDshotStop(ESC_Group_Type *group) {
+    if (IsDshotBusy(group)) {
+        return ESC_DSHOT_BUSY;
+    }
+
+    for (int i = 0; i < group->channel_count; i++) {
+        EncodeDshot(group, i, ESC_DSHOT_CMD_MOTOR_STOP);
+    }
+
+    return StartDshot(group);
+}
+
+static bool IsDshotBusy(const ESC_Group_Type *group) {
+    struct dma_status status;
+
+    return dma_get_status(group->timer.dma_dev, group->timer.dma_channel,
+                          &status) == 0 &&
+           status.busy;
+}
+
+static void EncodeDshot(ESC_Group_Type *group, const uint8_t index,
+                        const uint16_t value) {
+    const uint8_t count = group->channel_count;
+    uint16_t packet = ESC_DshotEncode(value, false, false);
+
+    // Most significant bit is sent first
+    uint32_t *entry = &group->dshot_buffer[index];
+    for (int bit = 0; bit < ESC_DSHOT_FRAME_BITS; bit++) {
+        *entry = (packet & 0x8000) ? group->dshot_bit1_ticks
+                                   : group->dshot_bit0_ticks;
+        entry += count;
+        packet <<= 1;
+    }
+}
+
+static ESC_Error_Type StartDshot(ESC_Group_Type *group) {
+    TIM_TypeDef *timer = (TIM_TypeDef *)group->timer.timer_base;
+
+    if (dma_reload(group->timer.dma_dev, group->timer.dma_channel,
+                   (uint32_t)(uintptr_t)group->dshot_buffer,
+                   (uint32_t)(uintptr_t)&timer->DMAR,
+                   ESC_DSHOT_BUFFER_LEN * group->channel_count *
+                       sizeof(group->dshot_buffer[0]))) {
+        return ESC_NOT_INITIALIZED;
+    }
+
+    if (dma_start(group->timer.dma_dev, group->timer.dma_channel)) {
+        return ESC_NOT_INITIALIZED;
+    }
+
+    return ESC_SUCCESS;
+}
+#endif
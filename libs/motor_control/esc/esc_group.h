@@ -0,0 +1,229 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ESC_GROUP_H
+#define ESC_GROUP_H
+
+#include "esc.h"
+
+#define ESC_GROUP_MAX_CHANNELS 4
+
+// Full scale of the throttle passed to ESC_GroupWrite
+#define ESC_GROUP_THROTTLE_MAX UINT16_MAX
+
+// Period at which arming progress is reported [ms]
+#define ESC_GROUP_ARM_PROGRESS_MS 100
+
+typedef struct ESC_Group ESC_Group_Type;
+
+typedef ESC_Error_Type (*ESC_Group_Write_Type)(ESC_Group_Type *group,
+                                               const uint16_t *throttle);
+
+typedef enum {
+    ESC_ARM_IDLE = 0,
+    ESC_ARM_ARMING,
+    ESC_ARM_ARMED,
+    ESC_ARM_CANCELLED,
+    ESC_ARM_FAILED,
+} ESC_Arm_State_Type;
+
+/**
+ * @brief Arming progress callback, called from the timer interrupt
+ * @param[in] group     Group being armed
+ * @param[in] state     ESC_ARM_ARMING while in progress, then the final state
+ * @param[in] progress  Elapsed part of the arming time [%]
+ * @param[in] user_data User data passed to ESC_GroupArmStart
+ */
+typedef void (*ESC_Arm_Callback_Type)(ESC_Group_Type *group,
+                                      ESC_Arm_State_Type state,
+                                      uint8_t progress, void *user_data);
+
+typedef struct {
+    const struct device *pwm_dev;
+    uint32_t channels[ESC_GROUP_MAX_CHANNELS]; // Consecutive, ascending
+    uint8_t channel_count;
+    ESC_Protocol_Type protocol;
+    // Send a single pulse on every write instead of repeating it with the
+    // timer period, OneShot and Multishot only
+    bool one_pulse;
+    // Timer of the PWM device, needed by every protocol. DMA is only used by
+    // DShot and has to be triggered by the timer update event.
+    ESC_Dshot_Config_Type timer;
+} ESC_Group_Config_Type;
+
+struct ESC_Group {
+    const struct device *pwm_dev;
+    uint32_t channels[ESC_GROUP_MAX_CHANNELS];
+    uint8_t channel_count;
+    ESC_Protocol_Type protocol;
+    ESC_Dshot_Config_Type timer;
+    bool one_pulse;
+    bool initialized;
+
+    // Resolved on init, so the update does not depend on the protocol. While
+    // arming, writes are rejected instead.
+    ESC_Group_Write_Type write;
+    ESC_Group_Write_Type output_write;
+
+    // Arming, advanced by the timer in the background
+    struct k_timer arm_timer;
+    ESC_Arm_Callback_Type arm_callback;
+    void *arm_user_data;
+    volatile ESC_Arm_State_Type arm_state;
+    uint32_t arm_period_ms;
+    uint32_t arm_elapsed_ms;
+    uint32_t arm_ticks[ESC_GROUP_MAX_CHANNELS];
+
+    // Analog protocols, compare value = min + throttle * range / 2^16
+    volatile uint32_t *ccr[ESC_GROUP_MAX_CHANNELS];
+    uint32_t min_ticks[ESC_GROUP_MAX_CHANNELS];
+    uint32_t range_ticks[ESC_GROUP_MAX_CHANNELS];
+
+    // One-pulse output, every pulse ends when the counter reaches this value
+    uint32_t pulse_end_ticks;
+
+    // DShot, compare values of all channels interleaved per bit, in the order
+    // the timer DMA burst writes them
+    uint16_t dshot_bit0_ticks;
+    uint16_t dshot_bit1_ticks;
+    uint32_t dshot_buffer[ESC_DSHOT_BUFFER_LEN * ESC_GROUP_MAX_CHANNELS];
+};
+
+/**
+ * @brief ESC Group Initialization function
+ * @param[in] cfg    Timer channels, protocol and DMA used by the group
+ * @param[out] group Pointer to the ESC group struct, it needs to be passed
+ *                   to the ESC_GroupWrite function
+ *
+ * @note All channels have to belong to the timer of the PWM device. For
+ * DShot the DMA request has to be the timer update request, e.g.
+ * LL_GPDMA1_REQUEST_TIM3_UP. Bidirectional DShot is not supported by groups.
+ * In one-pulse mode the timer only counts while a pulse is sent, so it can
+ * not be shared with other outputs.
+ *
+ * @retval ESC_SUCCESS - Operation finished successfully
+ * @retval ESC_DEVICE_PWM_NOT_READY - PWM device is not initialized correctly
+ * @retval ESC_DEVICE_DMA_NOT_READY - DMA device is not initialized correctly
+ * @retval ESC_INVALID_PROTOCOL - Protocol is not supported by the group, or
+ *                                not in one-pulse mode
+ * @retval ESC_INVALID_CHANNELS - Channels are not consecutive and ascending
+ * @retval ESC_INVALID_TIMER_CLOCK - Timer clock is too slow for the protocol
+ * @retval ESC_NOT_INITIALIZED - Timer or DMA configuration failed
+ */
+ESC_Error_Type ESC_GroupInit(ESC_Group_Type *group,
+                             const ESC_Group_Config_Type *cfg);
+
+/**
+ * @brief ESC Group Write throttle of all channels at once
+ * @param[in] group    Pointer to the preinitialized ESC group struct
+ * @param[in] throttle One throttle per channel [0,ESC_GROUP_THROTTLE_MAX]
+ *
+ * @note All compare values are latched by the same timer update event, so
+ * every motor changes within one period. With DShot every call sends a single
+ * frame per channel, so it has to be called periodically, and a throttle of
+ * zero sends the motor stop command. In one-pulse mode every call also sends
+ * a single pulse per channel, started right away. The pulses of all channels
+ * end together, one maximum pulse length after the call, which is when the
+ * ESCs see the new throttle.
+ *
+ * @retval ESC_SUCCESS - Operation finished successfully
+ * @retval ESC_DSHOT_BUSY - Previous DShot frames are still being sent
+ * @retval ESC_PULSE_BUSY - Previous one-pulse output is still being sent
+ * @retval ESC_ARMING_IN_PROGRESS - The group is being armed
+ * @retval ESC_NOT_INITIALIZED - Specified group is not initialized correctly
+ */
+static inline ESC_Error_Type ESC_GroupWrite(ESC_Group_Type *group,
+                                            const uint16_t *throttle) {
+    if (!group->initialized) {
+        return ESC_NOT_INITIALIZED;
+    }
+
+    return group->write(group, throttle);
+}
+
+/**
+ * @brief ESC Group Write Sync - Write several one-pulse groups at once
+ * @param[in] groups   Pointers to the preinitialized ESC group structs
+ * @param[in] throttle One throttle array per group, as for ESC_GroupWrite
+ * @param[in] count    Number of groups
+ *
+ * @note The compare values of all groups are written first and the timers
+ * are then started back to back with interrupts locked, so motors on
+ * different timers start their pulses within a few cycles.
+ *
+ * @retval ESC_SUCCESS - Operation finished successfully
+ * @retval ESC_INVALID_PROTOCOL - A group is not in one-pulse mode
+ * @retval ESC_PULSE_BUSY - Previous pulses of a group are still being sent
+ * @retval ESC_ARMING_IN_PROGRESS - A group is being armed
+ * @retval ESC_NOT_INITIALIZED - A group is not initialized correctly
+ */
+ESC_Error_Type ESC_GroupWriteSync(ESC_Group_Type *const *groups,
+                                  const uint16_t *const *throttle,
+                                  uint8_t count);
+
+/**
+ * @brief ESC Group Arm Start - Arm all ESCs of the group without blocking
+ * @param[in] group     Pointer to the preinitialized ESC group struct
+ * @param[in] callback  Called on progress and on completion, can be NULL
+ * @param[in] user_data Passed to the callback
+ *
+ * @note All ESCs of the group see the arming signal at the same time, for
+ * ESC_ARM_DURATION. Groups on different timers can be armed in parallel.
+ * DShot ESCs disarm without frames, so ESC_GroupWrite has to be called
+ * periodically as soon as the group is armed.
+ *
+ * @retval ESC_SUCCESS - Arming started
+ * @retval ESC_ARMING_IN_PROGRESS - The group is already being armed
+ * @retval ESC_INVALID_ARMING - The arming signal could not be set
+ * @retval ESC_NOT_INITIALIZED - Specified group is not initialized correctly
+ */
+ESC_Error_Type ESC_GroupArmStart(ESC_Group_Type *group,
+                                 ESC_Arm_Callback_Type callback,
+                                 void *user_data);
+
+/**
+ * @brief ESC Group Arm Cancel - Abort arming and stop the signal
+ * @param[in] group Pointer to the preinitialized ESC group struct
+ *
+ * @retval ESC_SUCCESS - Operation finished successfully
+ * @retval ESC_NOT_INITIALIZED - Specified group is not initialized correctly
+ * @retval ESC_INVALID_STOP - Error in ESC stop command
+ */
+ESC_Error_Type ESC_GroupArmCancel(ESC_Group_Type *group);
+
+/**
+ * @brief ESC Group Get Arm State
+ * @param[in] group Pointer to the preinitialized ESC group struct
+ *
+ * @return Current arming state of the group
+ */
+static inline ESC_Arm_State_Type
+ESC_GroupGetArmState(const ESC_Group_Type *group) {
+    return group->arm_state;
+}
+
+/**
+ * @brief ESC Group Stop - Stop the signal of all channels
+ * @param[in] group Pointer to the preinitialized ESC group struct
+ *
+ * @retval ESC_SUCCESS - Operation finished successfully
+ * @retval ESC_NOT_INITIALIZED - Specified group is not initialized correctly
+ * @retval ESC_INVALID_STOP - Error in ESC stop command
+ */
+ESC_Error_Type ESC_GroupStop(ESC_Group_Type *group);
+
+#endif
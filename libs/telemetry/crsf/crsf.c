@@ -0,0 +1,242 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "crsf.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+// Address and length precede the type, the length counts type, payload and
+// CRC
+#define CRSF_HEADER_LEN 2
+#define CRSF_MIN_LEN_FIELD 2
+#define CRSF_MAX_LEN_FIELD (CRSF_MAX_FRAME_LEN - CRSF_HEADER_LEN)
+
+#define CRSF_CHANNEL_BITS 11
+#define CRSF_CHANNEL_MASK ((1u << CRSF_CHANNEL_BITS) - 1)
+
+#define CRSF_BATTERY_PAYLOAD_LEN 8
+#define CRSF_ATTITUDE_PAYLOAD_LEN 6
+
+// CRC8 with polynomial 0xD5, one entry per byte value
+static const uint8_t crc8_table[256] = {
+    0x00, 0xD5, 0x7F, 0xAA, 0xFE, 0x2B, 0x81, 0x54, 0x29, 0xFC, 0x56, 0x83,
+    0xD7, 0x02, 0xA8, 0x7D, 0x52, 0x87, 0x2D, 0xF8, 0xAC, 0x79, 0xD3, 0x06,
+    0x7B, 0xAE, 0x04, 0xD1, 0x85, 0x50, 0xFA, 0x2F, 0xA4, 0x71, 0xDB, 0x0E,
+    0x5A, 0x8F, 0x25, 0xF0, 0x8D, 0x58, 0xF2, 0x27, 0x73, 0xA6, 0x0C, 0xD9,
+    0xF6, 0x23, 0x89, 0x5C, 0x08, 0xDD, 0x77, 0xA2, 0xDF, 0x0A, 0xA0, 0x75,
+    0x21, 0xF4, 0x5E, 0x8B, 0x9D, 0x48, 0xE2, 0x37, 0x63, 0xB6, 0x1C, 0xC9,
+    0xB4, 0x61, 0xCB, 0x1E, 0x4A, 0x9F, 0x35, 0xE0, 0xCF, 0x1A, 0xB0, 0x65,
+    0x31, 0xE4, 0x4E, 0x9B, 0xE6, 0x33, 0x99, 0x4C, 0x18, 0xCD, 0x67, 0xB2,
+    0x39, 0xEC, 0x46, 0x93, 0xC7, 0x12, 0xB8, 0x6D, 0x10, 0xC5, 0x6F, 0xBA,
+    0xEE, 0x3B, 0x91, 0x44, 0x6B, 0xBE, 0x14, 0xC1, 0x95, 0x40, 0xEA, 0x3F,
+    0x42, 0x97, 0x3D, 0xE8, 0xBC, 0x69, 0xC3, 0x16, 0xEF, 0x3A, 0x90, 0x45,
+    0x11, 0xC4, 0x6E, 0xBB, 0xC6, 0x13, 0xB9, 0x6C, 0x38, 0xED, 0x47, 0x92,
+    0xBD, 0x68, 0xC2, 0x17, 0x43, 0x96, 0x3C, 0xE9, 0x94, 0x41, 0xEB, 0x3E,
+    0x6A, 0xBF, 0x15, 0xC0, 0x4B, 0x9E, 0x34, 0xE1, 0xB5, 0x60, 0xCA, 0x1F,
+    0x62, 0xB7, 0x1D, 0xC8, 0x9C, 0x49, 0xE3, 0x36, 0x19, 0xCC, 0x66, 0xB3,
+    0xE7, 0x32, 0x98, 0x4D, 0x30, 0xE5, 0x4F, 0x9A, 0xCE, 0x1B, 0xB1, 0x64,
+    0x72, 0xA7, 0x0D, 0xD8, 0x8C, 0x59, 0xF3, 0x26, 0x5B, 0x8E, 0x24, 0xF1,
+    0xA5, 0x70, 0xDA, 0x0F, 0x20, 0xF5, 0x5F, 0x8A, 0xDE, 0x0B, 0xA1, 0x74,
+    0x09, 0xDC, 0x76, 0xA3, 0xF7, 0x22, 0x88, 0x5D, 0xD6, 0x03, 0xA9, 0x7C,
+    0x28, 0xFD, 0x57, 0x82, 0xFF, 0x2A, 0x80, 0x55, 0x01, 0xD4, 0x7E, 0xAB,
+    0x84, 0x51, 0xFB, 0x2E, 0x7A, 0xAF, 0x05, 0xD0, 0xAD, 0x78, 0xD2, 0x07,
+    0x53, 0x86, 0x2C, 0xF9,
+};
+
+uint8_t CRSF_Crc8(const uint8_t *data, size_t len) {
+    uint8_t crc = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        crc = crc8_table[crc ^ data[i]];
+    }
+
+    return crc;
+}
+
+static bool valid_length(uint8_t len) {
+    return len >= CRSF_MIN_LEN_FIELD && len <= CRSF_MAX_LEN_FIELD;
+}
+
+// The CRC covers type and payload
+static bool handle_frame(CRSF_Parser_Type *parser, const uint8_t *frame) {
+    const uint8_t len = frame[1];
+
+    if (CRSF_Crc8(&frame[CRSF_HEADER_LEN], len - 1) !=
+        frame[CRSF_HEADER_LEN + len - 1]) {
+        parser->crc_errors++;
+        return false;
+    }
+
+    parser->frames++;
+    parser->callback(frame[CRSF_HEADER_LEN], &frame[CRSF_HEADER_LEN + 1],
+                     len - 2, parser->user_data);
+
+    return true;
+}
+
+CRSF_Error_Type CRSF_ParserInit(CRSF_Parser_Type *parser,
+                                CRSF_Frame_Callback_Type callback,
+                                void *user_data) {
+    if (parser == NULL || callback == NULL) {
+        return CRSF_INVALID_PARAM;
+    }
+
+    memset(parser, 0, sizeof(*parser));
+    parser->callback = callback;
+    parser->user_data = user_data;
+
+    return CRSF_SUCCESS;
+}
+
+void CRSF_Parse(CRSF_Parser_Type *parser, const uint8_t *data, size_t len) {
+    size_t pos = 0;
+
+    // Completes a frame started at the end of the previous chunk
+    while (parser->partial_len > 0 && pos < len) {
+        parser->partial[parser->partial_len++] = data[pos++];
+
+        if (parser->partial_len == CRSF_HEADER_LEN &&
+            !valid_length(parser->partial[1])) {
+            // The length byte is scanned again, it may start a frame
+            parser->bytes_skipped++;
+            parser->partial_len = 0;
+            pos--;
+        } else if (parser->partial_len > CRSF_HEADER_LEN &&
+                   parser->partial_len ==
+                       parser->partial[1] + CRSF_HEADER_LEN) {
+            handle_frame(parser, parser->partial);
+            parser->partial_len = 0;
+        }
+    }
+
+    // Frames within the chunk are handed over in place
+    while (pos < len) {
+        if (data[pos] != CRSF_SYNC_BYTE) {
+            parser->bytes_skipped++;
+            pos++;
+            continue;
+        }
+
+        const size_t remaining = len - pos;
+        if (remaining < CRSF_HEADER_LEN) {
+            break;
+        }
+
+        const uint8_t frame_len = data[pos + 1];
+        if (!valid_length(frame_len)) {
+            parser->bytes_skipped++;
+            pos++;
+            continue;
+        }
+
+        if (remaining < (size_t)frame_len + CRSF_HEADER_LEN) {
+            break;
+        }
+
+        // A corrupted frame may hide the start of the next one
+        if (handle_frame(parser, &data[pos])) {
+            pos += frame_len + CRSF_HEADER_LEN;
+        } else {
+            pos++;
+        }
+    }
+
+    if (pos < len) {
+        memcpy(parser->partial, &data[pos], len - pos);
+        parser->partial_len = len - pos;
+    }
+}
+
+void CRSF_DecodeChannels(const uint8_t *payload, uint16_t *channels) {
+    uint32_t bits = 0;
+    int bit_count = 0;
+
+    // Channels are packed least significant bit first
+    for (int i = 0; i < CRSF_RC_CHANNEL_COUNT; i++) {
+        while (bit_count < CRSF_CHANNEL_BITS) {
+            bits |= (uint32_t)*payload++ << bit_count;
+            bit_count += 8;
+        }
+
+        channels[i] = bits & CRSF_CHANNEL_MASK;
+        bits >>= CRSF_CHANNEL_BITS;
+        bit_count -= CRSF_CHANNEL_BITS;
+    }
+}
+
+void CRSF_DecodeLinkStats(const uint8_t *payload, CRSF_Link_Stats_Type *stats) {
+    stats->uplink_rssi_1_dbm = payload[0];
+    stats->uplink_rssi_2_dbm = payload[1];
+    stats->uplink_link_quality = payload[2];
+    stats->uplink_snr_db = (int8_t)payload[3];
+    stats->active_antenna = payload[4];
+    stats->rf_mode = payload[5];
+    stats->uplink_tx_power = payload[6];
+    stats->downlink_rssi_dbm = payload[7];
+    stats->downlink_link_quality = payload[8];
+    stats->downlink_snr_db = (int8_t)payload[9];
+}
+
+static uint8_t *put_be16(uint8_t *dst, uint16_t value) {
+    *dst++ = value >> 8;
+    *dst++ = value & 0xFF;
+
+    return dst;
+}
+
+// Fills in address, length and CRC around a payload already in place
+static uint8_t finish_frame(uint8_t *frame, uint8_t type, uint8_t payload_len) {
+    frame[0] = CRSF_SYNC_BYTE;
+    frame[1] = payload_len + 2;
+    frame[2] = type;
+    frame[CRSF_HEADER_LEN + 1 + payload_len] =
+        CRSF_Crc8(&frame[CRSF_HEADER_LEN], payload_len + 1);
+
+    return payload_len + 4;
+}
+
+uint8_t CRSF_EncodeBattery(const CRSF_Battery_Type *battery, uint8_t *frame) {
+    uint8_t *payload = &frame[CRSF_HEADER_LEN + 1];
+
+    const float current_a =
+        isnan(battery->current_a) ? 0.0f : battery->current_a;
+
+    // Voltage and current in tenths, capacity is 24 bit
+    payload = put_be16(payload, (uint16_t)(battery->voltage_v * 10.0f));
+    payload = put_be16(payload, (uint16_t)(current_a * 10.0f));
+    *payload++ = (battery->capacity_mah >> 16) & 0xFF;
+    *payload++ = (battery->capacity_mah >> 8) & 0xFF;
+    *payload++ = battery->capacity_mah & 0xFF;
+    *payload++ = battery->remaining_pct;
+
+    return finish_frame(frame, CRSF_FRAME_BATTERY_SENSOR,
+                        CRSF_BATTERY_PAYLOAD_LEN);
+}
+
+uint8_t CRSF_EncodeAttitude(float roll_rad, float pitch_rad, float yaw_rad,
+                            uint8_t *frame) {
+    uint8_t *payload = &frame[CRSF_HEADER_LEN + 1];
+
+    // Angles in units of 100 microradians, pitch first
+    payload = put_be16(payload, (uint16_t)(int16_t)(pitch_rad * 10000.0f));
+    payload = put_be16(payload, (uint16_t)(int16_t)(roll_rad * 10000.0f));
+    payload = put_be16(payload, (uint16_t)(int16_t)(yaw_rad * 10000.0f));
+
+    return finish_frame(frame, CRSF_FRAME_ATTITUDE, CRSF_ATTITUDE_PAYLOAD_LEN);
+}
@@ -0,0 +1,179 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CRSF_H
+#define CRSF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Address of the flight controller, which starts every frame on its link
+#define CRSF_SYNC_BYTE 0xC8
+
+// Address, length, type, up to 60 payload bytes and the CRC
+#define CRSF_MAX_FRAME_LEN 64
+#define CRSF_MAX_PAYLOAD_LEN (CRSF_MAX_FRAME_LEN - 4)
+
+#define CRSF_RC_CHANNEL_COUNT 16
+
+#define CRSF_RC_CHANNELS_PAYLOAD_LEN 22
+#define CRSF_LINK_STATS_PAYLOAD_LEN 10
+
+// Channel values are 11 bit, spanning the same range as SBUS
+#define CRSF_CHANNEL_MIN 172
+#define CRSF_CHANNEL_MAX 1811
+
+typedef enum {
+    CRSF_SUCCESS = 0,
+    CRSF_INVALID_PARAM,
+} CRSF_Error_Type;
+
+typedef enum {
+    CRSF_FRAME_BATTERY_SENSOR = 0x08,
+    CRSF_FRAME_LINK_STATISTICS = 0x14,
+    CRSF_FRAME_RC_CHANNELS_PACKED = 0x16,
+    CRSF_FRAME_ATTITUDE = 0x1E,
+} CRSF_Frame_Id_Type;
+
+typedef struct {
+    uint8_t uplink_rssi_1_dbm;   // Negated, 0 is strongest
+    uint8_t uplink_rssi_2_dbm;   // Negated, 0 is strongest
+    uint8_t uplink_link_quality; // [%]
+    int8_t uplink_snr_db;
+    uint8_t active_antenna;
+    uint8_t rf_mode;
+    uint8_t uplink_tx_power;
+    uint8_t downlink_rssi_dbm;     // Negated, 0 is strongest
+    uint8_t downlink_link_quality; // [%]
+    int8_t downlink_snr_db;
+} CRSF_Link_Stats_Type;
+
+typedef struct {
+    float voltage_v;
+    float current_a;
+    uint32_t capacity_mah; // Consumed capacity
+    uint8_t remaining_pct;
+} CRSF_Battery_Type;
+
+/**
+ * @brief Frame callback, called for every frame with a valid CRC
+ * @param type        Frame type, one of CRSF_Frame_Id_Type or any other
+ * @param payload     Payload, only valid during the callback
+ * @param payload_len Payload length
+ * @param user_data   User data passed to CRSF_ParserInit
+ */
+typedef void (*CRSF_Frame_Callback_Type)(uint8_t type, const uint8_t *payload,
+                                         uint8_t payload_len, void *user_data);
+
+typedef struct {
+    CRSF_Frame_Callback_Type callback;
+    void *user_data;
+
+    // Holds a frame which is split between two received chunks, every other
+    // frame is handed to the callback straight from the received data
+    uint8_t partial[CRSF_MAX_FRAME_LEN];
+    uint8_t partial_len;
+
+    uint32_t frames;
+    uint32_t crc_errors;
+    uint32_t bytes_skipped; // Bytes dropped while searching for a frame start
+} CRSF_Parser_Type;
+
+/**
+ * @brief Initializes the frame parser
+ *
+ * @param parser    A pointer to the parser instance
+ * @param callback  Called for every valid frame
+ * @param user_data Passed to the callback
+ *
+ * @retval CRSF_SUCCESS - Operation finished successfully
+ * @retval CRSF_INVALID_PARAM - Pointers are not set
+ */
+CRSF_Error_Type CRSF_ParserInit(CRSF_Parser_Type *parser,
+                                CRSF_Frame_Callback_Type callback,
+                                void *user_data);
+
+/**
+ * @brief Parses a chunk of received data
+ *
+ * Chunks may end in the middle of a frame, the rest of it is expected at the
+ * start of the next chunk.
+ *
+ * @param parser A pointer to the initialized parser instance
+ * @param data   Received bytes
+ * @param len    Number of received bytes
+ */
+void CRSF_Parse(CRSF_Parser_Type *parser, const uint8_t *data, size_t len);
+
+/**
+ * @brief Calculates the CRC8 with the DVB-S2 polynomial used by CRSF
+ *
+ * @param data Bytes to checksum
+ * @param len  Number of bytes
+ *
+ * @return CRC of the bytes
+ */
+uint8_t CRSF_Crc8(const uint8_t *data, size_t len);
+
+/**
+ * @brief Unpacks the payload of a CRSF_FRAME_RC_CHANNELS_PACKED frame
+ *
+ * @param payload  Payload of CRSF_RC_CHANNELS_PAYLOAD_LEN bytes
+ * @param channels Output array of CRSF_RC_CHANNEL_COUNT values
+ */
+void CRSF_DecodeChannels(const uint8_t *payload, uint16_t *channels);
+
+/**
+ * @brief Unpacks the payload of a CRSF_FRAME_LINK_STATISTICS frame
+ *
+ * @param payload Payload of CRSF_LINK_STATS_PAYLOAD_LEN bytes
+ * @param stats   Output link statistics
+ */
+void CRSF_DecodeLinkStats(const uint8_t *payload, CRSF_Link_Stats_Type *stats);
+
+/**
+ * @brief Builds a CRSF_FRAME_BATTERY_SENSOR frame
+ *
+ * @param battery Battery state
+ * @param frame   Output buffer of CRSF_MAX_FRAME_LEN bytes
+ *
+ * @return Length of the frame
+ */
+uint8_t CRSF_EncodeBattery(const CRSF_Battery_Type *battery, uint8_t *frame);
+
+/**
+ * @brief Builds a CRSF_FRAME_ATTITUDE frame
+ *
+ * @param roll_rad  Roll angle
+ * @param pitch_rad Pitch angle
+ * @param yaw_rad   Yaw angle
+ * @param frame     Output buffer of CRSF_MAX_FRAME_LEN bytes
+ *
+ * @return Length of the frame
+ */
+uint8_t CRSF_EncodeAttitude(float roll_rad, float pitch_rad, float yaw_rad,
+                            uint8_t *frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CRSF_H
@@ -20,8 +20,27 @@
 
 #include "mavlink_types.h"
 
+/*
+ * The send functions serialize every frame straight into the transmit buffer
+ * of its channel. The start hook reserves space for the whole frame, the
+ * bytes are written into it and the end hook makes the frame visible to the
+ * link, so no frame is ever sent partially.
+ */
+#define MAVLINK_USE_CONVENIENCE_FUNCTIONS
+#define MAVLINK_START_UART_SEND mavlink_start_uart_send
+#define MAVLINK_SEND_UART_BYTES mavlink_send_uart_bytes
+#define MAVLINK_END_UART_SEND mavlink_end_uart_send
+
+/* System and component ID of every frame sent by the send functions */
+extern mavlink_system_t mavlink_system;
+
 /* Prototypes must be visible to anyone including MAVLink */
 mavlink_status_t *mavlink_get_channel_status(uint8_t chan);
 mavlink_message_t *mavlink_get_channel_buffer(uint8_t chan);
 
+void mavlink_start_uart_send(mavlink_channel_t chan, uint16_t len);
+void mavlink_send_uart_bytes(mavlink_channel_t chan, const uint8_t *buf,
+                             uint16_t len);
+void mavlink_end_uart_send(mavlink_channel_t chan, uint16_t len);
+
 #endif
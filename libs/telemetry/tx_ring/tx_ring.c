@@ -0,0 +1,128 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tx_ring.h"
+
+#include <string.h>
+
+// While wrapped, the data runs from read to the watermark and continues from
+// the start of the buffer up to write
+static bool is_wrapped(const TX_RING_Inst_Type *ring) {
+    return ring->write < ring->read;
+}
+
+TX_RING_Error_Type TX_RING_Init(TX_RING_Inst_Type *ring, uint8_t *buffer,
+                                size_t size) {
+    if (ring == NULL || buffer == NULL || size == 0) {
+        return TX_RING_INVALID_PARAM;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->buffer = buffer;
+    ring->size = size;
+
+    return TX_RING_SUCCESS;
+}
+
+TX_RING_Error_Type TX_RING_Reserve(TX_RING_Inst_Type *ring, size_t len,
+                                   uint8_t **data) {
+    if (ring->reserved) {
+        return TX_RING_BUSY;
+    }
+
+    // An empty ring starts over, which leaves the most contiguous space
+    if (ring->read == ring->write) {
+        ring->read = 0;
+        ring->write = 0;
+    }
+
+    // The write position never catches up with the read position from
+    // behind, so equal positions always mean an empty ring
+    if (is_wrapped(ring)) {
+        if (ring->write + len >= ring->read) {
+            return TX_RING_NO_SPACE;
+        }
+        ring->reserve_start = ring->write;
+    } else if (ring->write + len <= ring->size) {
+        ring->reserve_start = ring->write;
+    } else if (len < ring->read) {
+        ring->reserve_start = 0;
+    } else {
+        return TX_RING_NO_SPACE;
+    }
+
+    ring->reserve_len = len;
+    ring->reserved = true;
+    *data = &ring->buffer[ring->reserve_start];
+
+    return TX_RING_SUCCESS;
+}
+
+void TX_RING_Commit(TX_RING_Inst_Type *ring, size_t len) {
+    if (!ring->reserved) {
+        return;
+    }
+
+    ring->reserved = false;
+
+    if (len == 0) {
+        return;
+    }
+
+    len = len < ring->reserve_len ? len : ring->reserve_len;
+
+    if (ring->reserve_start == ring->write) {
+        ring->write += len;
+        return;
+    }
+
+    // The frame went to the start of the buffer. Without data left before
+    // the end, the reader continues at the start right away.
+    if (ring->read == ring->write) {
+        ring->read = 0;
+    } else {
+        ring->watermark = ring->write;
+    }
+
+    ring->write = len;
+}
+
+size_t TX_RING_Claim(TX_RING_Inst_Type *ring, const uint8_t **data) {
+    *data = &ring->buffer[ring->read];
+
+    if (is_wrapped(ring)) {
+        return ring->watermark - ring->read;
+    }
+
+    return ring->write - ring->read;
+}
+
+void TX_RING_Release(TX_RING_Inst_Type *ring, size_t len) {
+    ring->read += len;
+
+    if (is_wrapped(ring) && ring->read >= ring->watermark) {
+        ring->read = 0;
+    }
+}
+
+size_t TX_RING_Used(const TX_RING_Inst_Type *ring) {
+    if (is_wrapped(ring)) {
+        return ring->watermark - ring->read + ring->write;
+    }
+
+    return ring->write - ring->read;
+}
@@ -0,0 +1,127 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TX_RING_H
+#define TX_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    TX_RING_SUCCESS = 0,
+    TX_RING_INVALID_PARAM,
+    TX_RING_NO_SPACE,
+    TX_RING_BUSY,
+} TX_RING_Error_Type;
+
+/*
+ * Ring of whole frames, which are written in place and read back as
+ * contiguous regions, e.g. by a DMA. A frame that does not fit before the end
+ * of the buffer is placed at its start, and the unused tail is skipped by the
+ * reader. The ring does no locking, producer and consumer calls have to be
+ * serialized by the caller.
+ */
+typedef struct {
+    uint8_t *buffer;
+    size_t size;
+
+    size_t read;      // Start of the committed data
+    size_t write;     // End of the committed data
+    size_t watermark; // End of the data before the start, while wrapped
+
+    size_t reserve_start;
+    size_t reserve_len;
+    bool reserved;
+} TX_RING_Inst_Type;
+
+/**
+ * @brief Initializes an empty ring
+ *
+ * @param ring   A pointer to the ring instance
+ * @param buffer Backing storage
+ * @param size   Size of the backing storage
+ *
+ * @retval TX_RING_SUCCESS - Operation finished successfully
+ * @retval TX_RING_INVALID_PARAM - Pointers are not set or the size is zero
+ */
+TX_RING_Error_Type TX_RING_Init(TX_RING_Inst_Type *ring, uint8_t *buffer,
+                                size_t size);
+
+/**
+ * @brief Reserves contiguous space for a frame
+ *
+ * The frame becomes visible to the reader only once it is committed, so it
+ * can be written in place without holding the lock of the consumer. Only one
+ * frame can be reserved at a time.
+ *
+ * @param ring A pointer to the initialized ring instance
+ * @param len  Frame length
+ * @param data Set to the reserved space
+ *
+ * @retval TX_RING_SUCCESS - Space reserved
+ * @retval TX_RING_NO_SPACE - There is no contiguous free space of this length
+ * @retval TX_RING_BUSY - Another frame is reserved
+ */
+TX_RING_Error_Type TX_RING_Reserve(TX_RING_Inst_Type *ring, size_t len,
+                                   uint8_t **data);
+
+/**
+ * @brief Makes the reserved frame visible to the reader
+ *
+ * @param ring A pointer to the initialized ring instance
+ * @param len  Bytes written, at most the reserved length, zero cancels the
+ *             reservation
+ */
+void TX_RING_Commit(TX_RING_Inst_Type *ring, size_t len);
+
+/**
+ * @brief Gets the longest contiguous region of committed data
+ *
+ * @param ring A pointer to the initialized ring instance
+ * @param data Set to the start of the region
+ *
+ * @return Length of the region, zero when the ring is empty
+ */
+size_t TX_RING_Claim(TX_RING_Inst_Type *ring, const uint8_t **data);
+
+/**
+ * @brief Frees data from the start of the claimed region
+ *
+ * @param ring A pointer to the initialized ring instance
+ * @param len  Bytes to free, at most the claimed length
+ */
+void TX_RING_Release(TX_RING_Inst_Type *ring, size_t len);
+
+/**
+ * @brief Gets the amount of committed data
+ *
+ * @param ring A pointer to the initialized ring instance
+ *
+ * @return Bytes waiting to be read
+ */
+size_t TX_RING_Used(const TX_RING_Inst_Type *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TX_RING_H
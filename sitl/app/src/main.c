@@ -23,7 +23,7 @@
 // MAVLink headers
 // clang-format off
 #include "mavlink_custom.h" // Needs to be included before any MAVLink header inclusion
-#include "common/mavlink.h"
+#include "efc/mavlink.h"
 // clang-format on
 
 #define TARGET_IP "127.0.0.1"
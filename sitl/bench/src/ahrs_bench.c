@@ -0,0 +1,83 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "ahrs.h"
+
+#define BENCH_ITERATIONS 10000000
+#define BENCH_SAMPLE_COUNT 256
+#define BENCH_SAMPLE_RATE_HZ 2000
+
+// Inputs are generated up front so only the estimator update is measured
+static float gyro_radps[BENCH_SAMPLE_COUNT][3];
+static float accel_mps2[BENCH_SAMPLE_COUNT][3];
+
+static AHRS_Inst_Type ahrs;
+
+static void generate_samples(void) {
+    for (int i = 0; i < BENCH_SAMPLE_COUNT; i++) {
+        const float phase = 2.0f * 3.14159265f * i / BENCH_SAMPLE_COUNT;
+
+        gyro_radps[i][0] = 0.5f * sinf(phase);
+        gyro_radps[i][1] = 0.3f * cosf(phase);
+        gyro_radps[i][2] = 0.1f;
+
+        accel_mps2[i][0] = 0.4f * sinf(3.0f * phase);
+        accel_mps2[i][1] = 0.4f * cosf(5.0f * phase);
+        accel_mps2[i][2] = 9.81f;
+    }
+}
+
+static uint64_t get_time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+int main(void) {
+    generate_samples();
+
+    const AHRS_Config_Type cfg = {
+        .kp = 0.5f,
+        .ki = 0.01f,
+    };
+
+    if (AHRS_Init(&ahrs, &cfg) != AHRS_SUCCESS) {
+        fprintf(stderr, "Could not initialize the attitude estimator!\n");
+        return 1;
+    }
+
+    const float dt_s = 1.0f / BENCH_SAMPLE_RATE_HZ;
+
+    const uint64_t start_ns = get_time_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        const int idx = i % BENCH_SAMPLE_COUNT;
+        AHRS_Update(&ahrs, gyro_radps[idx], accel_mps2[idx], dt_s);
+    }
+    const uint64_t elapsed_ns = get_time_ns() - start_ns;
+
+    printf("AHRS update: %.1f ns avg over %d iterations\n",
+           (double)elapsed_ns / BENCH_ITERATIONS, BENCH_ITERATIONS);
+    printf("Final attitude: [%f, %f, %f, %f]\n", ahrs.q[0], ahrs.q[1],
+           ahrs.q[2], ahrs.q[3]);
+
+    return 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * This file is part of the efc project <https://github.com/eurus-project/efc/>.
+ * Copyright (c) (2024 - Present), The efc developers.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Decodes IMU_BATCH messages from a MAVLink byte stream, e.g. the USB link of
+// the flight controller, into one CSV line per sample:
+//   efc_imu_batch_decode < /dev/ttyACM1 > imu.csv
+// Lost frames are detected from the sequence numbers and reported at the end.
+// Every component keeps its own sequence, e.g. GCS heartbeats forwarded onto
+// the link, so they are followed per system and component.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// MAVLink headers
+// clang-format off
+#include "mavlink_custom.h" // Needs to be included before any MAVLink header inclusion
+#include "efc/mavlink.h"
+// clang-format on
+
+#define DECODE_CHANNEL MAVLINK_COMM_0
+
+#define IMU_BATCH_SAMPLES (MAVLINK_MSG_IMU_BATCH_FIELD_GYRO_LEN / 3)
+
+// Next expected sequence number of every system and component
+struct decode_seq {
+    bool valid[256][256];
+    uint8_t next[256][256];
+};
+
+struct decode_stats {
+    uint32_t frames;
+    uint32_t batches;
+    uint32_t samples;
+    uint32_t frames_lost;
+};
+
+static void print_batch(const mavlink_imu_batch_t *batch) {
+    const uint8_t count =
+        batch->count < IMU_BATCH_SAMPLES ? batch->count : IMU_BATCH_SAMPLES;
+
+    for (int i = 0; i < count; i++) {
+        const uint64_t time_usec =
+            batch->time_usec + (uint64_t)i * batch->dt_us;
+
+        printf("%llu,%.6f,%.6f,%.6f,%.5f,%.5f,%.5f\n",
+               (unsigned long long)time_usec,
+               batch->gyro[i * 3 + 0] * batch->gyro_scale,
+               batch->gyro[i * 3 + 1] * batch->gyro_scale,
+               batch->gyro[i * 3 + 2] * batch->gyro_scale,
+               batch->accel[i * 3 + 0] * batch->accel_scale,
+               batch->accel[i * 3 + 1] * batch->accel_scale,
+               batch->accel[i * 3 + 2] * batch->accel_scale);
+    }
+}
+
+int main(int argc, char **argv) {
+    FILE *in = stdin;
+
+    if (argc > 2) {
+        fprintf(stderr, "Usage: %s [file]\n", argv[0]);
+        return 1;
+    }
+
+    if (argc == 2) {
+        in = fopen(argv[1], "rb");
+        if (in == NULL) {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+
+    static struct decode_seq seq;
+    struct decode_stats stats = {0};
+    mavlink_message_t msg;
+    mavlink_status_t status;
+
+    printf("time_us,gyro_x,gyro_y,gyro_z,accel_x,accel_y,accel_z\n");
+
+    int c;
+    while ((c = fgetc(in)) != EOF) {
+        if (!mavlink_parse_char(DECODE_CHANNEL, (uint8_t)c, &msg, &status)) {
+            continue;
+        }
+
+        // Every frame of the sender counts, not only the batches
+        if (seq.valid[msg.sysid][msg.compid]) {
+            stats.frames_lost +=
+                (uint8_t)(msg.seq - seq.next[msg.sysid][msg.compid]);
+        }
+        seq.valid[msg.sysid][msg.compid] = true;
+        seq.next[msg.sysid][msg.compid] = msg.seq + 1;
+        stats.frames++;
+
+        if (msg.msgid != MAVLINK_MSG_ID_IMU_BATCH) {
+            continue;
+        }
+
+        mavlink_imu_batch_t batch;
+        mavlink_msg_imu_batch_decode(&msg, &batch);
+
+        print_batch(&batch);
+
+        stats.batches++;
+        stats.samples += batch.count;
+    }
+
+    if (in != stdin) {
+        fclose(in);
+    }
+
+    fprintf(stderr, "Frames: %u, lost: %u, batches: %u, samples: %u\n",
+            stats.frames, stats.frames_lost, stats.batches, stats.samples);
+
+    return 0;
+}
@@ -74,14 +74,8 @@ ULOG_Error_Type ULOG_{{ struct_name }}_Write(ULOG_Inst_Type *log, const ULOG_{{
 """
 
 SOURCE_TEMPLATE = """#include "{{ header_file }}"
-#include <zephyr/fs/fs.h>
 #include <string.h>
 
-typedef struct __attribute__((packed)) {
-    uint16_t msg_size;
-    uint8_t msg_type;
-} Message_Header_Type;
-
 static const char format_string[] = "{{ struct_name_lower }}:{% for field in fields %}{{ field.type }}{% if field.array_length %}[{{ field.array_length }}]{% endif %} {{ field.name }};{% endfor %}";
 
 ULOG_Error_Type ULOG_{{ struct_name }}_RegisterFormat(ULOG_Inst_Type* log) {
@@ -93,22 +87,14 @@ ULOG_Error_Type ULOG_{{ struct_name }}_RegisterFormat(ULOG_Inst_Type* log) {
         return ULOG_WRONG_PHASE;
     }
 
-    Message_Header_Type header = {
-        .msg_type = 'F',
-        .msg_size = strlen(format_string),
-    };
-
-    int ret = fs_write(&log->file, &header, sizeof(header));
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
+    ULOG_Error_Type status = ULOG_MessageBegin(log, 'F', strlen(format_string));
+    if (status != ULOG_SUCCESS) {
+        return status;
     }
 
-    ret = fs_write(&log->file, format_string, strlen(format_string));
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
-    }
+    ULOG_MessageAppend(log, format_string, strlen(format_string));
 
-    return ULOG_SUCCESS;
+    return ULOG_MessageEnd(log);
 }
 
 ULOG_Error_Type ULOG_{{ struct_name }}_Subscribe(ULOG_Inst_Type *log, uint8_t multi_id, uint16_t *msg_id) {
@@ -122,29 +108,18 @@ ULOG_Error_Type ULOG_{{ struct_name }}_Subscribe(ULOG_Inst_Type *log, uint8_t mu
 
     const char name[] = "{{ struct_name_lower }}";
 
-    Message_Header_Type header = {
-        .msg_type = 'A',
-        .msg_size = sizeof(multi_id) + sizeof(log->next_msg_id) + strlen(name),
-    };
-
-    int ret = fs_write(&log->file, &header, sizeof(header));
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
-    }
-
-    ret = fs_write(&log->file, &multi_id, sizeof(multi_id));
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
+    ULOG_Error_Type status = ULOG_MessageBegin(log, 'A', sizeof(multi_id) + sizeof(log->next_msg_id) + strlen(name));
+    if (status != ULOG_SUCCESS) {
+        return status;
     }
 
-    ret = fs_write(&log->file, &log->next_msg_id, sizeof(log->next_msg_id));
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
-    }
+    ULOG_MessageAppend(log, &multi_id, sizeof(multi_id));
+    ULOG_MessageAppend(log, &log->next_msg_id, sizeof(log->next_msg_id));
+    ULOG_MessageAppend(log, name, strlen(name));
 
-    ret = fs_write(&log->file, name, strlen(name));
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
+    status = ULOG_MessageEnd(log);
+    if (status != ULOG_SUCCESS) {
+        return status;
     }
 
     *msg_id = log->next_msg_id;
@@ -162,33 +137,23 @@ ULOG_Error_Type ULOG_{{ struct_name }}_Write(ULOG_Inst_Type *log, const ULOG_{{
         return ULOG_WRONG_PHASE;
     }
 
-    Message_Header_Type header = {
-        .msg_type = 'D',
-        .msg_size = sizeof(msg_id)
-            {%- for field in fields %}
-            {% if field.array_length %}({{+ field.array_length }} * sizeof({{ field.type }})){% else %}+ sizeof({{ field.type }}){% endif %}
-            {%- endfor %},
-    };
-
     // Write the message metadata
-    int ret = fs_write(&log->file, &header, sizeof(header));
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
+    ULOG_Error_Type status = ULOG_MessageBegin(log, 'D', sizeof(msg_id)
+            {%- for field in fields %}
+            {% if field.array_length %}+ ({{ field.array_length }} * sizeof({{ field.type }})){% else %}+ sizeof({{ field.type }}){% endif %}
+            {%- endfor %});
+    if (status != ULOG_SUCCESS) {
+        return status;
     }
 
-    ret = fs_write(&log->file, &msg_id, sizeof(msg_id));
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
-    }
+    ULOG_MessageAppend(log, &msg_id, sizeof(msg_id));
 
     // Write the message data
     {%- for field in fields %}
-    ret = fs_write(&log->file, {% if field.array_length %}{{ struct_name_lower }}->{{ field.name }}{% else %}&{{ struct_name_lower }}->{{ field.name }}{% endif %}, {% if field.array_length %}{{ field.array_length }} * sizeof({{ field.type }}){% else %}sizeof({{ field.type }}){% endif %});
-    if (ret < 0) {
-        return ULOG_FILESYSTEM_ERROR;
-    }
-    {% endfor %}
-    return ULOG_SUCCESS;
+    ULOG_MessageAppend(log, {% if field.array_length %}{{ struct_name_lower }}->{{ field.name }}{% else %}&{{ struct_name_lower }}->{{ field.name }}{% endif %}, {% if field.array_length %}{{ field.array_length }} * sizeof({{ field.type }}){% else %}sizeof({{ field.type }}){% endif %});
+    {%- endfor %}
+
+    return ULOG_MessageEnd(log);
 }
 
 """